@@ -6,6 +6,12 @@
 #include <limits.h>
 #include "globals.h"
 #include "algorithm_structs_PUBLIC/Path.h"
+#include "pruning.h"
+#include "instrumentation.h"
+#include "alloc_tracker.h"
+#include "static_pools.h"
+#include "fleet.h"
+#include "Dijkstra.h"
 
 // ======================= PRIORITY QUEUE STRUCTURE ======================= //
 
@@ -19,21 +25,60 @@ typedef struct PriorityQueueNode {
     struct PriorityQueueNode *next; /**< Pointer to the next node in the queue */
 } PriorityQueueNode;
 
+// Popped nodes are kept for the next push, so a warmed-up search never allocates
+static PriorityQueueNode *free_nodes = NULL;
+
+#ifdef STATIC_POOLS
+STATIC_POOL_DEFINE(queue_node_pool, "Queue nodes (POOL_QUEUE_NODES)", PriorityQueueNode, POOL_QUEUE_NODES)
+
+// Scratch arrays of the search, one entry per MapPoint a map can hold
+static int distances[POOL_MAP_POINTS];
+static MapPoint *parents[POOL_MAP_POINTS];
+#else
+// Scratch arrays of the search, grown to the number of MapPoints and kept between searches
+static int *distances = NULL;
+static MapPoint **parents = NULL;
+static int scratch_capacity = 0;
+#endif
+
 // ======================= PRIORITY QUEUE FUNCTIONS ======================= //
 
+/**
+ * @brief Takes a node from the free list, allocating one if the list is empty.
+ *
+ * @return PriorityQueueNode* The node, or NULL if the static pool is exhausted.
+ */
+static PriorityQueueNode *take_node() {
+    PriorityQueueNode *node = free_nodes;
+    if (node) {
+        free_nodes = node->next;
+        return node;
+    }
+
+#ifdef STATIC_POOLS
+    return static_pool_take(&queue_node_pool);
+#else
+    node = tracked_malloc(ALLOC_SEARCH, sizeof(PriorityQueueNode));
+    if (!node) {
+        perror("Error: Memory allocation failed for PriorityQueueNode");
+        exit(EXIT_FAILURE);
+    }
+    return node;
+#endif
+}
+
 /**
  * @brief Inserts a MapPoint into the priority queue (sorted by cost).
  *
  * @param head Pointer to the head of the priority queue.
  * @param mapPoint Pointer to the MapPoint being inserted.
  * @param cost The cost associated with reaching this MapPoint.
+ * @return bool True if the MapPoint was queued, false if the static pool is exhausted.
  */
-void push(PriorityQueueNode **head, MapPoint *mapPoint, int cost) {
-    PriorityQueueNode *newNode = malloc(sizeof(PriorityQueueNode));
-    if (!newNode) {
-        perror("Error: Memory allocation failed for PriorityQueueNode");
-        exit(EXIT_FAILURE);
-    }
+bool push(PriorityQueueNode **head, MapPoint *mapPoint, int cost) {
+    INSTRUMENT_FUNCTION(COUNTER_DIJKSTRA_PUSH);
+    PriorityQueueNode *newNode = take_node();
+    if (!newNode) return false;
 
     newNode->mapPoint = mapPoint;
     newNode->cost = cost;
@@ -42,7 +87,7 @@ void push(PriorityQueueNode **head, MapPoint *mapPoint, int cost) {
     if (*head == NULL || cost < (*head)->cost) {
         newNode->next = *head;
         *head = newNode;
-        return;
+        return true;
     }
 
     PriorityQueueNode *current = *head;
@@ -51,6 +96,7 @@ void push(PriorityQueueNode **head, MapPoint *mapPoint, int cost) {
     }
     newNode->next = current->next;
     current->next = newNode;
+    return true;
 }
 
 /**
@@ -60,25 +106,81 @@ void push(PriorityQueueNode **head, MapPoint *mapPoint, int cost) {
  * @return MapPoint* Pointer to the MapPoint with the lowest cost.
  */
 MapPoint *pop(PriorityQueueNode **head) {
+    INSTRUMENT_FUNCTION(COUNTER_DIJKSTRA_POP);
     if (*head == NULL) return NULL;
 
     PriorityQueueNode *temp = *head;
     MapPoint *mapPoint = temp->mapPoint;
     *head = temp->next;
-    free(temp);
+    temp->next = free_nodes;
+    free_nodes = temp;
 
     return mapPoint;
 }
 
 // ======================= DIJKSTRA'S ALGORITHM ======================= //
 
+/**
+ * @brief Grows the scratch arrays of the search to hold the given number of MapPoints.
+ *
+ * @param count Number of MapPoints.
+ */
+static void reserve_scratch(int count) {
+#ifdef STATIC_POOLS
+    // A map never holds more MapPoints than the static arrays
+    (void) count;
+#else
+    if (count <= scratch_capacity) return;
+
+    int *new_distances = tracked_realloc(ALLOC_SEARCH, distances, count * sizeof(int));
+    if (new_distances) distances = new_distances;
+    MapPoint **new_parents = tracked_realloc(ALLOC_SEARCH, parents, count * sizeof(MapPoint *));
+    if (new_parents) parents = new_parents;
+    if (!new_distances || !new_parents) {
+        perror("Error: Failed to allocate search scratch space");
+        exit(EXIT_FAILURE);
+    }
+    scratch_capacity = count;
+#endif
+}
+
+/**
+ * @brief Preallocates the scratch arrays and queue nodes of the search.
+ *
+ * @param map_points Number of MapPoints the search must handle.
+ * @param nodes Number of queue nodes to keep ready.
+ */
+void dijkstra_reserve(int map_points, int nodes) {
+    reserve_scratch(map_points);
+#ifdef STATIC_POOLS
+    // Queue nodes come from their static pool
+    (void) nodes;
+#else
+
+    int ready = 0;
+    for (PriorityQueueNode *node = free_nodes; node; node = node->next) ready++;
+    while (ready++ < nodes) {
+        PriorityQueueNode *node = tracked_malloc(ALLOC_SEARCH, sizeof(PriorityQueueNode));
+        if (!node) {
+            perror("Error: Failed to reserve queue nodes");
+            exit(EXIT_FAILURE);
+        }
+        node->next = free_nodes;
+        free_nodes = node;
+    }
+#endif
+}
+
 /**
  * @brief Implements Dijkstra's Algorithm to find the shortest path to an unexplored MapPoint.
  *
+ * Only the active graph is searched: pruned dead-end branches are never relaxed into.
+ *
  * @param current_map_point Pointer to the starting MapPoint.
- * @return Path* Pointer to the shortest path (caller must free memory).
+ * @param rank Ranks the unexplored MapPoints, NULL takes the closest one.
+ * @return Path* Pointer to the shortest path to the best ranked MapPoint (release with path_free()).
  */
-Path* find_shortest_path_to_mappoint_tbd(MapPoint *current_map_point) {
+static Path* search_shortest_path_to_mappoint_tbd(MapPoint *current_map_point, FrontierRank rank) {
     if (!current_map_point) {
         fprintf(stderr, "Error: current_map_point is NULL\n");
         return NULL;
@@ -90,15 +192,8 @@ Path* find_shortest_path_to_mappoint_tbd(MapPoint *current_map_point) {
         return NULL;
     }
 
-    // Allocate memory for distances and parent tracking arrays
-    int *distances = malloc(num_map_points_all * sizeof(int));
-    MapPoint **parents = malloc(num_map_points_all * sizeof(MapPoint *));
-    if (!distances || !parents) {
-        fprintf(stderr, "Error: Memory allocation failed\n");
-        free(distances);
-        free(parents);
-        return NULL;
-    }
+    // Make room for distances and parent tracking arrays
+    reserve_scratch(num_map_points_all);
 
     // Initialize distances and parent pointers
     for (int i = 0; i < num_map_points_all; i++) {
@@ -108,13 +203,14 @@ Path* find_shortest_path_to_mappoint_tbd(MapPoint *current_map_point) {
 
     // Priority queue initialization
     PriorityQueueNode *pq = NULL;
-    push(&pq, current_map_point, 0);
+    bool queued = push(&pq, current_map_point, 0);
     distances[current_map_point->id] = 0;
 
     MapPoint *closest_tbd = NULL;
+    int best_rank = INT_MAX;
 
     // === DIJKSTRA MAIN LOOP === //
-    while (pq != NULL) {
+    while (pq != NULL && queued) {
         MapPoint *current = pop(&pq);
 
         // Prevent NULL pointer dereference
@@ -122,48 +218,46 @@ Path* find_shortest_path_to_mappoint_tbd(MapPoint *current_map_point) {
             continue;
         }
 
-        // Check if the current MapPoint is unexplored
+        // No MapPoint this far away can outrank the best one found
+        if (distances[current->id] >= best_rank) break;
+
+        // Check if the current MapPoint is unexplored and not taken by other cars of a fleet
         for (int i = 0; i < num_map_points_tbd; i++) {
-            if (map_points_tbd[i] == current) {
-                closest_tbd = current;
+            if (map_points_tbd[i] == current && !fleet_frontier_taken(current)) {
+                int current_rank = rank ? rank(current, distances[current->id]) : distances[current->id];
+                if (current_rank < best_rank) {
+                    best_rank = current_rank;
+                    closest_tbd = current;
+                }
                 break;
             }
         }
-        if (closest_tbd != NULL) break;
+        if (closest_tbd != NULL && !rank) break;
 
         // Expand neighbors (explore paths)
         for (int i = 0; i < current->numberOfPaths; i++) {
             FundamentalPath *path = &current->paths[i];
-            if (!path->end) continue;
+            if (!fp_is_active_edge(path)) continue;
 
+            INSTRUMENT_COUNT(COUNTER_DIJKSTRA_RELAXATION);
             int new_cost = distances[current->id] + path->distance;
-            if (new_cost < distances[path->end->id]) {
-                distances[path->end->id] = new_cost;
-                parents[path->end->id] = current;
-                push(&pq, path->end, new_cost);
+            MapPoint *end = fp_end(path);
+            if (new_cost < distances[end->id]) {
+                distances[end->id] = new_cost;
+                parents[end->id] = current;
+                if (!push(&pq, end, new_cost)) queued = false;
             }
         }
     }
 
-    // No reachable unexplored MapPoint found
-    if (closest_tbd == NULL) {
-        free(distances);
-        free(parents);
-        return NULL;
-    }
+    // Free the nodes left in the queue when the search stopped early
+    while (pq != NULL) pop(&pq);
 
-    // Allocate memory for the shortest path
-    Path *bestPath = malloc(sizeof(Path));
-    if (!bestPath) {
-        free(distances);
-        free(parents);
+    // No reachable unexplored MapPoint found, or the queue ran out of nodes
+    if (closest_tbd == NULL || !queued) {
         return NULL;
     }
 
-    bestPath->start = current_map_point;
-    bestPath->end = closest_tbd;
-    bestPath->totalDistance = distances[closest_tbd->id];
-
     // === PATH RECONSTRUCTION === //
     int pathLength = 0;
     MapPoint *step = closest_tbd;
@@ -171,23 +265,19 @@ Path* find_shortest_path_to_mappoint_tbd(MapPoint *current_map_point) {
     // Count path length
     while (step != current_map_point) {
         if (!parents[step->id]) {
-            free(distances);
-            free(parents);
-            free(bestPath);
             return NULL;
         }
         pathLength++;
         step = parents[step->id];
     }
 
-    // Allocate memory for the route
-    bestPath->route = malloc(pathLength * sizeof(FundamentalPath *));
-    if (!bestPath->route) {
-        free(bestPath);
-        free(distances);
-        free(parents);
+    // Get a path with room for the route
+    Path *bestPath = path_create(current_map_point, closest_tbd, pathLength);
+    if (!bestPath) {
         return NULL;
     }
+    bestPath->totalDistance = distances[closest_tbd->id];
+    bestPath->routeLength = pathLength;
 
     // Backtrack to construct the path
     int pathIndex = pathLength - 1;
@@ -196,15 +286,12 @@ Path* find_shortest_path_to_mappoint_tbd(MapPoint *current_map_point) {
     while (step != current_map_point) {
         MapPoint *prev = parents[step->id];
         if (!prev) {
-            free(bestPath->route);
-            free(bestPath);
-            free(distances);
-            free(parents);
+            path_free(bestPath);
             return NULL;
         }
 
         for (int i = 0; i < prev->numberOfPaths; i++) {
-            if (prev->paths[i].end == step) {
+            if (fp_end(&prev->paths[i]) == step) {
                 bestPath->route[pathIndex] = &prev->paths[i];
                 pathIndex--;
                 break;
@@ -213,9 +300,60 @@ Path* find_shortest_path_to_mappoint_tbd(MapPoint *current_map_point) {
         step = prev;
     }
 
-    // Free temporary arrays
-    free(distances);
-    free(parents);
-
     return bestPath;
 }
+
+/**
+ * @brief Finds the shortest path from a MapPoint to the closest unexplored MapPoint.
+ *
+ * If the MapPoint was pruned from the active graph, the route first leads back into the
+ * active graph and continues from there.
+ *
+ * @param current_map_point Pointer to the starting MapPoint.
+ * @return Path* Pointer to the shortest path (release with path_free()).
+ */
+Path* find_shortest_path_to_mappoint_tbd(MapPoint *current_map_point) {
+    return find_ranked_path_to_mappoint_tbd(current_map_point, NULL);
+}
+
+/**
+ * @brief Finds the shortest path from a MapPoint to the best ranked unexplored MapPoint.
+ *
+ * If the MapPoint was pruned from the active graph, the route first leads back into the
+ * active graph and the frontiers are ranked from there.
+ *
+ * @param current_map_point Pointer to the starting MapPoint.
+ * @param rank Ranks the unexplored MapPoints, NULL takes the closest one.
+ * @return Path* Pointer to the shortest path (release with path_free()).
+ */
+Path* find_ranked_path_to_mappoint_tbd(MapPoint *current_map_point, FrontierRank rank) {
+    if (!current_map_point || current_map_point->active) {
+        return search_shortest_path_to_mappoint_tbd(current_map_point, rank);
+    }
+
+    Path *exit_route = route_to_active_graph(current_map_point);
+    if (!exit_route) return NULL;
+
+    Path *rest = search_shortest_path_to_mappoint_tbd(exit_route->end, rank);
+    if (!rest) {
+        path_free(exit_route);
+        return NULL;
+    }
+
+    // Join both routes into one
+    if (!path_reserve_route(exit_route, exit_route->routeLength + rest->routeLength)) {
+        path_free(exit_route);
+        path_free(rest);
+        return NULL;
+    }
+    for (int i = 0; i < rest->routeLength; i++) {
+        exit_route->route[exit_route->routeLength + i] = rest->route[i];
+    }
+
+    exit_route->routeLength += rest->routeLength;
+    exit_route->totalDistance += rest->totalDistance;
+    exit_route->end = rest->end;
+
+    path_free(rest);
+    return exit_route;
+}
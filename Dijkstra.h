@@ -7,7 +7,15 @@
 #include "algorithm_structs_PUBLIC/MapPoint.h"
 #include "algorithm_structs_PUBLIC/Path.h"
 
+/**
+ * Ranks an unexplored MapPoint reached after driving distance; the lowest rank is chosen.
+ * A rank is never below the distance, so the search can stop once no closer frontier can win.
+ */
+typedef int (*FrontierRank)(const MapPoint *frontier, int distance);
+
 Path* find_shortest_path_to_mappoint_tbd(MapPoint *current_map_point);
+Path* find_ranked_path_to_mappoint_tbd(MapPoint *current_map_point, FrontierRank rank);
+void dijkstra_reserve(int map_points, int nodes);
 
 #endif //DIJKSTRA_H
 
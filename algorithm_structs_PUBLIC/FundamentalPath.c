@@ -8,13 +8,9 @@
 #include "MapPoint.h"
 #include "../direction.h"
 #include "../globals.h"
-
-// ======================= GLOBAL VARIABLES ======================= //
-
-/**
- * @brief Static counter for generating unique FundamentalPath IDs.
- */
-static int fundamental_path_counter = 0;
+#include "../pruning.h"
+#include "../instrumentation.h"
+#include "../alloc_tracker.h"
 
 // ======================= FUNCTION IMPLEMENTATIONS ======================= //
 
@@ -52,7 +48,7 @@ int determine_distance_mappoints(MapPoint *start, MapPoint *end) {
  * @return int The calculated distance.
  */
 int determine_distance_fundamentalpath(FundamentalPath *path) {
-    return determine_distance_mappoints(path->start, path->end);
+    return determine_distance_mappoints(fp_start(path), fp_end(path));
 }
 
 /**
@@ -68,9 +64,12 @@ void initialize_fundamental_path(FundamentalPath *fp, MapPoint *start, int dista
         return;
     }
 
-    fp->id = fundamental_path_counter++;
-    fp->start = start;
-    fp->end = NULL;
+#ifndef COMPACT_MAP
+    fp->id = fundamental_path_counter;
+#endif
+    fundamental_path_counter++;
+    fp_set_start(fp, start);
+    fp_set_end(fp, NULL);
     fp->distance = distance;
     fp->direction = NORTH;  // Default direction (updated later)
 
@@ -92,7 +91,8 @@ FundamentalPath* initialize_fundamental_paths(bool UltraSonicDetection[3]) {
     }
 
     // Allocate memory for the paths
-    FundamentalPath* paths = malloc(pathCount * sizeof(FundamentalPath));
+    INSTRUMENT_COUNT(COUNTER_FUNDAMENTAL_PATH_MALLOC);
+    FundamentalPath* paths = tracked_malloc(ALLOC_FUNDAMENTAL_PATHS, pathCount * sizeof(FundamentalPath));
     if (!paths) {
         perror("Error: Failed to allocate memory for FundamentalPaths");
         exit(EXIT_FAILURE);
@@ -108,9 +108,56 @@ FundamentalPath* initialize_fundamental_paths(bool UltraSonicDetection[3]) {
     return paths;
 }
 
+/**
+ * @brief Closes the unexplored FundamentalPath the car left through when it returns
+ *        to the same MapPoint after turning around in a dead end.
+ *
+ * The path is closed as a self-loop, so it no longer counts as unexplored and is
+ * ignored by the planner.
+ *
+ * @param mp Pointer to the MapPoint the car returned to.
+ */
+static void close_dead_end_path(MapPoint *mp) {
+    // The car drove out and back, so it left through the opposite of its current heading
+    Direction departure = opposite_direction((Direction) current_car.current_orientation);
+
+    for (int i = 0; i < mp->numberOfPaths; ++i) {
+        if (fp_end(&mp->paths[i]) == NULL && mp->paths[i].direction == departure) {
+            fp_set_end(&mp->paths[i], mp);
+            mp->paths[i].distance = 0;
+            mark_map_point_changed(mp);
+            break;
+        }
+    }
+}
+
+/**
+ * @brief Appends a new, already connected FundamentalPath to a MapPoint.
+ *
+ * @param mp Pointer to the MapPoint that owns the new path.
+ * @param end Pointer to the MapPoint the path leads to.
+ * @param direction Direction of the path when leaving mp.
+ * @param distance Length of the path.
+ * @return FundamentalPath* Pointer to the new path inside mp->paths, or NULL if a static
+ *                          pool is exhausted.
+ */
+static FundamentalPath *append_fundamental_path(MapPoint *mp, MapPoint *end, Direction direction, int distance) {
+    // Safely expand the paths array
+    if (!mp_reserve_paths(mp, mp->numberOfPaths + 1)) return NULL;
+
+    FundamentalPath *fp = &mp->paths[mp->numberOfPaths++];
+    initialize_fundamental_path(fp, mp, distance);
+    fp_set_end(fp, end);
+    fp->direction = direction;
+    return fp;
+}
+
 /**
  * @brief Updates or adds a FundamentalPath between two MapPoints.
  *
+ * Afterwards, dead-end leaves that can no longer be part of a route are pruned
+ * from the active graph (see prune_dead_ends()).
+ *
  * @param current Pointer to the current MapPoint.
  * @param former Pointer to the previous MapPoint.
  */
@@ -120,10 +167,22 @@ void update_latest_fundamental_path(MapPoint* current, MapPoint* former) {
         return;
     }
 
+    // Returning to the same MapPoint means the path behind us was a dead end
+    if (current == former) {
+        close_dead_end_path(current);
+        prune_dead_ends(current);
+        return;
+    }
+
     // Determine directions between the two MapPoints
     Direction fc_direction = determine_direction(former, current);
     Direction cf_direction = opposite_direction(fc_direction);
 
+    if (fc_direction == INVALID_DIRECTION) {
+        fprintf(stderr, "Error: MapPoints %d and %d are not aligned\n", former->id, current->id);
+        return;
+    }
+
     FundamentalPath* fc_pointer_fundamental_path = NULL;
     FundamentalPath* cf_pointer_fundamental_path = NULL;
 
@@ -137,28 +196,13 @@ void update_latest_fundamental_path(MapPoint* current, MapPoint* former) {
 
     // If path exists, update its endpoint and distance
     if (fc_pointer_fundamental_path) {
-        fc_pointer_fundamental_path->end = current;
+        fp_set_end(fc_pointer_fundamental_path, current);
         fc_pointer_fundamental_path->distance = determine_distance_fundamentalpath(fc_pointer_fundamental_path);
     } else {
         // Otherwise, create a new path
-        fc_pointer_fundamental_path = malloc(sizeof(FundamentalPath));
-        if (!fc_pointer_fundamental_path) {
-            perror("Error: Failed to allocate memory for FundamentalPath");
-            exit(EXIT_FAILURE);
-        }
-
-        initialize_fundamental_path(fc_pointer_fundamental_path, former, 0);
-        fc_pointer_fundamental_path->end = current;
-        fc_pointer_fundamental_path->direction = fc_direction;
-        fc_pointer_fundamental_path->distance = determine_distance_fundamentalpath(fc_pointer_fundamental_path);
-
-        // Safely expand the former->paths array
-        FundamentalPath *newPaths = realloc(former->paths, (former->numberOfPaths + 1) * sizeof(FundamentalPath));
-        if (!newPaths) {
-            perror("Error: Failed to allocate memory for FundamentalPaths");
-            exit(EXIT_FAILURE);
-        }
-        former->paths = newPaths;
+        fc_pointer_fundamental_path = append_fundamental_path(former, current, fc_direction,
+                                                              determine_distance_mappoints(former, current));
+        if (!fc_pointer_fundamental_path) return;
     }
 
     // === Check if a path already exists from 'current' to 'former' === //
@@ -171,27 +215,17 @@ void update_latest_fundamental_path(MapPoint* current, MapPoint* former) {
 
     // If path exists, update its endpoint and distance
     if (cf_pointer_fundamental_path) {
-        cf_pointer_fundamental_path->end = former;
+        fp_set_end(cf_pointer_fundamental_path, former);
         cf_pointer_fundamental_path->distance = fc_pointer_fundamental_path->distance;
     } else {
         // Otherwise, create a new path
-        cf_pointer_fundamental_path = malloc(sizeof(FundamentalPath));
-        if (!cf_pointer_fundamental_path) {
-            perror("Error: Failed to allocate memory for FundamentalPath");
-            exit(EXIT_FAILURE);
-        }
+        append_fundamental_path(current, former, cf_direction, fc_pointer_fundamental_path->distance);
+    }
 
-        initialize_fundamental_path(cf_pointer_fundamental_path, current, 0);
-        cf_pointer_fundamental_path->end = former;
-        cf_pointer_fundamental_path->direction = cf_direction;
-        cf_pointer_fundamental_path->distance = fc_pointer_fundamental_path->distance;
+    mark_map_point_changed(current);
+    mark_map_point_changed(former);
 
-        // Safely expand the current->paths array
-        FundamentalPath *newPaths = realloc(current->paths, (current->numberOfPaths + 1) * sizeof(FundamentalPath));
-        if (!newPaths) {
-            perror("Error: Failed to allocate memory for FundamentalPaths");
-            exit(EXIT_FAILURE);
-        }
-        current->paths = newPaths;
-    }
+    // Closing an edge may have turned either endpoint into a dead-end leaf
+    prune_dead_ends(current);
+    prune_dead_ends(former);
 }
@@ -2,11 +2,24 @@
 #define FUNDAMENTALPATH_H
 
 #include <stdbool.h>
+#include <stdint.h>
 #include "../direction.h"
 
 struct MapPoint;  // ✅ Forward declaration of MapPoint
 
+// Endpoints are read and written with fp_start(), fp_end() and fp_set_end() (see MapPoint.h)
+#ifdef COMPACT_MAP
+#define FP_NO_END UINT32_MAX  // end_index of an unexplored path
 
+// Compact layout: endpoints are MapPoint IDs, which are their indices in map_points_all,
+// and paths carry no ID of their own
+typedef struct FundamentalPath {
+    uint32_t start_index;
+    uint32_t end_index;
+    signed int distance : 30;
+    unsigned int direction : 2;  // A Direction, never INVALID_DIRECTION
+} FundamentalPath;
+#else
 typedef struct FundamentalPath {
     int id;
     struct MapPoint *start;
@@ -14,6 +27,7 @@ typedef struct FundamentalPath {
     int distance;
     Direction direction;
 } FundamentalPath;
+#endif
 
 // Function prototypes
 void initialize_fundamental_path(FundamentalPath *fp, struct MapPoint *start, int distance);
@@ -9,46 +9,176 @@
 #include "MapPoint.h"
 #include "FundamentalPath.h"
 #include "../direction.h"
+#include "../instrumentation.h"
+#include "../alloc_tracker.h"
+#include "../static_pools.h"
 
-// ======================= GLOBAL VARIABLES ======================= //
+#ifdef STATIC_POOLS
+// Every MapPoint owns one slab of paths, so the path pointers never move
+typedef FundamentalPath PathSlab[POOL_PATHS_PER_MAP_POINT];
+
+STATIC_POOL_DEFINE(map_point_pool, "MapPoints (POOL_MAP_POINTS)", MapPoint, POOL_MAP_POINTS)
+STATIC_POOL_DEFINE(path_slab_pool, "FundamentalPaths (POOL_MAP_POINTS)", PathSlab, POOL_MAP_POINTS)
+#else
+// MapPoints allocated ahead of time, handed out by map_point_create()
+static MapPoint **reserve = NULL;
+static int reserve_count = 0;
+#endif
+
+MapPoint *latest_map_point = NULL;
+
+// ======================= MAPPOINT ALLOCATION ======================= //
+
+/**
+ * @brief Allocates an empty MapPoint without paths.
+ *
+ * @return MapPoint* The MapPoint, or NULL if the static pool is exhausted.
+ */
+static MapPoint *allocate_map_point() {
+    INSTRUMENT_COUNT(COUNTER_MAP_POINT_MALLOC);
+#ifdef STATIC_POOLS
+    MapPoint *mp = static_pool_take(&map_point_pool);
+    if (!mp) return NULL;
+#else
+    MapPoint *mp = tracked_malloc(ALLOC_MAP_POINTS, sizeof(MapPoint));
+    if (!mp) {
+        perror("Memory allocation failed for MapPoint");
+        exit(EXIT_FAILURE);
+    }
+#endif
+    mp->paths = NULL;
+    mp->numberOfPaths = 0;
+    mp->pathCapacity = 0;
+    return mp;
+}
+
+/**
+ * @brief Gets an empty MapPoint, taking a preallocated one if the reserve is not empty.
+ *
+ * @return MapPoint* The MapPoint, to be set up with initialize_map_point(), or NULL if
+ *                   the static pool is exhausted.
+ */
+MapPoint *map_point_create() {
+#ifndef STATIC_POOLS
+    if (reserve_count > 0) return reserve[--reserve_count];
+#endif
+    return allocate_map_point();
+}
+
+/**
+ * @brief Releases a MapPoint and its paths.
+ *
+ * @param mp Pointer to the MapPoint, may be NULL.
+ */
+void map_point_free(MapPoint *mp) {
+    if (!mp) return;
+#ifdef STATIC_POOLS
+    static_pool_give(&path_slab_pool, mp->paths);
+    static_pool_give(&map_point_pool, mp);
+#else
+    free(mp->paths);
+    free(mp);
+#endif
+}
+
+/**
+ * @brief Makes sure a MapPoint can hold the given number of FundamentalPaths.
+ *
+ * @param mp Pointer to the MapPoint.
+ * @param count Number of FundamentalPaths needed.
+ * @return bool True if there is room, false if a static pool is exhausted.
+ */
+bool mp_reserve_paths(MapPoint *mp, int count) {
+    if (count <= mp->pathCapacity) return true;
+
+#ifdef STATIC_POOLS
+    if (count > POOL_PATHS_PER_MAP_POINT) {
+        static_pools_fail("FundamentalPaths per MapPoint (POOL_PATHS_PER_MAP_POINT)");
+        return false;
+    }
+    mp->paths = static_pool_take(&path_slab_pool);
+    if (!mp->paths) return false;
+    mp->pathCapacity = POOL_PATHS_PER_MAP_POINT;
+    return true;
+#else
+
+    // A grid cell has at most four neighbours, so four slots are usually the last growth
+    int capacity = mp->pathCapacity > 0 ? mp->pathCapacity * 2 : 4;
+    while (capacity < count) capacity *= 2;
+
+    INSTRUMENT_COUNT(COUNTER_MAP_POINT_REALLOC);
+    FundamentalPath *paths = tracked_realloc(ALLOC_FUNDAMENTAL_PATHS, mp->paths, capacity * sizeof(FundamentalPath));
+    if (!paths) {
+        perror("Error: Failed to allocate memory for FundamentalPaths");
+        exit(EXIT_FAILURE);
+    }
+    mp->paths = paths;
+    mp->pathCapacity = capacity;
+    return true;
+#endif
+}
 
 /**
- * @brief Static counter for generating unique MapPoint IDs.
+ * @brief Preallocates MapPoints for map_point_create().
+ *
+ * @param count Number of MapPoints to keep ready.
+ * @param paths_each Number of FundamentalPaths each of them can hold.
  */
-static int map_point_counter = 0;
+void map_point_reserve(int count, int paths_each) {
+#ifdef STATIC_POOLS
+    // The pools are static already
+    (void) count;
+    (void) paths_each;
+#else
+    if (count <= reserve_count) return;
+
+    MapPoint **grown = tracked_realloc(ALLOC_MAP_POINTS, reserve, count * sizeof(MapPoint *));
+    if (!grown) {
+        perror("Error: Failed to reserve MapPoints");
+        exit(EXIT_FAILURE);
+    }
+    reserve = grown;
+
+    while (reserve_count < count) {
+        MapPoint *mp = allocate_map_point();
+        mp_reserve_paths(mp, paths_each);
+        reserve[reserve_count++] = mp;
+    }
+#endif
+}
 
 // ======================= MAPPOINT FUNCTIONS ======================= //
 
 /**
  * @brief Initializes a new MapPoint with detected paths and adds it to the global array.
  *
- * @param mp Pointer to the MapPoint structure to be initialized.
+ * @param mp Pointer to the MapPoint structure to be initialized, from map_point_create().
  * @param location The location (x, y) of the MapPoint.
  * @param UltraSonicDetection Boolean array indicating detected paths (forward, left, right).
+ * @return bool True if the MapPoint was added, false if mp is NULL or a static pool is exhausted.
  */
-void initialize_map_point(MapPoint *mp, Location location, bool UltraSonicDetection[3]) {
+bool initialize_map_point(MapPoint *mp, Location location, bool UltraSonicDetection[3]) {
     if (!mp) {
         perror("Error: Null pointer passed to initialize_map_point");
-        return;
+        return false;
     }
 
     // Assign a unique ID and store the location
     mp->id = map_point_counter++;
-    mp->location = location;
+    mp_set_location(mp, location);
+    mp->active = true;
+    mp->prune_exit = -1;
+    mp->changed = false;
 
     // Count the number of detected paths
     int pathCount = 0;
     for (int i = 0; i < 3; ++i) {
         if (UltraSonicDetection[i]) pathCount++;
     }
-    mp->numberOfPaths = pathCount;
 
-    // Allocate memory for paths
-    mp->paths = malloc(pathCount * sizeof(FundamentalPath));
-    if (!mp->paths) {
-        perror("Error: Failed to allocate memory for FundamentalPaths");
-        exit(EXIT_FAILURE);
-    }
+    // Make room for the paths
+    if (!mp_reserve_paths(mp, pathCount)) return false;
+    mp->numberOfPaths = pathCount;
 
     // Initialize detected paths and assign corresponding directions
     int pathIndex = 0;
@@ -73,21 +203,40 @@ void initialize_map_point(MapPoint *mp, Location location, bool UltraSonicDetect
         }
     }
 
+    return append_map_point(mp);
+}
+
+/**
+ * @brief Adds an initialized MapPoint to the global array and, if it has unexplored
+ *        paths, to the "To Be Discovered" list.
+ *
+ * @param mp Pointer to the MapPoint to be added.
+ * @return bool True if the MapPoint was added, false if the static arrays are full.
+ */
+bool append_map_point(MapPoint *mp) {
     // Add to the global MapPoint array, resizing if necessary
     if (num_map_points_all == capacity_map_points_all) {
+#ifdef STATIC_POOLS
+        static_pools_fail("map_points_all (POOL_MAP_POINTS)");
+        return false;
+#endif
         capacity_map_points_all *= 2;
-        map_points_all = realloc(map_points_all, capacity_map_points_all * sizeof(MapPoint));
+        INSTRUMENT_COUNT(COUNTER_MAP_POINT_REALLOC);
+        map_points_all = tracked_realloc(ALLOC_MAP_ARRAYS, map_points_all, capacity_map_points_all * sizeof(MapPoint *));
         if (!map_points_all) {
             perror("Error: Failed to resize map_points_all array");
             exit(EXIT_FAILURE);
         }
     }
     map_points_all[num_map_points_all++] = mp;
+    latest_map_point = mp;
+    mark_map_point_changed(mp);
 
     // If the MapPoint has unexplored paths, add it to the "To Be Discovered" list
     if (mp_has_unexplored_paths(mp)) {
         add_map_point_tbd(mp);
     }
+    return true;
 }
 
 /**
@@ -97,8 +246,13 @@ void initialize_map_point(MapPoint *mp, Location location, bool UltraSonicDetect
  */
 void add_map_point_tbd(MapPoint *mp) {
     if (num_map_points_tbd == capacity_map_points_tbd) {
+#ifdef STATIC_POOLS
+        static_pools_fail("map_points_tbd (POOL_MAP_POINTS)");
+        return;
+#endif
         capacity_map_points_tbd *= 2;
-        map_points_tbd = realloc(map_points_tbd, capacity_map_points_tbd * sizeof(MapPoint));
+        INSTRUMENT_COUNT(COUNTER_MAP_POINT_REALLOC);
+        map_points_tbd = tracked_realloc(ALLOC_MAP_ARRAYS, map_points_tbd, capacity_map_points_tbd * sizeof(MapPoint *));
         if (!map_points_tbd) {
             perror("Error: Failed to expand map_points_tbd array");
             exit(EXIT_FAILURE);
@@ -119,7 +273,7 @@ void add_map_point_tbd(MapPoint *mp) {
  */
 int mp_has_unexplored_paths(MapPoint *mp) {
     for (int i = 0; i < mp->numberOfPaths; i++) {
-        if (mp->paths[i].end == NULL) {
+        if (fp_end(&mp->paths[i]) == NULL) {
             return 1;  // Found an unexplored path
         }
     }
@@ -145,8 +299,8 @@ void print_map_point(const MapPoint *mp) {
 
     for (int i = 0; i < mp->numberOfPaths; ++i) {
         printf("  Path %d -> ", i + 1);
-        if (mp->paths[i].end) {
-            printf("Leads to MapPoint ID: %d, Distance: %d ", mp->paths[i].end->id, mp->paths[i].distance);
+        if (fp_end(&mp->paths[i])) {
+            printf("Leads to MapPoint ID: %d, Distance: %d ", fp_end(&mp->paths[i])->id, mp->paths[i].distance);
         } else {
             printf("Leads to: Unknown ");
         }
@@ -162,6 +316,7 @@ void print_map_point(const MapPoint *mp) {
  * @return MapPoint* Pointer to the existing MapPoint, or NULL if not found.
  */
 MapPoint *check_map_point_already_exists() {
+    INSTRUMENT_FUNCTION(COUNTER_CHECK_MAP_POINT_ALREADY_EXISTS);
     for (int i = 0; i < num_map_points_all; i++) {
         if (map_points_all[i]->location.x == current_car.current_location.x &&
             map_points_all[i]->location.y == current_car.current_location.y) {
@@ -188,35 +343,43 @@ int calculate_distance(Location a, Location b) {
  * @param existing_point Pointer to the existing MapPoint.
  */
 void update_existing_mappoint(MapPoint *existing_point) {
+    MapPoint *latest_point = latest_map_point;
+    if (!latest_point) return;  // A car of a fleet that has not added a MapPoint yet
+
     if (num_map_points_all < 2) {
         printf("Error: Not enough MapPoints to establish a connection.\n");
         return;
     }
 
-    MapPoint *latest_point = map_points_all[num_map_points_all - 1];
-
     // Determine direction and distance
     Direction existing_to_latest = determine_direction(existing_point, latest_point);
     Direction latest_to_existing = opposite_direction(existing_to_latest);
-    int distance = calculate_distance(existing_point->location, latest_point->location);
+    int distance = calculate_distance(mp_location(existing_point), mp_location(latest_point));
+
+    // The latest MapPoint is the existing one itself (dead-end return), nothing to link
+    if (existing_to_latest == INVALID_DIRECTION) {
+        return;
+    }
 
     // Search for existing paths and update if necessary
     int updated = 0;
     for (int i = 0; i < existing_point->numberOfPaths; i++) {
         if (existing_point->paths[i].direction == existing_to_latest) {
-            existing_point->paths[i].end = latest_point;
+            fp_set_end(&existing_point->paths[i], latest_point);
             existing_point->paths[i].distance = distance;
+            mark_map_point_changed(existing_point);
             updated = 1;
             break;
         }
     }
 
     if (!updated) {
-        // Allocate new paths dynamically
-        existing_point->paths = realloc(existing_point->paths, (existing_point->numberOfPaths + 1) * sizeof(FundamentalPath));
+        // Make room for the new path
+        if (!mp_reserve_paths(existing_point, existing_point->numberOfPaths + 1)) return;
         initialize_fundamental_path(&existing_point->paths[existing_point->numberOfPaths], existing_point, distance);
-        existing_point->paths[existing_point->numberOfPaths].end = latest_point;
+        fp_set_end(&existing_point->paths[existing_point->numberOfPaths], latest_point);
         existing_point->paths[existing_point->numberOfPaths].direction = existing_to_latest;
         existing_point->numberOfPaths++;
+        mark_map_point_changed(existing_point);
     }
 }
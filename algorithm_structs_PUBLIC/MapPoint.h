@@ -3,21 +3,163 @@
 
 #include "FundamentalPath.h"
 #include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <limits.h>
 
 typedef struct Location {
     int x;
     int y;
 } Location;
 
+#ifdef COMPACT_MAP
+// Coordinates of a MapPoint in the compact layout, large enough for a 65536 x 65536 grid
+typedef struct PackedLocation {
+    uint16_t x;
+    uint16_t y;
+} PackedLocation;
+
+// Most columns or rows a track can have, checked by track_create()
+#define MP_MAX_GRID_SIDE (UINT16_MAX + 1)
+
+// Compact layout: same fields, narrowed and ordered to leave no padding
+typedef struct MapPoint {
+    FundamentalPath *paths;
+    int id;
+    PackedLocation location;  // Whole locations go through mp_location() and mp_set_location()
+    uint8_t numberOfPaths;
+    uint8_t pathCapacity;
+    int8_t prune_exit;
+    bool active;
+    bool changed;
+} MapPoint;
+
+// Most FundamentalPaths a MapPoint can hold: every path index must fit prune_exit
+#define MP_MAX_PATHS INT8_MAX
+
+_Static_assert(sizeof(FundamentalPath) == 12, "Compact FundamentalPath must stay at 12 bytes");
+_Static_assert(sizeof(MapPoint) <= sizeof(void *) + 16, "Compact MapPoint must stay at a pointer plus 16 bytes");
+#else
 typedef struct MapPoint {
     int id;
     FundamentalPath *paths;
     int numberOfPaths;
+    int pathCapacity;  // Slots allocated in paths
     Location location;
+    bool active;       // False once peeled off as a dead-end leaf (see pruning.h)
+    int prune_exit;    // Index in paths leading back towards the active graph, -1 if none
+    bool changed;      // Queued in map_points_changed since the last map update was published
 } MapPoint;
 
+#define MP_MAX_PATHS INT_MAX
+#endif
+
+// ======================= ACCESSORS ======================= //
+//
+// Endpoints and locations are only read and written through these, so the algorithms work
+// on either layout. In the compact layout an endpoint is resolved through map_points_all,
+// so a MapPoint's ID must be its index there by the time its paths are followed.
+
+extern MapPoint **map_points_all;
+
+/**
+ * @brief Gets the MapPoint a FundamentalPath leaves from.
+ *
+ * @param fp Pointer to the FundamentalPath.
+ * @return MapPoint* The MapPoint owning the path.
+ */
+static inline MapPoint *fp_start(const FundamentalPath *fp) {
+#ifdef COMPACT_MAP
+    return map_points_all[fp->start_index];
+#else
+    return fp->start;
+#endif
+}
+
+/**
+ * @brief Gets the MapPoint a FundamentalPath leads to.
+ *
+ * @param fp Pointer to the FundamentalPath.
+ * @return MapPoint* The MapPoint, or NULL if the path is unexplored.
+ */
+static inline MapPoint *fp_end(const FundamentalPath *fp) {
+#ifdef COMPACT_MAP
+    return fp->end_index == FP_NO_END ? NULL : map_points_all[fp->end_index];
+#else
+    return fp->end;
+#endif
+}
+
+/**
+ * @brief Sets the MapPoint a FundamentalPath leaves from.
+ *
+ * @param fp Pointer to the FundamentalPath.
+ * @param mp Pointer to the MapPoint owning the path, with its ID assigned.
+ */
+static inline void fp_set_start(FundamentalPath *fp, MapPoint *mp) {
+#ifdef COMPACT_MAP
+    fp->start_index = (uint32_t) mp->id;
+#else
+    fp->start = mp;
+#endif
+}
+
+/**
+ * @brief Sets the MapPoint a FundamentalPath leads to.
+ *
+ * @param fp Pointer to the FundamentalPath.
+ * @param mp Pointer to the MapPoint with its ID assigned, NULL for an unexplored path.
+ */
+static inline void fp_set_end(FundamentalPath *fp, MapPoint *mp) {
+#ifdef COMPACT_MAP
+    fp->end_index = mp ? (uint32_t) mp->id : FP_NO_END;
+#else
+    fp->end = mp;
+#endif
+}
+
+/**
+ * @brief Gets the location of a MapPoint.
+ *
+ * @param mp Pointer to the MapPoint.
+ * @return Location The location.
+ */
+static inline Location mp_location(const MapPoint *mp) {
+    return (Location) {mp->location.x, mp->location.y};
+}
+
+/**
+ * @brief Sets the location of a MapPoint.
+ *
+ * @param mp Pointer to the MapPoint.
+ * @param location The location.
+ */
+static inline void mp_set_location(MapPoint *mp, Location location) {
+#ifdef COMPACT_MAP
+    // Tracks wider than MP_MAX_GRID_SIDE are refused when they are created
+    mp->location = (PackedLocation) {(uint16_t) location.x, (uint16_t) location.y};
+#else
+    mp->location = location;
+#endif
+}
+
+// Function to get an empty MapPoint, taken from the reserve if one is left
+MapPoint *map_point_create();
+
+// Function to release a MapPoint and its paths
+void map_point_free(MapPoint *mp);
+
+// Function to make room for the given number of FundamentalPaths in a MapPoint
+bool mp_reserve_paths(MapPoint *mp, int count);
+
+// Function to preallocate MapPoints, each with room for the given number of paths
+void map_point_reserve(int count, int paths_each);
+
 // Function to create a new Map Point
-void initialize_map_point(MapPoint *mp, Location location, bool UltraSonicDetection[3]);
+bool initialize_map_point(MapPoint *mp, Location location, bool UltraSonicDetection[3]);
+
+// Function to add an initialized MapPoint to the global arrays
+bool append_map_point(MapPoint *mp);
 
 // Function that prints the info stored in the map point
 void print_map_point(const MapPoint *mp);
@@ -31,6 +173,13 @@ int mp_has_unexplored_paths(MapPoint *mp);
 // Function to check if a MapPoint with current_location already exists
 MapPoint *check_map_point_already_exists();
 
+// Function to calculate the Manhattan distance between two locations
+int calculate_distance(Location a, Location b);
+
+// MapPoint a revisited MapPoint is linked to: the one the car added last, or for a car of a
+// fleet the one it left last (see fleet.h)
+extern MapPoint *latest_map_point;
+
 // Function to update an existing MapPoint and link it with the most recently added MapPoint
 void update_existing_mappoint(MapPoint *existing_point);
 
@@ -3,7 +3,34 @@
 //
 
 #include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
 #include "Path.h"
+#include "../alloc_tracker.h"
+#include "../static_pools.h"
+
+#ifdef STATIC_POOLS
+/**
+ * @struct RouteBlock
+ * @brief A Path together with the longest route it can hold.
+ */
+typedef struct RouteBlock {
+    Path path;
+    FundamentalPath *route[POOL_ROUTE_LENGTH];
+} RouteBlock;
+
+STATIC_POOL_DEFINE(route_pool, "Routes (POOL_ROUTES)", RouteBlock, POOL_ROUTES)
+#else
+// Released Paths kept with their route arrays for the next replan; path_pool_reserve()
+// raises the limit for explorations that hold more routes at once
+#define PATH_POOL_MIN_SIZE 8
+
+static Path *path_pool_default[PATH_POOL_MIN_SIZE];
+static Path **path_pool = path_pool_default;
+static int path_pool_capacity = PATH_POOL_MIN_SIZE;
+static int path_pool_count = 0;
+static pthread_mutex_t path_pool_lock = PTHREAD_MUTEX_INITIALIZER;  // Routes are freed by pipeline stages
+#endif
 
 /**
  * @brief Initializes a Path structure between two MapPoints.
@@ -25,6 +52,160 @@ void initialize_path(Path *path, MapPoint *start, MapPoint *end) {
 
     // Placeholder for actual path-finding algorithm
     path->route = NULL;
+    path->routeLength = 0;
+    path->routeCapacity = 0;
+}
+
+// ======================= PATH POOL ======================= //
+
+/**
+ * @brief Creates an empty Path, reusing a released one if possible.
+ *
+ * @param start Pointer to the starting MapPoint.
+ * @param end Pointer to the ending MapPoint.
+ * @param route_capacity Number of FundamentalPaths the route must be able to hold.
+ * @return Path* The new Path (release with path_free()), or NULL if memory ran out.
+ */
+Path *path_create(MapPoint *start, MapPoint *end, int route_capacity) {
+#ifdef STATIC_POOLS
+    RouteBlock *block = static_pool_take(&route_pool);
+    if (!block) return NULL;
+
+    Path *path = &block->path;
+    FundamentalPath **route = block->route;
+    int capacity = POOL_ROUTE_LENGTH;
+#else
+    pthread_mutex_lock(&path_pool_lock);
+    Path *path = path_pool_count > 0 ? path_pool[--path_pool_count] : NULL;
+    pthread_mutex_unlock(&path_pool_lock);
+
+    FundamentalPath **route = NULL;
+    int capacity = 0;
+    if (path) {
+        route = path->route;
+        capacity = path->routeCapacity;
+    } else {
+        path = tracked_malloc(ALLOC_ROUTES, sizeof(Path));
+        if (!path) return NULL;
+    }
+#endif
+
+    path->start = start;
+    path->end = end;
+    path->totalDistance = 0;
+    path->route = route;
+    path->routeLength = 0;
+    path->routeCapacity = capacity;
+    if (!path_reserve_route(path, route_capacity)) {
+        path_free(path);
+        return NULL;
+    }
+    return path;
+}
+
+/**
+ * @brief Makes sure the route of a Path can hold the given number of FundamentalPaths.
+ *
+ * @param path Pointer to the Path.
+ * @param capacity Number of FundamentalPaths needed.
+ * @return bool True if the route is large enough, false if memory ran out.
+ */
+bool path_reserve_route(Path *path, int capacity) {
+    if (capacity <= path->routeCapacity) return true;
+
+#ifdef STATIC_POOLS
+    static_pools_fail("Route length (POOL_ROUTE_LENGTH)");
+    return false;
+#else
+
+    int grown = path->routeCapacity > 0 ? path->routeCapacity : 8;
+    while (grown < capacity) grown *= 2;
+
+    FundamentalPath **route = tracked_realloc(ALLOC_ROUTES, path->route, grown * sizeof(FundamentalPath *));
+    if (!route) return false;
+    path->route = route;
+    path->routeCapacity = grown;
+    return true;
+#endif
+}
+
+/**
+ * @brief Releases a Path created with path_create(), keeping it for reuse if the pool has room.
+ *
+ * @param path Pointer to the Path, may be NULL.
+ */
+void path_free(Path *path) {
+    if (!path) return;
+
+#ifdef STATIC_POOLS
+    // The Path is the first member of its block
+    static_pool_give(&route_pool, path);
+#else
+    pthread_mutex_lock(&path_pool_lock);
+    if (path_pool_count < path_pool_capacity) {
+        path_pool[path_pool_count++] = path;
+        path = NULL;
+    }
+    pthread_mutex_unlock(&path_pool_lock);
+
+    if (path) {
+        free(path->route);
+        free(path);
+    }
+#endif
+}
+
+/**
+ * @brief Fills the pool with Paths whose routes already hold the given number of steps.
+ *
+ * The pool keeps up to count released Paths from then on.
+ *
+ * @param count Number of Paths to keep ready.
+ * @param route_capacity Route length each of them can hold.
+ */
+void path_pool_reserve(int count, int route_capacity) {
+#ifdef STATIC_POOLS
+    // The routes are static already
+    (void) count;
+    (void) route_capacity;
+#else
+    pthread_mutex_lock(&path_pool_lock);
+    if (count > path_pool_capacity) {
+        Path **pool = tracked_realloc(ALLOC_ROUTES, path_pool == path_pool_default ? NULL : path_pool,
+                                      count * sizeof(Path *));
+        if (!pool) {
+            perror("Error: Failed to reserve routes");
+            exit(EXIT_FAILURE);
+        }
+        if (path_pool == path_pool_default) {
+            for (int i = 0; i < path_pool_count; i++) pool[i] = path_pool_default[i];
+        }
+        path_pool = pool;
+        path_pool_capacity = count;
+    }
+
+    // Grow the pooled Paths first, then add new ones until there are enough
+    for (int i = 0; i < path_pool_count && i < count; i++) {
+        if (!path_reserve_route(path_pool[i], route_capacity)) {
+            perror("Error: Failed to reserve routes");
+            exit(EXIT_FAILURE);
+        }
+    }
+    while (path_pool_count < count) {
+        Path *path = tracked_malloc(ALLOC_ROUTES, sizeof(Path));
+        if (path) {
+            path->route = NULL;
+            path->routeLength = 0;
+            path->routeCapacity = 0;
+        }
+        if (!path || !path_reserve_route(path, route_capacity)) {
+            perror("Error: Failed to reserve routes");
+            exit(EXIT_FAILURE);
+        }
+        path_pool[path_pool_count++] = path;
+    }
+    pthread_mutex_unlock(&path_pool_lock);
+#endif
 }
 
 /**
@@ -8,10 +8,18 @@ typedef struct Path {
     MapPoint *start;
     MapPoint *end;
     FundamentalPath **route;
+    int routeLength;    // Number of FundamentalPaths in route
+    int routeCapacity;  // Slots allocated in route
     int totalDistance;
 } Path;
 
 void initialize_path(Path *path, MapPoint *start, MapPoint *end);
+
+// Paths are recycled: create them with path_create() and release them with path_free()
+Path *path_create(MapPoint *start, MapPoint *end, int route_capacity);
+bool path_reserve_route(Path *path, int capacity);
+void path_free(Path *path);
+void path_pool_reserve(int count, int route_capacity);
 void printPathResult(const Path *path);
 
 #endif // PATH_H
@@ -0,0 +1,107 @@
+#include <stdlib.h>
+#include <stdatomic.h>
+#include "alloc_tracker.h"
+
+// ======================= ALLOCATION TRACKER ======================= //
+//
+// Counts the heap allocations of every subsystem, and per tick those made by the thread
+// that runs the ticks. Frees are not tracked: the question is whether a tick reaches the
+// allocator at all, not how much memory is live.
+
+/**
+ * @struct AllocTotals
+ * @brief Allocations and bytes requested by one subsystem.
+ */
+typedef struct AllocTotals {
+    atomic_ulong calls;
+    atomic_ulong bytes;
+} AllocTotals;
+
+static AllocTotals totals[ALLOC_SUBSYSTEM_COUNT];
+
+// Allocations of the calling thread since its current tick began
+static _Thread_local unsigned long tick_allocations = 0;
+
+// Per-tick summary, owned by the thread that runs the ticks
+static unsigned long ticks_seen = 0;
+static unsigned long ticks_allocating = 0;
+static unsigned long max_tick_allocations = 0;
+static unsigned long last_allocating_tick = 0;
+
+/**
+ * @brief Counts an allocation.
+ *
+ * @param subsystem Owner of the allocation.
+ * @param size Bytes requested.
+ */
+static void count_allocation(AllocSubsystem subsystem, size_t size) {
+    atomic_fetch_add_explicit(&totals[subsystem].calls, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&totals[subsystem].bytes, size, memory_order_relaxed);
+    tick_allocations++;
+}
+
+/**
+ * @brief malloc() that is counted for a subsystem.
+ *
+ * @param subsystem Owner of the allocation.
+ * @param size Bytes to allocate.
+ * @return void* The allocation, or NULL on failure.
+ */
+void *tracked_malloc(AllocSubsystem subsystem, size_t size) {
+    count_allocation(subsystem, size);
+    return malloc(size);
+}
+
+/**
+ * @brief realloc() that is counted for a subsystem.
+ *
+ * @param subsystem Owner of the allocation.
+ * @param ptr Allocation to resize, NULL for a new one.
+ * @param size New size in bytes.
+ * @return void* The resized allocation, or NULL on failure (ptr is left untouched).
+ */
+void *tracked_realloc(AllocSubsystem subsystem, void *ptr, size_t size) {
+    count_allocation(subsystem, size);
+    return realloc(ptr, size);
+}
+
+/**
+ * @brief Starts the allocation count of a tick on the calling thread.
+ */
+void alloc_tracker_begin_tick() {
+    tick_allocations = 0;
+}
+
+/**
+ * @brief Closes the allocation count of a tick.
+ *
+ * @param tick Number of the tick that just ended.
+ */
+void alloc_tracker_end_tick(unsigned long tick) {
+    ticks_seen++;
+    if (tick_allocations > 0) {
+        ticks_allocating++;
+        last_allocating_tick = tick;
+        if (tick_allocations > max_tick_allocations) max_tick_allocations = tick_allocations;
+    }
+}
+
+/**
+ * @brief Prints the allocations per subsystem and per tick.
+ *
+ * @param out Stream to write to.
+ */
+void alloc_tracker_report(FILE *out) {
+    static const char *names[ALLOC_SUBSYSTEM_COUNT] = {
+        "map_points", "fundamental_paths", "map_arrays", "routes", "search", "map_versions", "occupancy"
+    };
+
+    fprintf(out, "%-18s %10s %12s\n", "Allocations", "calls", "bytes");
+    for (int i = 0; i < ALLOC_SUBSYSTEM_COUNT; i++) {
+        fprintf(out, "%-18s %10lu %12lu\n", names[i],
+                atomic_load(&totals[i].calls), atomic_load(&totals[i].bytes));
+    }
+    fprintf(out, "%lu of %lu ticks allocated, at most %lu times", ticks_allocating, ticks_seen, max_tick_allocations);
+    if (ticks_allocating > 0) fprintf(out, "; last at tick %lu", last_allocating_tick);
+    fputc('\n', out);
+}
@@ -0,0 +1,25 @@
+#ifndef ALLOC_TRACKER_H
+#define ALLOC_TRACKER_H
+
+#include <stdio.h>
+#include <stddef.h>
+
+// Owners of the heap allocations made by the exploration
+typedef enum {
+    ALLOC_MAP_POINTS,           // MapPoint structs
+    ALLOC_FUNDAMENTAL_PATHS,    // paths arrays of the MapPoints
+    ALLOC_MAP_ARRAYS,           // map_points_all, map_points_tbd, map_points_changed, all_fundamental_paths
+    ALLOC_ROUTES,               // Path structs and their route arrays
+    ALLOC_SEARCH,               // Dijkstra and pruning scratch space
+    ALLOC_MAP_VERSIONS,         // Nodes and trie levels of map versions (see map_version.h)
+    ALLOC_OCCUPANCY,            // Occupancy grid cells (see occupancy.h)
+    ALLOC_SUBSYSTEM_COUNT
+} AllocSubsystem;
+
+void *tracked_malloc(AllocSubsystem subsystem, size_t size);
+void *tracked_realloc(AllocSubsystem subsystem, void *ptr, size_t size);
+void alloc_tracker_begin_tick();
+void alloc_tracker_end_tick(unsigned long tick);
+void alloc_tracker_report(FILE *out);
+
+#endif // ALLOC_TRACKER_H
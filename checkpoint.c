@@ -0,0 +1,650 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <stdatomic.h>
+#include "checkpoint.h"
+#include "globals.h"
+#include "map_snapshot.h"
+#include "noise.h"
+#include "occupancy.h"
+
+// ======================= CHECKPOINT FORMAT ======================= //
+//
+// A checkpoint holds everything the exploration needs to continue exactly where it was
+// interrupted. Pointers are stored as indices into map_points_all (-1 for NULL):
+//
+//   CheckpointHeader | CheckpointNode[node_count] | CheckpointEdge[edge_count]
+//   | int32 tbd[tbd_count] | int32 changed[changed_count] | CheckpointStep[route_length]
+//   | int8 occupancy[occupancy_height][occupancy_width]
+//
+// The control loop only serializes the state into a buffer; the background writer thread
+// does the file I/O. A newer checkpoint replaces one the writer has not picked up yet.
+
+/**
+ * @struct CheckpointHeader
+ * @brief Car, counters and exploration progress at the time of the checkpoint.
+ */
+typedef struct CheckpointHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t grid_hash;             /**< track_grid_hash() of the explored track */
+    uint64_t ticks;
+    uint64_t sensor_noise_key, sensor_noise_counter;    /**< Noise streams, see noise.h */
+    uint64_t motor_noise_key, motor_noise_counter;
+    uint64_t occupancy_readings;
+
+    int32_t car_x, car_y, car_orientation;
+    int32_t start_x, start_y, start_orientation;
+    uint8_t sensors[3];
+    uint8_t map_changed;
+    uint8_t leaving_former;
+    uint8_t phase;
+    uint8_t cursor_finished;
+    uint8_t reserved;
+    int32_t former_map_point;
+
+    int32_t map_point_counter, fundamental_path_counter;
+    int32_t num_all_fundamental_paths;
+    int32_t capacity_map_points_tbd, capacity_map_points_all;
+    int32_t capacity_all_fundamental_paths, capacity_map_points_changed;
+
+    uint32_t node_count, edge_count, tbd_count, changed_count;
+
+    // Route being driven in PHASE_ROUTE
+    int32_t route_start, route_end, route_distance;
+    uint32_t route_length;
+    int32_t cursor_step, cursor_cell;
+
+    // Occupancy grid, 0 x 0 if none was taken (see occupancy.h)
+    int32_t occupancy_width, occupancy_height;
+} CheckpointHeader;
+
+/**
+ * @struct CheckpointNode
+ * @brief A MapPoint with its paths stored as a range of edges.
+ */
+typedef struct CheckpointNode {
+    int32_t id;
+    int32_t x, y;
+    uint32_t first_edge, edge_count;
+    int32_t prune_exit;
+    uint8_t active, changed, reserved[2];
+} CheckpointNode;
+
+/**
+ * @struct CheckpointEdge
+ * @brief A FundamentalPath, with its end stored as a MapPoint index.
+ */
+typedef struct CheckpointEdge {
+    int32_t end;
+    int32_t distance;
+    int32_t direction;
+} CheckpointEdge;
+
+/**
+ * @struct CheckpointStep
+ * @brief A route step, stored as the MapPoint index and path index of the FundamentalPath.
+ */
+typedef struct CheckpointStep {
+    int32_t map_point;
+    int32_t path_index;
+} CheckpointStep;
+
+/**
+ * @struct CheckpointBuffer
+ * @brief A serialized checkpoint waiting to be written.
+ */
+typedef struct CheckpointBuffer {
+    unsigned char *data;
+    size_t size, capacity;
+} CheckpointBuffer;
+
+// ======================= SERIALIZATION ======================= //
+
+/**
+ * @brief Appends bytes to a checkpoint buffer, growing it if necessary.
+ *
+ * @param buffer Pointer to the buffer.
+ * @param data Pointer to the bytes.
+ * @param size Number of bytes.
+ */
+static void buffer_append(CheckpointBuffer *buffer, const void *data, size_t size) {
+    if (buffer->size + size > buffer->capacity) {
+        size_t capacity = buffer->capacity ? buffer->capacity : 1024;
+        while (buffer->size + size > capacity) capacity *= 2;
+
+        unsigned char *temp = realloc(buffer->data, capacity);
+        if (!temp) {
+            perror("Error: Failed to grow checkpoint buffer");
+            exit(EXIT_FAILURE);
+        }
+        buffer->data = temp;
+        buffer->capacity = capacity;
+    }
+    memcpy(buffer->data + buffer->size, data, size);
+    buffer->size += size;
+}
+
+/**
+ * @brief Converts a MapPoint pointer to its index in map_points_all.
+ *
+ * @param mp Pointer to the MapPoint, may be NULL.
+ * @return int32_t The index, -1 for NULL.
+ */
+static int32_t map_point_index(const MapPoint *mp) {
+    return mp ? mp->id : -1;
+}
+
+/**
+ * @brief Serializes the global exploration state and the tick state into a new buffer.
+ *
+ * @param state Pointer to the exploration state.
+ * @return CheckpointBuffer* The serialized checkpoint (caller must free memory).
+ */
+static CheckpointBuffer *serialize_checkpoint(const ExplorationState *state) {
+    CheckpointBuffer *buffer = calloc(1, sizeof(CheckpointBuffer));
+    if (!buffer) {
+        perror("Error: Failed to allocate checkpoint buffer");
+        exit(EXIT_FAILURE);
+    }
+
+    const Path *route = state->phase == PHASE_ROUTE ? state->route : NULL;
+
+    CheckpointHeader header = {0};
+    header.magic = CHECKPOINT_MAGIC;
+    header.version = CHECKPOINT_VERSION;
+    header.grid_hash = track_grid_hash();
+    header.ticks = state->ticks;
+    header.sensor_noise_key = sensor_noise.key;
+    header.sensor_noise_counter = sensor_noise.counter;
+    header.motor_noise_key = motor_noise.key;
+    header.motor_noise_counter = motor_noise.counter;
+    header.car_x = current_car.current_location.x;
+    header.car_y = current_car.current_location.y;
+    header.car_orientation = current_car.current_orientation;
+    header.start_x = start.x;
+    header.start_y = start.y;
+    header.start_orientation = start_orientation;
+    for (int i = 0; i < 3; i++) header.sensors[i] = ultrasonic_sensors[i];
+    header.map_changed = map_changed;
+    header.leaving_former = leaving_former;
+    header.phase = (uint8_t) state->phase;
+    header.cursor_finished = state->cursor.finished;
+    header.former_map_point = map_point_index(former_map_point);
+    header.map_point_counter = map_point_counter;
+    header.fundamental_path_counter = fundamental_path_counter;
+    header.num_all_fundamental_paths = num_all_fundamental_paths;
+    header.capacity_map_points_tbd = capacity_map_points_tbd;
+    header.capacity_map_points_all = capacity_map_points_all;
+    header.capacity_all_fundamental_paths = capacity_all_fundamental_paths;
+    header.capacity_map_points_changed = capacity_map_points_changed;
+    header.node_count = (uint32_t) num_map_points_all;
+    header.tbd_count = (uint32_t) num_map_points_tbd;
+    header.changed_count = (uint32_t) num_map_points_changed;
+    for (int i = 0; i < num_map_points_all; i++) {
+        header.edge_count += map_points_all[i]->numberOfPaths;
+    }
+    header.route_start = route ? map_point_index(route->start) : -1;
+    header.route_end = route ? map_point_index(route->end) : -1;
+    header.route_distance = route ? route->totalDistance : 0;
+    header.route_length = route && route->route ? (uint32_t) route->routeLength : 0;
+    header.cursor_step = state->cursor.step;
+    header.cursor_cell = state->cursor.cell;
+    if (occupancy_grid.cells) {
+        header.occupancy_width = occupancy_grid.width;
+        header.occupancy_height = occupancy_grid.height;
+        header.occupancy_readings = occupancy_grid.readings;
+    }
+    buffer_append(buffer, &header, sizeof(header));
+
+    // MapPoint ids are their index in map_points_all
+    uint32_t edge = 0;
+    for (int i = 0; i < num_map_points_all; i++) {
+        MapPoint *mp = map_points_all[i];
+        CheckpointNode node = {mp->id, mp->location.x, mp->location.y, edge, (uint32_t) mp->numberOfPaths,
+                               mp->prune_exit, mp->active, mp->changed, {0, 0}};
+        buffer_append(buffer, &node, sizeof(node));
+        edge += mp->numberOfPaths;
+    }
+    for (int i = 0; i < num_map_points_all; i++) {
+        MapPoint *mp = map_points_all[i];
+        for (int j = 0; j < mp->numberOfPaths; j++) {
+            FundamentalPath *fp = &mp->paths[j];
+            CheckpointEdge saved = {map_point_index(fp_end(fp)), fp->distance, fp->direction};
+            buffer_append(buffer, &saved, sizeof(saved));
+        }
+    }
+
+    for (int i = 0; i < num_map_points_tbd; i++) {
+        int32_t index = map_point_index(map_points_tbd[i]);
+        buffer_append(buffer, &index, sizeof(index));
+    }
+    for (int i = 0; i < num_map_points_changed; i++) {
+        int32_t index = map_point_index(map_points_changed[i]);
+        buffer_append(buffer, &index, sizeof(index));
+    }
+
+    for (uint32_t i = 0; i < header.route_length; i++) {
+        FundamentalPath *fp = route->route[i];
+        CheckpointStep step = {map_point_index(fp_start(fp)), (int32_t) (fp - fp_start(fp)->paths)};
+        buffer_append(buffer, &step, sizeof(step));
+    }
+
+    // The fused sensor readings depend on the evidence gathered so far; rows are stored without padding
+    for (int y = 0; y < header.occupancy_height; y++) {
+        buffer_append(buffer, occupancy_grid.cells + (size_t) y * (size_t) occupancy_grid.stride,
+                      (size_t) occupancy_grid.width);
+    }
+
+    return buffer;
+}
+
+/**
+ * @brief Frees a checkpoint buffer.
+ *
+ * @param buffer Pointer to the buffer, may be NULL.
+ */
+static void free_buffer(CheckpointBuffer *buffer) {
+    if (!buffer) return;
+    free(buffer->data);
+    free(buffer);
+}
+
+/**
+ * @brief Serializes the current exploration state into a checkpoint in memory.
+ *
+ * @param state Pointer to the exploration state.
+ * @param size Pointer to store the size of the checkpoint in bytes in.
+ * @return unsigned char* The checkpoint (caller must free memory).
+ */
+unsigned char *checkpoint_serialize(const ExplorationState *state, size_t *size) {
+    CheckpointBuffer *buffer = serialize_checkpoint(state);
+    unsigned char *data = buffer->data;
+    *size = buffer->size;
+    free(buffer);
+    return data;
+}
+
+// ======================= BACKGROUND WRITER ======================= //
+
+// Single-slot mailbox between control loop (producer) and writer (consumer)
+static _Atomic(CheckpointBuffer *) pending = NULL;
+
+static pthread_t writer_thread;
+static sem_t writer_wakeup;
+static atomic_bool writer_running = false;
+static const char *checkpoint_file = NULL;
+static unsigned long checkpoint_interval = 0;
+
+/**
+ * @brief Writes a checkpoint next to its destination and renames it into place, so an
+ *        interrupted write never replaces the previous checkpoint.
+ *
+ * @param buffer Pointer to the serialized checkpoint.
+ * @return bool True if the checkpoint was written, false otherwise.
+ */
+static bool write_checkpoint_file(const CheckpointBuffer *buffer) {
+    size_t length = strlen(checkpoint_file);
+    char *temporary = malloc(length + 5);
+    if (!temporary) {
+        perror("Error: Failed to allocate checkpoint filename");
+        exit(EXIT_FAILURE);
+    }
+    memcpy(temporary, checkpoint_file, length);
+    memcpy(temporary + length, ".tmp", 5);
+
+    FILE *file = fopen(temporary, "wb");
+    bool written = file && fwrite(buffer->data, 1, buffer->size, file) == buffer->size &&
+                   fflush(file) == 0 && fsync(fileno(file)) == 0;
+    if (file && fclose(file) != 0) written = false;
+    if (written && rename(temporary, checkpoint_file) != 0) written = false;
+    if (!written) {
+        perror("Error: Failed to write checkpoint");
+        remove(temporary);
+    }
+
+    free(temporary);
+    return written;
+}
+
+/**
+ * @brief Main loop of the writer thread: writes the newest pending checkpoint.
+ *
+ * @param arg Unused.
+ * @return void* Always NULL.
+ */
+static void *writer_main(void *arg) {
+    (void) arg;
+
+    while (1) {
+        sem_wait(&writer_wakeup);
+
+        CheckpointBuffer *buffer = atomic_exchange(&pending, NULL);
+        if (buffer) {
+            write_checkpoint_file(buffer);
+            free_buffer(buffer);
+        }
+
+        if (!atomic_load(&writer_running) && !atomic_load(&pending)) break;
+    }
+    return NULL;
+}
+
+/**
+ * @brief Starts writing a checkpoint every interval ticks on a background thread.
+ *
+ * @param filename Path of the checkpoint file.
+ * @param interval Number of ticks between checkpoints.
+ */
+void checkpoint_writer_start(const char *filename, unsigned long interval) {
+    if (!filename || interval == 0 || atomic_load(&writer_running)) return;
+
+    if (sem_init(&writer_wakeup, 0, 0) != 0) {
+        perror("Error: Failed to create checkpoint semaphore");
+        exit(EXIT_FAILURE);
+    }
+
+    checkpoint_file = filename;
+    checkpoint_interval = interval;
+    atomic_store(&writer_running, true);
+    if (pthread_create(&writer_thread, NULL, writer_main, NULL) != 0) {
+        perror("Error: Failed to start checkpoint thread");
+        exit(EXIT_FAILURE);
+    }
+}
+
+/**
+ * @brief Writes the last pending checkpoint and stops the background thread.
+ */
+void checkpoint_writer_stop() {
+    if (!atomic_load(&writer_running)) return;
+
+    atomic_store(&writer_running, false);
+    sem_post(&writer_wakeup);
+    pthread_join(writer_thread, NULL);
+    sem_destroy(&writer_wakeup);
+
+    free_buffer(atomic_exchange(&pending, NULL));
+}
+
+/**
+ * @brief Hands the state after a tick to the background writer if a checkpoint is due.
+ *
+ * Only the serialization happens on the calling thread; it never waits for the writer.
+ *
+ * @param state Pointer to the exploration state.
+ */
+void checkpoint_after_tick(const ExplorationState *state) {
+    if (!atomic_load(&writer_running) || state->ticks % checkpoint_interval != 0) return;
+
+    // A checkpoint the writer has not picked up yet is outdated now
+    free_buffer(atomic_exchange(&pending, serialize_checkpoint(state)));
+    sem_post(&writer_wakeup);
+}
+
+// ======================= RESUMING ======================= //
+
+/**
+ * @brief Reads the next bytes of a checkpoint.
+ *
+ * @param data Start of the checkpoint.
+ * @param size Size of the checkpoint in bytes.
+ * @param offset Pointer to the read position, advanced past the bytes.
+ * @param out Pointer to copy the bytes to.
+ * @param length Number of bytes.
+ * @return bool True if the bytes were available, false if the checkpoint is truncated.
+ */
+static bool read_bytes(const unsigned char *data, size_t size, size_t *offset, void *out, size_t length) {
+    if (length > size - *offset) return false;
+    memcpy(out, data + *offset, length);
+    *offset += length;
+    return true;
+}
+
+/**
+ * @brief Converts a stored MapPoint index back to a pointer.
+ *
+ * @param adopted Array of the restored MapPoints.
+ * @param count Number of restored MapPoints.
+ * @param index The stored index, -1 for NULL.
+ * @param out Pointer to store the MapPoint pointer in.
+ * @return bool True if the index is valid, false otherwise.
+ */
+static bool resolve_index(MapPoint **adopted, uint32_t count, int32_t index, MapPoint **out) {
+    if (index < -1 || index >= (int32_t) count) return false;
+    *out = index >= 0 ? adopted[index] : NULL;
+    return true;
+}
+
+/**
+ * @brief Restores the MapPoints, lists and route of a checkpoint into the global state.
+ *
+ * @param header Pointer to the checkpoint header.
+ * @param data Start of the checkpoint.
+ * @param size Size of the checkpoint in bytes.
+ * @param offset Read position just after the header.
+ * @param state Pointer to the exploration state to restore the route into.
+ * @return bool True if the checkpoint was complete and consistent, false otherwise.
+ */
+static bool restore_map(const CheckpointHeader *header, const unsigned char *data, size_t size,
+                        size_t offset, ExplorationState *state) {
+    uint32_t count = header->node_count;
+    MapPoint **adopted = calloc(count ? count : 1, sizeof(MapPoint *));
+    CheckpointNode *nodes = malloc((count ? count : 1) * sizeof(CheckpointNode));
+    if (!adopted || !nodes) {
+        perror("Error: Failed to allocate checkpoint MapPoints");
+        exit(EXIT_FAILURE);
+    }
+
+    bool valid = true;
+    for (uint32_t i = 0; i < count && valid; i++) {
+        valid = read_bytes(data, size, &offset, &nodes[i], sizeof(CheckpointNode)) &&
+                nodes[i].id == (int32_t) i && nodes[i].first_edge <= header->edge_count &&
+                nodes[i].edge_count <= header->edge_count - nodes[i].first_edge &&
+                nodes[i].edge_count <= (uint32_t) MP_MAX_PATHS &&
+                nodes[i].prune_exit >= -1 && nodes[i].prune_exit < (int32_t) nodes[i].edge_count;
+        if (!valid) break;
+
+        // A MapPoint that does not fit the static pools makes the checkpoint unusable
+        adopted[i] = map_point_create();
+        valid = adopted[i] && mp_reserve_paths(adopted[i], (int) nodes[i].edge_count);
+        if (!valid) break;
+
+        MapPoint *mp = adopted[i];
+        mp->id = nodes[i].id;
+        mp->numberOfPaths = (int) nodes[i].edge_count;
+        mp_set_location(mp, (Location) {nodes[i].x, nodes[i].y});
+        mp->active = nodes[i].active != 0;
+        mp->prune_exit = nodes[i].prune_exit;
+        mp->changed = nodes[i].changed != 0;
+    }
+
+    for (uint32_t i = 0; i < count && valid; i++) {
+        for (uint32_t j = 0; j < nodes[i].edge_count && valid; j++) {
+            CheckpointEdge edge;
+            MapPoint *end = NULL;
+            FundamentalPath *fp = &adopted[i]->paths[j];
+            valid = read_bytes(data, size, &offset, &edge, sizeof(edge)) &&
+                    edge.direction >= NORTH && edge.direction <= WEST &&
+                    resolve_index(adopted, count, edge.end, &end);
+            if (!valid) break;
+
+#ifndef COMPACT_MAP
+            // Path IDs are not stored, since the compact layout has none; number them in order
+            fp->id = (int) (nodes[i].first_edge + j);
+#endif
+            fp_set_start(fp, adopted[i]);
+            fp_set_end(fp, end);
+            fp->distance = edge.distance;
+            fp->direction = (Direction) edge.direction;
+            add_fundamental_path(fp);
+        }
+    }
+
+    for (uint32_t i = 0; i < count; i++) {
+        if (valid) {
+            map_points_all[num_map_points_all++] = adopted[i];
+        } else {
+            map_point_free(adopted[i]);
+        }
+    }
+    latest_map_point = num_map_points_all > 0 ? map_points_all[num_map_points_all - 1] : NULL;
+
+    for (uint32_t i = 0; i < header->tbd_count && valid; i++) {
+        int32_t index;
+        MapPoint *mp;
+        valid = read_bytes(data, size, &offset, &index, sizeof(index)) && resolve_index(adopted, count, index, &mp);
+        if (valid) map_points_tbd[num_map_points_tbd++] = mp;
+    }
+    for (uint32_t i = 0; i < header->changed_count && valid; i++) {
+        int32_t index;
+        MapPoint *mp;
+        valid = read_bytes(data, size, &offset, &index, sizeof(index)) && resolve_index(adopted, count, index, &mp);
+        if (valid) map_points_changed[num_map_points_changed++] = mp;
+    }
+
+    valid = valid && resolve_index(adopted, count, header->former_map_point, &former_map_point);
+
+    // The route being driven, whose steps must fit in the remaining bytes
+    if (valid && header->phase == PHASE_ROUTE) {
+        valid = header->route_length <= (size - offset) / sizeof(CheckpointStep);
+    }
+    if (valid && header->phase == PHASE_ROUTE) {
+        Path *route = path_create(NULL, NULL, (int) header->route_length);
+        if (!route) {
+            perror("Error: Failed to allocate checkpoint route");
+            exit(EXIT_FAILURE);
+        }
+        route->routeLength = (int) header->route_length;
+        route->totalDistance = header->route_distance;
+        valid = resolve_index(adopted, count, header->route_start, &route->start) &&
+                resolve_index(adopted, count, header->route_end, &route->end);
+        for (uint32_t i = 0; i < header->route_length && valid; i++) {
+            CheckpointStep step;
+            MapPoint *mp;
+            valid = read_bytes(data, size, &offset, &step, sizeof(step)) &&
+                    resolve_index(adopted, count, step.map_point, &mp) && mp &&
+                    step.path_index >= 0 && step.path_index < mp->numberOfPaths;
+            if (valid) route->route[i] = &mp->paths[step.path_index];
+        }
+
+        state->route = route;
+        state->cursor.path = route;
+    }
+
+    // The occupancy grid, which has to fit the current track
+    if (valid && header->occupancy_height > 0) {
+        valid = header->occupancy_width == track_width() && header->occupancy_height == track_height();
+        if (valid) occupancy_reserve();
+        for (int y = 0; y < header->occupancy_height && valid; y++) {
+            valid = read_bytes(data, size, &offset, occupancy_grid.cells + (size_t) y * (size_t) occupancy_grid.stride,
+                               (size_t) occupancy_grid.width);
+        }
+        occupancy_grid.readings = header->occupancy_readings;
+    }
+
+    free(nodes);
+    free(adopted);
+    return valid && offset == size;
+}
+
+/**
+ * @brief Restores the full exploration state from a checkpoint in memory.
+ *
+ * Replaces the current global state. The grid of the checkpointed track must be loaded.
+ *
+ * @param data Start of the checkpoint.
+ * @param size Size of the checkpoint in bytes.
+ * @param state Pointer to the exploration state to restore.
+ * @return bool True if the checkpoint was restored, false otherwise.
+ */
+bool checkpoint_restore(const unsigned char *data, size_t size, ExplorationState *state) {
+    CheckpointHeader header;
+    size_t offset = 0;
+    if (!read_bytes(data, size, &offset, &header, sizeof(header)) ||
+        header.magic != CHECKPOINT_MAGIC || header.version != CHECKPOINT_VERSION ||
+        header.grid_hash != track_grid_hash() || header.phase > PHASE_DONE ||
+        header.capacity_map_points_tbd < (int32_t) header.tbd_count ||
+        header.capacity_map_points_all < (int32_t) header.node_count ||
+        header.capacity_map_points_changed < (int32_t) header.changed_count ||
+        header.capacity_all_fundamental_paths < 1) {
+        return false;
+    }
+
+    // Restore the capacities first, so the arrays hold everything that is restored
+    free_globals();
+    initialize_globals();
+    if (!resize_globals(header.capacity_map_points_tbd, header.capacity_map_points_all,
+                        header.capacity_map_points_changed, header.capacity_all_fundamental_paths)) {
+        return false;
+    }
+
+    exploration_state_init(state);
+    state->phase = (ExplorationPhase) header.phase;
+    state->ticks = header.ticks;
+    state->cursor.step = header.cursor_step;
+    state->cursor.cell = header.cursor_cell;
+    state->cursor.finished = header.cursor_finished != 0;
+
+    if (!restore_map(&header, data, size, offset, state)) {
+        exploration_state_free(state);
+        free_globals();
+        initialize_globals();
+        return false;
+    }
+
+    current_car.current_location = (Location) {header.car_x, header.car_y};
+    current_car.current_orientation = (char) header.car_orientation;
+    start = (Location) {header.start_x, header.start_y};
+    start_orientation = (Direction) header.start_orientation;
+    for (int i = 0; i < 3; i++) ultrasonic_sensors[i] = header.sensors[i] != 0;
+    map_changed = header.map_changed != 0;
+    leaving_former = header.leaving_former != 0;
+    sensor_noise = (NoiseStream) {header.sensor_noise_key, header.sensor_noise_counter};
+    motor_noise = (NoiseStream) {header.motor_noise_key, header.motor_noise_counter};
+    map_point_counter = header.map_point_counter;
+    fundamental_path_counter = header.fundamental_path_counter;
+    num_all_fundamental_paths = header.num_all_fundamental_paths;
+    return true;
+}
+
+/**
+ * @brief Restores the full exploration state from a checkpoint of the current track.
+ *
+ * Must be called on freshly initialized globals and grid. The exploration then continues
+ * exactly as it would have without the interruption.
+ *
+ * @param filename Path of the checkpoint file.
+ * @param state Pointer to the exploration state to restore.
+ * @return bool True if the checkpoint was restored, false otherwise.
+ */
+bool checkpoint_load(const char *filename, ExplorationState *state) {
+    FILE *file = filename ? fopen(filename, "rb") : NULL;
+    if (!file) return false;
+
+    // Checkpoints are small, read them in one go
+    fseek(file, 0, SEEK_END);
+    long length = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    if (length <= 0) {
+        fclose(file);
+        return false;
+    }
+
+    size_t size = (size_t) length;
+    unsigned char *data = malloc(size);
+    if (!data) {
+        perror("Error: Failed to allocate checkpoint");
+        exit(EXIT_FAILURE);
+    }
+    bool read = fread(data, 1, size, file) == size;
+    fclose(file);
+
+    bool restored = read && checkpoint_restore(data, size, state);
+    free(data);
+    return restored;
+}
@@ -0,0 +1,27 @@
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "exploration.h"
+
+#define CHECKPOINT_MAGIC   0x504B4354u   // "TCKP" in little-endian
+#define CHECKPOINT_VERSION 4u
+
+// Start writing a checkpoint every interval ticks on a background thread
+void checkpoint_writer_start(const char *filename, unsigned long interval);
+
+// Write the last pending checkpoint and stop the background thread
+void checkpoint_writer_stop();
+
+// Hand the state after a tick to the background writer if a checkpoint is due
+void checkpoint_after_tick(const ExplorationState *state);
+
+// Restore the full exploration state from a checkpoint of the current track
+bool checkpoint_load(const char *filename, ExplorationState *state);
+
+// In-memory checkpoints, e.g. the keyframes of a recording
+unsigned char *checkpoint_serialize(const ExplorationState *state, size_t *size);
+bool checkpoint_restore(const unsigned char *data, size_t size, ExplorationState *state);
+
+#endif // CHECKPOINT_H
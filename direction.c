@@ -35,6 +35,19 @@ Direction turn_right(Direction dir) {
     return (dir + 1) % 4;
 }
 
+/**
+ * @brief Gives the direction a car facing an orientation drives after a move.
+ *
+ * @param orientation Direction the car faces.
+ * @param move MOVE_FORWARD, MOVE_LEFT or MOVE_RIGHT.
+ * @return Direction The direction of the move.
+ */
+Direction move_direction(Direction orientation, Move move) {
+    if (move == MOVE_LEFT) return turn_left(orientation);
+    if (move == MOVE_RIGHT) return turn_right(orientation);
+    return orientation;
+}
+
 /**
  * @brief Converts a direction enum to a human-readable string.
  *
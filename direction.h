@@ -15,6 +15,14 @@ typedef enum {
     INVALID_DIRECTION = -1  // Define an invalid direction
 } Direction;
 
+// Moves the car can make after reading its sensors
+typedef enum {
+    MOVE_FORWARD,
+    MOVE_LEFT,      // Rotate left, then move forward
+    MOVE_RIGHT,     // Rotate right, then move forward
+    MOVE_U_TURN     // Rotate twice without moving
+} Move;
+
 #include "algorithm_structs_PUBLIC/FundamentalPath.h"  // Include this to ensure Direction is defined
 
 // Function prototypes
@@ -22,6 +30,7 @@ Direction determine_direction(MapPoint *start, MapPoint *end);
 Direction opposite_direction(Direction dir);
 Direction turn_left(Direction dir);
 Direction turn_right(Direction dir);
+Direction move_direction(Direction orientation, Move move);
 const char* direction_to_string(Direction dir);
 char direction_to_symbol(Direction dir);
 
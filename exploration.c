@@ -11,12 +11,28 @@
 
 #include "Dijkstra.h"
 #include "navigate.h"
+#include "lap.h"
+#include "planner.h"
+#include "checkpoint.h"
+#include "telemetry.h"
+#include "replay.h"
+#include "instrumentation.h"
+#include "latency.h"
+#include "trace.h"
+#include "perf_counters.h"
+#include "alloc_tracker.h"
+#include "static_pools.h"
+#include "pruning.h"
+#include "scoreboard.h"
+#include "policy.h"
+#include "map_version.h"
+#include "occupancy.h"
+#include "fleet.h"
+#include "lookahead.h"
 #include "algorithm_structs_PUBLIC/Path.h"
 
 #include "globals.h"
 
-int checkValidTrackCompletion();
-
 MapPoint *former_map_point = NULL; // Keeps track of the previous MapPoint
 
 /**
@@ -34,140 +50,487 @@ int is_map_point() {
 }
 
 /**
- * @brief Decides the next move based on ultrasonic sensor readings.
+ * @brief Chooses the next move with the current exploration policy (see policy.h).
+ *
+ * The MapPoint the last map update recorded or revisited is where the car stands.
+ *
+ * @param sensors Sensor readings (0: forward, 1: left, 2: right).
+ * @param orientation Direction the car faces.
+ * @return Move The chosen move.
  */
-void decide_next_move() {
-    update_ultrasonic_sensors();
-
-    if (ultrasonic_sensors[0]) {
-        move_forward(&current_car);
-        return;
-    }
+Move choose_next_move(const bool sensors[3], Direction orientation) {
+    const MapPoint *at = map_changed ? former_map_point : NULL;
+    Move move = exploration_policy->choose_move(sensors, orientation, at);
+    if (fleet_active && at) move = fleet_claim_move(sensors, orientation, at, move);  // See fleet.h
+    return move;
+}
 
-    // If forward is blocked, try turning
-    if (ultrasonic_sensors[1]) {
-        rotate_left(&current_car);
-        move_forward(&current_car);
-    } else if (ultrasonic_sensors[2]) {
-        rotate_right(&current_car);
-        move_forward(&current_car);
-    } else {
-        // No valid moves, perform a U-turn
-        rotate_right(&current_car);
-        rotate_right(&current_car);
+/**
+ * @brief Executes a move with the car.
+ *
+ * @param move The move to execute.
+ */
+void apply_move(Move move) {
+    switch (move) {
+        case MOVE_FORWARD:
+            move_forward(&current_car);
+            break;
+        case MOVE_LEFT:
+            rotate_left(&current_car);
+            move_forward(&current_car);
+            break;
+        case MOVE_RIGHT:
+            rotate_right(&current_car);
+            move_forward(&current_car);
+            break;
+        case MOVE_U_TURN:
+            rotate_right(&current_car);
+            rotate_right(&current_car);
+            break;
     }
 }
 
 /**
- * @brief Selects the next unexplored MapPoint.
+ * @brief Decides the next move based on ultrasonic sensor readings.
  *
- * @return MapPoint* Pointer to the next MapPoint to explore, or NULL if none remain.
+ * @return Move The move that was executed.
  */
-MapPoint *select_next_mappoint() {
-    if (num_map_points_tbd == 0) return NULL;
+Move decide_next_move() {
+    PerfSample sensors_sample;
+    perf_site_begin(&sensors_sample);
+    update_ultrasonic_sensors();
+    perf_site_end(PERF_SITE_SENSORS_DECISION, &sensors_sample);
+    Move move = choose_next_move(ultrasonic_sensors, (Direction) current_car.current_orientation);
+    apply_move(move);
+    return move;
+}
 
-    for (int i = 0; i < num_map_points_tbd; i++) {
-        if (map_points_tbd[i] != NULL) {
-            return map_points_tbd[i];
+/**
+ * @brief Plans the route to the best ranked unexplored MapPoint.
+ *
+ * The planner thread only knows the closest one, so a ranked query is searched here.
+ *
+ * @param current Pointer to the MapPoint the car is at.
+ * @param rank Ranks the unexplored MapPoints, NULL takes the closest one (see Dijkstra.h).
+ * @return Path* Route to the unexplored MapPoint (release with path_free()), NULL if there is none.
+ */
+Path *route_to_ranked_frontier(MapPoint *current, FrontierRank rank) {
+    uint64_t query_start = telemetry_enabled || trace_enabled ? telemetry_now() : 0;
+    INSTRUMENT_PHASE_BEGIN(TIMER_REPLANNING);
+    Path *resulting_path;
+    if (!rank && planner_is_running()) {
+        resulting_path = planner_route_to_mappoint_tbd(current);
+        if (trace_enabled) trace_span("planner_query", query_start, telemetry_now(), "map_point", current->id);
+    } else {
+        uint64_t search_start = latency_enabled || trace_enabled ? telemetry_now() : 0;
+        PerfSample search_sample;
+        perf_site_begin(&search_sample);
+        resulting_path = find_ranked_path_to_mappoint_tbd(current, rank);
+        perf_site_end(PERF_SITE_SHORTEST_PATH, &search_sample);
+        if (latency_enabled || trace_enabled) {
+            uint64_t search_end = telemetry_now();
+            if (latency_enabled) latency_record(LATENCY_SHORTEST_PATH, search_end - search_start);
+            trace_span("dijkstra", search_start, search_end, "map_point", current->id);
         }
     }
-    return NULL;
+    INSTRUMENT_PHASE_END(TIMER_REPLANNING);
+    if (telemetry_enabled) {
+        telemetry_record((TelemetryEvent) {.type = TELEMETRY_PLANNER_QUERY, .decision = TELEMETRY_NO_DECISION,
+                                           .x = current->location.x,
+                                           .y = current->location.y,
+                                           .value = resulting_path ? resulting_path->totalDistance : -1,
+                                           .value2 = (int32_t) (telemetry_now() - query_start)});
+    }
+    return resulting_path;
+}
+
+/**
+ * @brief Plans the route to the closest unexplored MapPoint.
+ *
+ * The planner thread never makes us wait: without a route yet, the car keeps exploring
+ * and asks again at the next MapPoint.
+ *
+ * @param current Pointer to the MapPoint the car is at.
+ * @return Path* Route to the closest unexplored MapPoint (release with path_free()),
+ *               NULL if there is none.
+ */
+Path *route_to_closest_frontier(MapPoint *current) {
+    return route_to_ranked_frontier(current, NULL);
 }
 
 /**
  * @brief Handles navigation when revisiting an already discovered MapPoint.
  *
  * @param existing_point Pointer to the existing MapPoint.
+ * @return Path* Route to the next unexplored MapPoint if every path here is explored
+ *               (release with path_free()), NULL otherwise.
  */
-void existing_map_point_algorithm(MapPoint* existing_point) {
+Path *existing_map_point_algorithm(MapPoint* existing_point) {
     update_existing_mappoint(existing_point);
+    telemetry_record((TelemetryEvent) {.type = TELEMETRY_MAP_POINT_UPDATED, .decision = TELEMETRY_NO_DECISION,
+                                       .x = existing_point->location.x,
+                                       .y = existing_point->location.y, .value = existing_point->id});
 
     // Ensure a FundamentalPath exists between the former and current MapPoint
     if (former_map_point) {
         update_latest_fundamental_path(existing_point, former_map_point);
     }
+    former_map_point = existing_point;
 
-    // Check for unexplored paths at the current MapPoint
+    // Check for unexplored paths at the current MapPoint that no other car of a fleet claimed
     int unexplored_paths = 0;
     for (int i = 0; i < existing_point->numberOfPaths; i++) {
-        if (existing_point->paths[i].end == NULL) {
+        if (fp_end(&existing_point->paths[i]) == NULL &&
+            !fleet_path_claimed(existing_point, (Direction) existing_point->paths[i].direction)) {
             unexplored_paths++;
         }
     }
 
     check_mappoints_tbd();
 
+    // With unexplored paths left, the regular move decision takes one of them
     if (unexplored_paths > 0) {
-        decide_next_move();
-    } else {
-        // Find shortest path to the next unexplored MapPoint
-        Path *resulting_path = find_shortest_path_to_mappoint_tbd(existing_point);
+        return NULL;
+    }
+
+    // Every path here is explored, the policy picks where to explore next
+    Path *resulting_path = exploration_policy->route_to_frontier(existing_point);
 
-        if (resulting_path) {
-            navigate_path(resulting_path);
+    // The car continues from the end of the route
+    if (resulting_path) {
+        former_map_point = resulting_path->end;
+        if (fleet_active) fleet_claim_frontier(resulting_path->end);
+    }
+    return resulting_path;
+}
+
+// ======================= EXPLORATION TICK ======================= //
+//
+// One tick: the sensors are read, the map is updated with the readings, a route is driven
+// if the planner returned one, and finally the next move is chosen and executed. The steps
+// are separate functions so the staged pipeline (pipeline.h) can run them on different threads.
+
+bool map_changed = false;      // The last map update recorded a MapPoint
+bool leaving_former = false;   // The car is about to leave former_map_point
+bool presize_explorations = false;
+
+/**
+ * @brief Updates the map with the current sensor readings.
+ *
+ * @return Path* Route the car has to drive before its next move (release with
+ *               path_free()), or NULL if none.
+ */
+Path *process_sensor_readings() {
+    check_mappoints_tbd();
 
-            // Free allocated memory
-            free(resulting_path->route);
-            free(resulting_path);
+    // Check if the current position is a MapPoint
+    map_changed = false;
+    if (!is_map_point()) return NULL;
+
+    map_changed = true;
+    MapPoint *existing_point = check_map_point_already_exists();
+
+    if (existing_point) {
+        uint64_t algorithm_start = latency_enabled || trace_enabled ? telemetry_now() : 0;
+        Path *route = existing_map_point_algorithm(existing_point);
+        if (latency_enabled || trace_enabled) {
+            uint64_t algorithm_end = telemetry_now();
+            if (latency_enabled) latency_record(LATENCY_EXISTING_MAP_POINT, algorithm_end - algorithm_start);
+            trace_span("existing_map_point", algorithm_start, algorithm_end, "map_point", existing_point->id);
         }
+        return route;
     }
+
+    // Allocate memory for a new MapPoint
+    uint64_t creation_start = trace_enabled ? telemetry_now() : 0;
+    MapPoint *new_map_point = map_point_create();
+    if (!new_map_point) {
+        map_changed = false;
+        return NULL;
+    }
+
+    // Set location based on the car's current position
+    Location location = {current_car.current_location.x, current_car.current_location.y};
+
+    // Initialize new MapPoint with sensor data, a full static pool stops exploration after this tick
+    if (!initialize_map_point(new_map_point, location, ultrasonic_sensors)) {
+        map_changed = false;
+        return NULL;
+    }
+    telemetry_record((TelemetryEvent) {.type = TELEMETRY_MAP_POINT_CREATED, .decision = TELEMETRY_NO_DECISION,
+                                       .x = location.x, .y = location.y,
+                                       .value = new_map_point->id});
+
+    // Link with the previous MapPoint if it exists
+    if (former_map_point) {
+        update_latest_fundamental_path(new_map_point, former_map_point);
+    }
+
+    // Update the former MapPoint tracker
+    former_map_point = new_map_point;
+    if (trace_enabled) trace_span("new_map_point", creation_start, telemetry_now(), "map_point", new_map_point->id);
+    return NULL;
 }
 
 /**
- * @brief Starts the autonomous exploration of the track.
+ * @brief Records the car's position relative to the former MapPoint before it moves.
  */
-void start_exploration() {
-    while (1) {
-        print_grid(current_car);
+void exploration_before_move() {
+    leaving_former = former_map_point &&
+                     former_map_point->location.x == current_car.current_location.x &&
+                     former_map_point->location.y == current_car.current_location.y;
+}
+
+/**
+ * @brief Publishes the map changes of the tick after the car moved.
+ *
+ * The planner thread can start on the changed map while the car drives on, including
+ * the unexplored path the car just took.
+ */
+void exploration_after_move() {
+    if (leaving_former) mark_map_point_changed(former_map_point);
+    if (live_map_version.num_nodes > 0) map_version_sync_live();
+    planner_publish_changes();
+}
+
+/**
+ * @brief Checks if exploration is complete after the car moved.
+ *
+ * @return bool True if exploration should stop.
+ */
+bool exploration_complete() {
+    // Without room for the map there is nothing left to explore with
+    if (static_pools_exhausted()) {
+        return true;
+    }
 
+    return exploration_policy->is_complete();
+}
+
+/**
+ * @brief Checks if every recorded MapPoint is fully explored.
+ *
+ * @return bool True if the map has no unexplored FundamentalPath left.
+ */
+bool exploration_map_complete() {
+    return num_map_points_tbd == 0 && num_all_fundamental_paths != 0 && num_map_points_all > 1;
+}
+
+/**
+ * @brief Records the MapPoint the car stopped at, so the path driven last is part of the map.
+ *
+ * Exploration stops as soon as the car is back at the start, before the readings there
+ * are processed; without this the lap is never closed in the saved map.
+ */
+void exploration_record_final_map_point() {
+    update_ultrasonic_sensors();
+
+    path_free(process_sensor_readings());
+}
+
+// ======================= STEPPING ======================= //
+//
+// The tick split into non-blocking steps: every call to exploration_tick() moves the car by
+// at most one cell, so a caller can interleave many simulations (see simulation.h). A route
+// returned by the planner is driven over several ticks before the next move is decided.
+
+/**
+ * @brief Prepares the state of a new tick-by-tick exploration.
+ *
+ * @param state Pointer to the state to initialize.
+ */
+void exploration_state_init(ExplorationState *state) {
+    state->phase = PHASE_EXPLORE;
+    state->route = NULL;
+    route_cursor_init(&state->cursor, NULL);
+    state->ticks = 0;
+    state->last_move = -1;
+    state->route_started = 0;
+    state->scoreboard = NULL;
+}
+
+/**
+ * @brief Frees the route still owned by an exploration state.
+ *
+ * @param state Pointer to the state.
+ */
+void exploration_state_free(ExplorationState *state) {
+    if (state->route) {
+        path_free(state->route);
+        state->route = NULL;
+    }
+}
+
+/**
+ * @brief Decides and executes the next move, then checks for completion.
+ *
+ * @param state Pointer to the exploration state.
+ * @param status Status to report if exploration continues.
+ * @param decision Pointer to store the executed move in.
+ * @return ExplorationStatus The status of the tick.
+ */
+static ExplorationStatus finish_tick(ExplorationState *state, ExplorationStatus status, uint8_t *decision) {
+    // Decide the next movement
+    exploration_before_move();
+    *decision = (uint8_t) decide_next_move();
+    exploration_after_move();
+
+    if (exploration_complete()) {
+        state->phase = PHASE_DONE;
+        return EXPLORATION_DONE;
+    }
+    return status;
+}
+
+/**
+ * @brief Runs the phases of one tick.
+ *
+ * @param state Pointer to the exploration state.
+ * @param decision Pointer to store the executed move in, if any.
+ * @return ExplorationStatus What the car did during the tick.
+ */
+static ExplorationStatus advance_tick(ExplorationState *state, uint8_t *decision) {
+    if (state->phase == PHASE_EXPLORE) {
         // Update sensor readings before each move
+        PerfSample sensors_sample;
+        perf_site_begin(&sensors_sample);
         update_ultrasonic_sensors();
-        check_mappoints_tbd();
-
-        // Check if the current position is a MapPoint
-        if (is_map_point()) {
-            MapPoint *existing_point = check_map_point_already_exists();
-
-            if (existing_point) {
-                existing_map_point_algorithm(existing_point);
-            } else {
-                // Allocate memory for a new MapPoint
-                MapPoint *new_map_point = malloc(sizeof(MapPoint));
-                if (!new_map_point) {
-                    perror("Memory allocation failed for MapPoint");
-                    exit(EXIT_FAILURE);
-                }
-
-                // Set location based on the car's current position
-                Location location = {current_car.current_location.x, current_car.current_location.y};
-
-                // Initialize new MapPoint with sensor data
-                initialize_map_point(new_map_point, location, ultrasonic_sensors);
-
-                // Link with the previous MapPoint if it exists
-                if (former_map_point) {
-                    update_latest_fundamental_path(new_map_point, former_map_point);
-                }
-
-                // Update the former MapPoint tracker
-                former_map_point = new_map_point;
-            }
+        perf_site_end(PERF_SITE_SENSORS_TICK, &sensors_sample);
+
+        Path *resulting_path = process_sensor_readings();
+        if (!resulting_path) {
+            return finish_tick(state, map_changed ? EXPLORATION_AT_MAP_POINT : EXPLORATION_RUNNING, decision);
         }
 
-        // Decide the next movement
-        decide_next_move();
+        state->route = resulting_path;
+        route_cursor_init(&state->cursor, resulting_path);
+        state->phase = PHASE_ROUTE;
+        state->route_started = trace_enabled ? telemetry_now() : 0;
+        if (state->scoreboard) state->scoreboard->replans++;
+    }
 
-        // Stop when exploration is complete
-        if (num_map_points_tbd == 0 && num_all_fundamental_paths != 0 && num_map_points_all > 1) {
-            break;
-        }
+    if (navigate_path_step(&state->cursor)) {
+        return EXPLORATION_REPLANNING;
+    }
+
+    // A route spans several ticks, so it is traced once it is finished
+    if (trace_enabled && state->route_started != 0) {
+        trace_span("navigate_path", state->route_started, telemetry_now(), "distance", state->route->totalDistance);
+    }
+    state->route_started = 0;
+
+    // The route is finished, continue exploring from its end
+    exploration_state_free(state);
+    state->phase = PHASE_EXPLORE;
+    return finish_tick(state, EXPLORATION_RUNNING, decision);
+}
+
+/**
+ * @brief Advances the exploration of the current track by one tick.
+ *
+ * @param state Pointer to the exploration state.
+ * @return ExplorationStatus What the car did during the tick.
+ */
+ExplorationStatus exploration_tick(ExplorationState *state) {
+    if (state->phase == PHASE_DONE) return EXPLORATION_DONE;
+    if (static_pools_exhausted()) {
+        state->phase = PHASE_DONE;
+        return EXPLORATION_DONE;
+    }
+    INSTRUMENT_PHASE(TIMER_EXPLORATION);
+    state->ticks++;
+    telemetry_set_tick((uint32_t) state->ticks);
+
+    uint8_t decision = TELEMETRY_NO_DECISION;
+    ExplorationStatus status = advance_tick(state, &decision);
+    state->last_move = decision == TELEMETRY_NO_DECISION ? -1 : decision;
+    if (state->scoreboard) scoreboard_after_tick(state->scoreboard);
+
+    if (telemetry_enabled) {
+        telemetry_record((TelemetryEvent) {
+            .type = TELEMETRY_TICK, .decision = decision,
+            .orientation = (uint8_t) current_car.current_orientation,
+            .sensors = (uint8_t) (ultrasonic_sensors[0] | ultrasonic_sensors[1] << 1 | ultrasonic_sensors[2] << 2),
+            .x = current_car.current_location.x, .y = current_car.current_location.y,
+            .value = status});
+    }
+    return status;
+}
+
+/**
+ * @brief Starts the autonomous exploration of the track.
+ */
+void start_exploration() {
+    ExplorationState state;
+    exploration_state_init(&state);
+    run_exploration(&state);
+}
 
-        if (checkValidTrackCompletion()) {
+/**
+ * @brief Runs the exploration from the given state until it is complete.
+ *
+ * @param state Pointer to the exploration state, e.g. restored from a checkpoint.
+ */
+void run_exploration(ExplorationState *state) {
+    while (1) {
+        if (state->phase == PHASE_EXPLORE) print_grid(current_car);
+
+        uint64_t tick_start = latency_enabled || trace_enabled ? telemetry_now() : 0;
+        recording_before_tick(state);
+        PerfSample tick_sample;
+        perf_site_begin(&tick_sample);
+        alloc_tracker_begin_tick();
+        ExplorationStatus status = exploration_tick(state);
+        perf_site_end(PERF_SITE_TICK, &tick_sample);
+        alloc_tracker_end_tick(state->ticks);
+        recording_after_tick(state, status);
+        if (latency_enabled || trace_enabled) {
+            uint64_t tick_end = telemetry_now();
+            if (latency_enabled) latency_record_tick(state->ticks, tick_end - tick_start);
+            trace_span("tick", tick_start, tick_end, "tick", (int64_t) state->ticks);
+        }
+        if (status == EXPLORATION_DONE) {
             break;
         }
+        checkpoint_after_tick(state);
+        instrumentation_poll_signal(stderr);
 
-        usleep(500000);  // Delay for realistic movement speed
+        if (status == EXPLORATION_REPLANNING) {
+            print_grid();  // Visualize movement on the grid
+        } else {
+            usleep(500000);  // Delay for realistic movement speed
+        }
     }
+    exploration_state_free(state);
+}
+
+/**
+ * @brief Preallocates everything the exploration of a map of the given size needs, so
+ *        that no tick reaches the heap allocator.
+ *
+ * The map arrays belong to the current map, the free lists of MapPoints, routes and map
+ * versions to every map explored on this thread, so simulations stepped side by side pass
+ * their number.
+ *
+ * @param max_map_points Upper bound on the MapPoints of the map, e.g. the cells on the track.
+ * @param maps Number of maps explored side by side, 1 for a single exploration.
+ */
+void exploration_presize(int max_map_points, int maps) {
+    // A grid cell has at most four neighbours, so a MapPoint has at most four paths
+    int max_paths = 4 * max_map_points;
+
+    reserve_globals(max_map_points, max_paths);
+    map_point_reserve(maps * max_map_points - num_map_points_all, 4);
+    dijkstra_reserve(max_map_points, max_paths + 1);
+    lap_reserve(max_map_points);
+    pruning_reserve(max_map_points);
+
+    // A route out of a pruned branch is joined with the search from there, while every other
+    // map holds its own route
+    path_pool_reserve(3 + maps, 2 * max_map_points);
+    lookahead_reserve(max_map_points, maps);
+
+    if (occupancy_mode != OCCUPANCY_OFF) occupancy_reserve();
 }
 
 /**
@@ -1,9 +1,69 @@
 #ifndef TRACK_EXPLORATION_H
 #define TRACK_EXPLORATION_H
 
+#include <stdint.h>
 #include "globals.h"
+#include "algorithm_structs_PUBLIC/Path.h"
+#include "navigate.h"
+#include "Dijkstra.h"
+
+// Result of advancing the exploration by one tick
+typedef enum {
+    EXPLORATION_RUNNING,        // The car moved between MapPoints
+    EXPLORATION_AT_MAP_POINT,   // The car recorded or revisited a MapPoint and moved on
+    EXPLORATION_REPLANNING,     // The car drove one cell of a route to an unexplored MapPoint
+    EXPLORATION_DONE            // Exploration is complete
+} ExplorationStatus;
+
+// Where the exploration is within its tick cycle
+typedef enum {
+    PHASE_EXPLORE,      // Read the sensors, update the map and move
+    PHASE_ROUTE,        // Drive the route returned by the planner
+    PHASE_DONE
+} ExplorationPhase;
+
+// Exploration progress kept between ticks
+typedef struct ExplorationState {
+    ExplorationPhase phase;
+    Path *route;            // Route being driven in PHASE_ROUTE, owned by the state
+    RouteCursor cursor;
+    unsigned long ticks;
+    int last_move;          // Move executed in the last tick, -1 if none
+    uint64_t route_started; // Trace time the route was started, 0 if untraced
+    struct Scoreboard *scoreboard;  // Scores the driving if set, not owned (see scoreboard.h)
+} ExplorationState;
+
+// Previous MapPoint the car passed
+extern MapPoint *former_map_point;
+
+// Per-tick flags of the map update
+extern bool map_changed;
+extern bool leaving_former;
+
+// Every exploration, also of simulations and fleets, is presized for its track (see exploration_presize())
+extern bool presize_explorations;
 
 // Function declarations
 void start_exploration();
+Move choose_next_move(const bool sensors[3], Direction orientation);
+void apply_move(Move move);
+
+// Steps of one exploration tick
+Path *process_sensor_readings();
+void exploration_before_move();
+void exploration_after_move();
+bool exploration_complete();
+bool exploration_map_complete();
+int checkValidTrackCompletion();
+Path *route_to_ranked_frontier(MapPoint *current, FrontierRank rank);
+Path *route_to_closest_frontier(MapPoint *current);
+void exploration_record_final_map_point();
+
+// Tick-by-tick exploration
+void run_exploration(ExplorationState *state);
+void exploration_state_init(ExplorationState *state);
+void exploration_state_free(ExplorationState *state);
+ExplorationStatus exploration_tick(ExplorationState *state);
+void exploration_presize(int max_map_points, int maps);
 
 #endif // TRACK_EXPLORATION_H
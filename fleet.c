@@ -0,0 +1,353 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "fleet.h"
+#include "lap.h"
+#include "noise.h"
+#include "policy.h"
+#include "scoreboard.h"
+#include "ground_truth.h"
+#include "static_pools.h"
+#include "track_files_PRIVATE/track_generation.h"
+
+/**
+ * @struct FleetClaim
+ * @brief The unexplored FundamentalPath a car drives or heads for.
+ */
+typedef struct FleetClaim {
+    int map_point;              /**< ID of the MapPoint the path leaves, -1 for none */
+    Direction direction;
+} FleetClaim;
+
+/**
+ * @struct FleetCar
+ * @brief Everything one car of a fleet owns; the globals hold it while the car takes its tick.
+ */
+typedef struct FleetCar {
+    Car car;
+    bool sensors[3];
+    MapPoint *former_map_point;
+    MapPoint *latest_map_point;
+    bool map_changed;
+    bool leaving_former;
+    NoiseStream sensor_noise;
+    NoiseStream motor_noise;
+    ExplorationState exploration;
+    Scoreboard scoreboard;
+} FleetCar;
+
+/**
+ * @struct FleetResult
+ * @brief What a fleet needed to explore the track.
+ */
+typedef struct FleetResult {
+    unsigned long rounds;
+    bool stopped;               /**< Stopped by the round limit */
+    bool pools_exhausted;       /**< Stopped because a static pool ran out (see static_pools.h) */
+    ScoreReport report;         /**< Scores of the shared map and of all cars' driving */
+    double elapsed_ms;
+} FleetResult;
+
+bool fleet_active = false;
+static FleetClaim claims[FLEET_MAX_CARS];
+static int num_cars = 0;
+static int active_car = 0;
+
+// ======================= CLAIMS ======================= //
+
+/**
+ * @brief Checks if the path leaving a MapPoint in a direction is unexplored.
+ *
+ * @param mp Pointer to the MapPoint.
+ * @param direction Direction the path leaves in.
+ * @return bool True if the MapPoint has an unexplored path in that direction.
+ */
+static bool unexplored_path(const MapPoint *mp, Direction direction) {
+    for (int i = 0; i < mp->numberOfPaths; i++) {
+        if ((Direction) mp->paths[i].direction == direction) return fp_end(&mp->paths[i]) == NULL;
+    }
+    return false;
+}
+
+/**
+ * @brief Checks if another car claimed the unexplored path of a MapPoint in a direction.
+ *
+ * @param mp Pointer to the MapPoint.
+ * @param direction Direction of the path.
+ * @return bool True if a fleet is exploring and another car drives or heads for that path.
+ */
+bool fleet_path_claimed(const MapPoint *mp, Direction direction) {
+    if (!fleet_active) return false;
+    for (int c = 0; c < num_cars; c++) {
+        if (c != active_car && claims[c].map_point == mp->id && claims[c].direction == direction) return true;
+    }
+    return false;
+}
+
+/**
+ * @brief Checks if every unexplored path of a MapPoint was claimed by another car.
+ *
+ * @param mp Pointer to the MapPoint.
+ * @return bool True if a fleet is exploring and no unexplored path is left for this car.
+ */
+bool fleet_frontier_taken(const MapPoint *mp) {
+    if (!fleet_active) return false;
+    for (int i = 0; i < mp->numberOfPaths; i++) {
+        if (!fp_end(&mp->paths[i]) && !fleet_path_claimed(mp, (Direction) mp->paths[i].direction)) return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Swaps the policy's move at a MapPoint for an unclaimed unexplored path if another
+ *        car claimed the path of the move, and claims the path the car takes.
+ *
+ * @param sensors Sensor readings (0: forward, 1: left, 2: right).
+ * @param orientation Direction the car faces.
+ * @param at Pointer to the MapPoint the car stands on.
+ * @param move Move chosen by the policy.
+ * @return Move The move to execute.
+ */
+Move fleet_claim_move(const bool sensors[3], Direction orientation, const MapPoint *at, Move move) {
+    static const Move order[3] = {MOVE_FORWARD, MOVE_LEFT, MOVE_RIGHT};
+    if (move != MOVE_U_TURN && unexplored_path(at, move_direction(orientation, move)) &&
+        fleet_path_claimed(at, move_direction(orientation, move))) {
+        for (int i = 0; i < 3; i++) {
+            Direction direction = move_direction(orientation, order[i]);
+            if (sensors[order[i]] && unexplored_path(at, direction) && !fleet_path_claimed(at, direction)) {
+                move = order[i];
+                break;
+            }
+        }
+    }
+
+    Direction direction = move_direction(orientation, move);
+    if (move != MOVE_U_TURN && unexplored_path(at, direction)) {
+        claims[active_car] = (FleetClaim) {at->id, direction};
+    } else {
+        claims[active_car] = (FleetClaim) {-1, INVALID_DIRECTION};
+    }
+    return move;
+}
+
+/**
+ * @brief Claims the first unclaimed unexplored path of the MapPoint a route leads to.
+ *
+ * @param target Pointer to the end of the route.
+ */
+void fleet_claim_frontier(const MapPoint *target) {
+    claims[active_car] = (FleetClaim) {-1, INVALID_DIRECTION};
+    for (int i = 0; i < target->numberOfPaths; i++) {
+        Direction direction = (Direction) target->paths[i].direction;
+        if (!fp_end(&target->paths[i]) && !fleet_path_claimed(target, direction)) {
+            claims[active_car] = (FleetClaim) {target->id, direction};
+            return;
+        }
+    }
+}
+
+// ======================= CAR SWAPPING ======================= //
+
+/**
+ * @brief Copies the per-car globals into a car.
+ *
+ * @param car Pointer to the car to store the state in.
+ */
+static void store_car(FleetCar *car) {
+    car->car = current_car;
+    memcpy(car->sensors, ultrasonic_sensors, sizeof(ultrasonic_sensors));
+    car->former_map_point = former_map_point;
+    car->latest_map_point = latest_map_point;
+    car->map_changed = map_changed;
+    car->leaving_former = leaving_former;
+    car->sensor_noise = sensor_noise;
+    car->motor_noise = motor_noise;
+}
+
+/**
+ * @brief Makes a car the one the per-car globals describe.
+ *
+ * @param car Pointer to the car to load.
+ */
+static void load_car(const FleetCar *car) {
+    current_car = car->car;
+    memcpy(ultrasonic_sensors, car->sensors, sizeof(ultrasonic_sensors));
+    former_map_point = car->former_map_point;
+    latest_map_point = car->latest_map_point;
+    map_changed = car->map_changed;
+    leaving_former = car->leaving_former;
+    sensor_noise = car->sensor_noise;
+    motor_noise = car->motor_noise;
+}
+
+// ======================= FLEET RUNS ======================= //
+
+/**
+ * @brief Scores the shared map and the cells all cars drove together.
+ *
+ * @param fleet The cars.
+ * @param cars Number of cars.
+ * @param report Pointer to the report to fill.
+ */
+static void score_fleet(FleetCar fleet[], int cars, ScoreReport *report) {
+    // Every car records the MapPoint it stopped at, as a single car does before scoring; a car
+    // stopped on a route drives known paths and its former MapPoint is the end of the route
+    for (int c = 0; c < cars; c++) {
+        if (fleet[c].exploration.phase == PHASE_ROUTE) continue;
+        active_car = c;
+        load_car(&fleet[c]);
+        exploration_record_final_map_point();
+        store_car(&fleet[c]);
+    }
+
+    size_t words = ((size_t) track_width() * track_height() + 63) / 64;
+    Scoreboard merged = fleet[0].scoreboard;
+    merged.visited = calloc(words, sizeof(uint64_t));
+    if (!merged.visited) {
+        perror("Error: Failed to allocate fleet scoreboard");
+        exit(EXIT_FAILURE);
+    }
+    merged.cells_driven = 0;
+    merged.replans = 0;
+    unsigned long visited = 0;
+    for (int c = 0; c < cars; c++) {
+        merged.cells_driven += fleet[c].scoreboard.cells_driven;
+        merged.replans += fleet[c].scoreboard.replans;
+    }
+    for (size_t w = 0; w < words; w++) {
+        for (int c = 0; c < cars; c++) merged.visited[w] |= fleet[c].scoreboard.visited[w];
+        visited += (unsigned long) __builtin_popcountll(merged.visited[w]);
+    }
+    merged.new_cells = visited - 1;  // The start cell was never driven into
+
+    GroundTruthGraph graph;
+    ground_truth_extract_track(&graph);
+    scoreboard_evaluate(&merged, &graph, report);
+    ground_truth_free(&graph);
+    free(merged.visited);
+}
+
+/**
+ * @brief Explores the loop track with a fleet, all cars starting at the start position.
+ *
+ * The fleet stops once a car stopped, the shared map is complete or proves the lap, or a
+ * static pool runs out.
+ *
+ * @param cars Number of cars, 1 to FLEET_MAX_CARS.
+ * @param seed Seed of the noise streams, one pair per car.
+ * @param result Pointer to the result to fill.
+ */
+static void play_fleet(int cars, uint64_t seed, FleetResult *result) {
+    initialize_globals();
+    initialize_grid();
+    create_loop_track();
+    start = current_car.current_location;
+    start_orientation = current_car.current_orientation;
+    former_map_point = NULL;
+    map_changed = false;
+    leaving_former = false;
+    if (presize_explorations) exploration_presize((int) track_cells_on_track(), 1);
+
+    FleetCar fleet[FLEET_MAX_CARS];
+    for (int c = 0; c < cars; c++) {
+        noise_stream_init(&sensor_noise, seed, (uint64_t) c, NOISE_STREAM_SENSORS);
+        noise_stream_init(&motor_noise, seed, (uint64_t) c, NOISE_STREAM_MOTORS);
+        exploration_state_init(&fleet[c].exploration);
+        scoreboard_init(&fleet[c].scoreboard);
+        fleet[c].exploration.scoreboard = &fleet[c].scoreboard;
+        store_car(&fleet[c]);
+        claims[c] = (FleetClaim) {-1, INVALID_DIRECTION};
+    }
+    fleet_active = true;
+    num_cars = cars;
+
+    struct timespec begin, end;
+    clock_gettime(CLOCK_MONOTONIC, &begin);
+    unsigned long round_limit = (unsigned long) (track_cells_on_track() * FLEET_TICKS_PER_CELL);
+    memset(result, 0, sizeof(*result));
+    bool done = false;
+    while (!done) {
+        if (result->rounds >= round_limit) {
+            result->stopped = true;
+            break;
+        }
+        result->rounds++;
+
+        bool changed = false;
+        for (int c = 0; c < cars; c++) {
+            if (fleet[c].exploration.phase == PHASE_DONE) continue;
+            active_car = c;
+            load_car(&fleet[c]);
+            // The policy decides on the shared map, so a car that is done ends the exploration
+            if (exploration_tick(&fleet[c].exploration) == EXPLORATION_DONE) done = true;
+            changed |= map_changed;
+
+            // Other cars add MapPoints between the ones this car passes, so a revisited MapPoint
+            // is linked to the one this car left last, not to the last one it added
+            if (map_changed && former_map_point) latest_map_point = former_map_point;
+            store_car(&fleet[c]);
+            if (static_pools_exhausted()) break;
+        }
+        if (static_pools_exhausted()) {
+            result->pools_exhausted = true;
+            break;
+        }
+
+        // A car that proves the lap stops itself; the others learn it from the shared map
+        if (exploration_map_complete() || (changed && lap_bound_exploration_complete())) break;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    result->elapsed_ms = (end.tv_sec - begin.tv_sec) * 1e3 + (end.tv_nsec - begin.tv_nsec) / 1e6;
+
+    score_fleet(fleet, cars, &result->report);
+
+    fleet_active = false;
+    for (int c = 0; c < cars; c++) {
+        exploration_state_free(&fleet[c].exploration);
+        scoreboard_free(&fleet[c].scoreboard);
+    }
+    free_globals();
+    track_free(current_track);
+    current_track = NULL;
+}
+
+/**
+ * @brief Explores the loop track with fleets of 1 to max_cars cars and prints the rounds
+ *        each fleet needed next to its scores.
+ *
+ * @param max_cars Largest fleet, 1 to FLEET_MAX_CARS.
+ * @param seed Seed of the noise streams.
+ * @return bool True if every fleet finished within the round limit. False as soon as a static
+ *              pool runs out; the comparison stops there, since the pools stay exhausted.
+ */
+bool run_fleet_comparison(int max_cars, uint64_t seed) {
+    if (max_cars < 1 || max_cars > FLEET_MAX_CARS) {
+        fprintf(stderr, "Error: a fleet has 1 to %d cars\n", FLEET_MAX_CARS);
+        return false;
+    }
+
+    bool complete = true;
+    unsigned long single_car_rounds = 0;
+    printf("Fleet exploration of the loop track (%s):\n", exploration_policy->name);
+    printf("  %-4s %8s %8s %12s %10s %10s %8s %10s\n", "cars", "rounds", "speedup", "cells driven", "MapPoints",
+           "lap ratio", "stopped", "ms");
+    for (int cars = 1; cars <= max_cars; cars++) {
+        FleetResult result;
+        play_fleet(cars, seed, &result);
+        if (result.pools_exhausted) {
+            fprintf(stderr, "Error: the fleet of %d cars ran out of a static pool, comparison stopped\n", cars);
+            return false;
+        }
+        if (cars == 1) single_car_rounds = result.rounds;
+        complete &= !result.stopped;
+
+        const ScoreReport *r = &result.report;
+        printf("  %-4d %8lu %7.2fx %12lu %9.1f%% %10.3f %8s %10.3f\n", cars, result.rounds,
+               result.rounds > 0 ? (double) single_car_rounds / result.rounds : 0.0, r->cells_driven,
+               r->nodes > 0 ? 100.0 * r->nodes_found / r->nodes : 0.0,
+               r->optimal_lap > 0 ? (double) r->lap / r->optimal_lap : 0.0, result.stopped ? "yes" : "no",
+               result.elapsed_ms);
+    }
+    return complete;
+}
@@ -0,0 +1,45 @@
+#ifndef FLEET_H
+#define FLEET_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "globals.h"
+#include "exploration.h"
+
+// ======================= FLEET ======================= //
+//
+// Several cars explore one track together. Every car has its own pose, sensors, noise
+// streams and progress (former_map_point, latest_map_point, its ExplorationState); the
+// MapPoint graph and the live map version are shared. A round moves every car by one tick,
+// so the rounds a fleet needs are its exploration time. The cars take turns on the shared
+// map within a round: the map code works on globals, and a car's map update of one tick
+// is small next to driving a cell, so no update needs a lock.
+//
+// A car claims the unexplored FundamentalPath it drives or heads for. At a MapPoint the move
+// of the policy is swapped for an unclaimed unexplored path if another car claimed its path,
+// and the frontier search skips MapPoints whose unexplored paths are all claimed.
+//
+// The policies decide on the shared map, so the exploration ends as soon as one car is done.
+
+#define FLEET_MAX_CARS 16
+#define FLEET_TICKS_PER_CELL 16     // A fleet still exploring after this many rounds per track cell is stopped
+
+// Set while a fleet is exploring, so the claims are honoured
+extern bool fleet_active;
+
+// Check if another car claimed the unexplored path of a MapPoint in a direction
+bool fleet_path_claimed(const MapPoint *mp, Direction direction);
+
+// Check if every unexplored path of a MapPoint was claimed by another car
+bool fleet_frontier_taken(const MapPoint *mp);
+
+// Swap the policy's move at a MapPoint for an unclaimed unexplored path if needed, and claim it
+Move fleet_claim_move(const bool sensors[3], Direction orientation, const MapPoint *at, Move move);
+
+// Claim an unexplored path of the MapPoint a route leads to
+void fleet_claim_frontier(const MapPoint *target);
+
+// Explore the loop track with fleets of 1 to max_cars cars and print the rounds each needed
+bool run_fleet_comparison(int max_cars, uint64_t seed);
+
+#endif // FLEET_H
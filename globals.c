@@ -3,11 +3,27 @@
 #include "globals.h"
 #include "direction.h"
 #include "track_files_PRIVATE/track_navigation.h"
+#include "instrumentation.h"
+#include "alloc_tracker.h"
+#include "static_pools.h"
+#include "map_version.h"
+#include "occupancy.h"
+
+#ifdef STATIC_POOLS
+// Every map takes three MapPoint lists and one FundamentalPath list, sized for a full map
+typedef MapPoint *MapPointList[POOL_MAP_POINTS];
+typedef FundamentalPath *FundamentalPathList[POOL_MAP_POINTS * POOL_PATHS_PER_MAP_POINT];
+
+STATIC_POOL_DEFINE(map_point_list_pool, "MapPoint lists (3 * POOL_MAP_SETS)", MapPointList, 3 * POOL_MAP_SETS)
+STATIC_POOL_DEFINE(fundamental_path_list_pool, "FundamentalPath lists (POOL_MAP_SETS)", FundamentalPathList,
+                   POOL_MAP_SETS)
+#endif
 
 // Dynamic global arrays
 MapPoint **map_points_tbd = NULL;
 MapPoint **map_points_all = NULL;
 FundamentalPath **all_fundamental_paths = NULL;
+MapPoint **map_points_changed = NULL;  // MapPoints changed since the last published map update
 
 
 Location start = {0,0};
@@ -26,25 +42,150 @@ bool ultrasonic_sensors[3] = {true, true, true};  // {forward, left, right}
 int num_map_points_tbd = 0, capacity_map_points_tbd = 20;
 int num_map_points_all = 0, capacity_map_points_all = 80;
 int num_all_fundamental_paths = 0, capacity_all_fundamental_paths = 160;
+int num_map_points_changed = 0, capacity_map_points_changed = 20;
 
+// ID counters
+int map_point_counter = 0, fundamental_path_counter = 0;
+
+/**
+ * @brief Resets the global state to a fresh simulation and allocates the global arrays.
+ */
 void initialize_globals() {
-    map_points_tbd = malloc(capacity_map_points_tbd * sizeof(MapPoint));
-    map_points_all = malloc(capacity_map_points_all * sizeof(MapPoint));
-    all_fundamental_paths = malloc(capacity_all_fundamental_paths * sizeof(FundamentalPath));
+    num_map_points_tbd = 0;
+    capacity_map_points_tbd = 20;
+    num_map_points_all = 0;
+    capacity_map_points_all = 80;
+    num_all_fundamental_paths = 0;
+    capacity_all_fundamental_paths = 160;
+    num_map_points_changed = 0;
+    capacity_map_points_changed = 20;
+    map_point_counter = 0;
+    fundamental_path_counter = 0;
+
+    current_car = (Car) {{2, 1}, EAST};
+    for (int i = 0; i < 3; i++) ultrasonic_sensors[i] = true;
+
+    // The live map version belongs to the previous state, which released or stored it
+    live_map_version = (MapVersion) {NULL, 0, 0, 0};
+    occupancy_grid = (OccupancyGrid) {0, 0, 0, NULL, 0};
+    latest_map_point = NULL;
+
+#ifdef STATIC_POOLS
+    capacity_map_points_tbd = capacity_map_points_all = capacity_map_points_changed = POOL_MAP_POINTS;
+    capacity_all_fundamental_paths = POOL_MAP_POINTS * POOL_PATHS_PER_MAP_POINT;
+    map_points_tbd = static_pool_take(&map_point_list_pool);
+    map_points_all = static_pool_take(&map_point_list_pool);
+    all_fundamental_paths = static_pool_take(&fundamental_path_list_pool);
+    map_points_changed = static_pool_take(&map_point_list_pool);
+
+    // Exploration stops at its first tick, but the map must still be consistent until then
+    if (!map_points_tbd || !map_points_all || !all_fundamental_paths || !map_points_changed) {
+        free_globals();
+        map_points_tbd = map_points_all = map_points_changed = NULL;
+        all_fundamental_paths = NULL;
+        capacity_map_points_tbd = capacity_map_points_all = capacity_map_points_changed = 0;
+        capacity_all_fundamental_paths = 0;
+    }
+#else
+    map_points_tbd = tracked_malloc(ALLOC_MAP_ARRAYS, capacity_map_points_tbd * sizeof(MapPoint *));
+    map_points_all = tracked_malloc(ALLOC_MAP_ARRAYS, capacity_map_points_all * sizeof(MapPoint *));
+    all_fundamental_paths = tracked_malloc(ALLOC_MAP_ARRAYS, capacity_all_fundamental_paths * sizeof(FundamentalPath *));
+    map_points_changed = tracked_malloc(ALLOC_MAP_ARRAYS, capacity_map_points_changed * sizeof(MapPoint *));
 
-    if (!map_points_tbd || !map_points_all || !all_fundamental_paths) {
+    if (!map_points_tbd || !map_points_all || !all_fundamental_paths || !map_points_changed) {
         perror("Failed to allocate global arrays");
         exit(EXIT_FAILURE);
     }
+#endif
+}
+
+/**
+ * @brief Resizes a global pointer array to exactly the given capacity.
+ *
+ * The static lists cannot be resized: they keep their capacity if it is large enough.
+ *
+ * @param array Pointer to the array.
+ * @param capacity Pointer to the capacity of the array.
+ * @param size Capacity wanted.
+ * @return bool True if the array holds the given capacity.
+ */
+static bool resize_array(void ***array, int *capacity, int size) {
+#ifdef STATIC_POOLS
+    (void) array;
+    return size <= *capacity;
+#else
+    void **temp = tracked_realloc(ALLOC_MAP_ARRAYS, *array, (size ? size : 1) * sizeof(void *));
+    if (!temp) {
+        perror("Failed to reserve global arrays");
+        exit(EXIT_FAILURE);
+    }
+    *array = temp;
+    *capacity = size;
+    return true;
+#endif
+}
+
+/**
+ * @brief Grows the global arrays so a map of the given size never resizes them.
+ *
+ * @param map_points Number of MapPoints the map can reach.
+ * @param fundamental_paths Number of FundamentalPaths the map can reach.
+ */
+void reserve_globals(int map_points, int fundamental_paths) {
+    if (map_points > capacity_map_points_tbd) {
+        resize_array((void ***) &map_points_tbd, &capacity_map_points_tbd, map_points);
+    }
+    if (map_points > capacity_map_points_all) {
+        resize_array((void ***) &map_points_all, &capacity_map_points_all, map_points);
+    }
+    if (map_points > capacity_map_points_changed) {
+        resize_array((void ***) &map_points_changed, &capacity_map_points_changed, map_points);
+    }
+    if (fundamental_paths > capacity_all_fundamental_paths) {
+        resize_array((void ***) &all_fundamental_paths, &capacity_all_fundamental_paths, fundamental_paths);
+    }
 }
 
+/**
+ * @brief Sets the capacities of the global arrays, e.g. to those saved in a checkpoint.
+ *
+ * @param tbd Capacity of map_points_tbd.
+ * @param all Capacity of map_points_all.
+ * @param changed Capacity of map_points_changed.
+ * @param fundamental_paths Capacity of all_fundamental_paths.
+ * @return bool True if every array holds its capacity, false if a static list is too small.
+ */
+bool resize_globals(int tbd, int all, int changed, int fundamental_paths) {
+    return resize_array((void ***) &map_points_tbd, &capacity_map_points_tbd, tbd) &&
+           resize_array((void ***) &map_points_all, &capacity_map_points_all, all) &&
+           resize_array((void ***) &map_points_changed, &capacity_map_points_changed, changed) &&
+           resize_array((void ***) &all_fundamental_paths, &capacity_all_fundamental_paths, fundamental_paths);
+}
+
+/**
+ * @brief Frees every MapPoint and the global arrays.
+ */
 void free_globals() {
+    for (int i = 0; i < num_map_points_all; i++) {
+        map_point_free(map_points_all[i]);
+    }
+    map_version_release(&live_map_version);
+    occupancy_free();
+#ifdef STATIC_POOLS
+    static_pool_give(&map_point_list_pool, map_points_tbd);
+    static_pool_give(&map_point_list_pool, map_points_all);
+    static_pool_give(&fundamental_path_list_pool, all_fundamental_paths);
+    static_pool_give(&map_point_list_pool, map_points_changed);
+#else
     free(map_points_tbd);
     free(map_points_all);
     free(all_fundamental_paths);
+    free(map_points_changed);
+#endif
 }
 
 void check_mappoints_tbd() {
+    INSTRUMENT_FUNCTION(COUNTER_CHECK_MAPPOINTS_TBD);
     for (int i = num_map_points_tbd - 1; i >= 0; i--) {
         MapPoint *map_point_tbd = map_points_tbd[i];
         if (!mp_has_unexplored_paths(map_point_tbd)) {
@@ -60,18 +201,60 @@ void check_mappoints_tbd() {
 
 // Function to add a FundamentalPath to the global list
 void add_fundamental_path(FundamentalPath *path) {
-    // Reallocate memory to accommodate the new path
-    FundamentalPath **temp = realloc(all_fundamental_paths, (num_all_fundamental_paths + 1) * sizeof(FundamentalPath *));
-    if (!temp) {
-        perror("Failed to reallocate memory for all_fundamental_paths");
-        exit(EXIT_FAILURE);
+    // Double the capacity when the array is full
+    if (num_all_fundamental_paths == capacity_all_fundamental_paths) {
+#ifdef STATIC_POOLS
+        static_pools_fail("all_fundamental_paths (POOL_MAP_POINTS)");
+        return;
+#endif
+        capacity_all_fundamental_paths *= 2;
+        INSTRUMENT_COUNT(COUNTER_FUNDAMENTAL_PATH_REALLOC);
+        FundamentalPath **temp = tracked_realloc(ALLOC_MAP_ARRAYS, all_fundamental_paths,
+                                                 capacity_all_fundamental_paths * sizeof(FundamentalPath *));
+        if (!temp) {
+            perror("Failed to reallocate memory for all_fundamental_paths");
+            exit(EXIT_FAILURE);
+        }
+        all_fundamental_paths = temp;
     }
 
     // Update the global array and counter
-    all_fundamental_paths = temp;
     all_fundamental_paths[num_all_fundamental_paths++] = path;
 }
 
+/**
+ * @brief Records that a MapPoint changed, so the change can be published to listeners
+ *        such as the planner thread.
+ *
+ * @param mp Pointer to the MapPoint that was created or updated.
+ */
+void mark_map_point_changed(MapPoint *mp) {
+    if (mp->changed) return;
 
+    if (num_map_points_changed == capacity_map_points_changed) {
+#ifdef STATIC_POOLS
+        static_pools_fail("map_points_changed (POOL_MAP_POINTS)");
+        return;
+#endif
+        capacity_map_points_changed *= 2;
+        MapPoint **temp = tracked_realloc(ALLOC_MAP_ARRAYS, map_points_changed, capacity_map_points_changed * sizeof(MapPoint *));
+        if (!temp) {
+            perror("Failed to reallocate memory for map_points_changed");
+            exit(EXIT_FAILURE);
+        }
+        map_points_changed = temp;
+    }
 
+    mp->changed = true;
+    map_points_changed[num_map_points_changed++] = mp;
+}
 
+/**
+ * @brief Clears the list of changed MapPoints after their changes were published.
+ */
+void clear_map_points_changed() {
+    for (int i = 0; i < num_map_points_changed; i++) {
+        map_points_changed[i]->changed = false;
+    }
+    num_map_points_changed = 0;
+}
@@ -7,10 +7,15 @@
 extern MapPoint **map_points_tbd;
 extern MapPoint **map_points_all;
 extern FundamentalPath **all_fundamental_paths;
+extern MapPoint **map_points_changed;
 
 extern int num_map_points_tbd, capacity_map_points_tbd;
 extern int num_map_points_all, capacity_map_points_all;
 extern int num_all_fundamental_paths, capacity_all_fundamental_paths;
+extern int num_map_points_changed, capacity_map_points_changed;
+
+// Counters for generating unique MapPoint and FundamentalPath IDs
+extern int map_point_counter, fundamental_path_counter;
 
 extern Location start;
 extern Direction start_orientation;
@@ -29,6 +34,10 @@ extern bool ultrasonic_sensors[3];
 
 void initialize_globals();
 void free_globals();
+void reserve_globals(int map_points, int fundamental_paths);
+bool resize_globals(int tbd, int all, int changed, int fundamental_paths);
 void check_mappoints_tbd();
 void add_fundamental_path(FundamentalPath *path);
+void mark_map_point_changed(MapPoint *mp);
+void clear_map_points_changed();
 #endif // GLOBALS_H
@@ -0,0 +1,457 @@
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include "ground_truth.h"
+#include "track_files_PRIVATE/track_generation.h"
+
+// ======================= WORD-WIDE CELL CLASSES ======================= //
+//
+// A row of the bitmap is classified a vector at a time: with AVX2 four 64-bit words, with
+// SSE2 two, and one word otherwise. Bit x of a word is the cell x of its 64 columns, so the
+// west neighbours of all cells are the row shifted up by one bit, with the top bit of the
+// previous word carried in, and the east neighbours the row shifted down by one bit.
+
+#if defined(__AVX2__)
+typedef uint64_t Lanes __attribute__((vector_size(32)));
+#elif defined(__SSE2__)
+typedef uint64_t Lanes __attribute__((vector_size(16)));
+#else
+typedef uint64_t Lanes;
+#endif
+
+#define LANE_WORDS (sizeof(Lanes) / sizeof(uint64_t))
+
+/**
+ * @brief Loads consecutive words of a row, aligned or not.
+ *
+ * @param words Pointer to the first word.
+ * @return Lanes The words.
+ */
+static inline Lanes load_lanes(const uint64_t *words) {
+    Lanes lanes;
+    memcpy(&lanes, words, sizeof(lanes));
+    return lanes;
+}
+
+/**
+ * @brief Stores consecutive words of a row.
+ *
+ * @param words Pointer to the first word.
+ * @param lanes The words.
+ */
+static inline void store_lanes(uint64_t *words, Lanes lanes) {
+    memcpy(words, &lanes, sizeof(lanes));
+}
+
+/**
+ * @struct RowClasses
+ * @brief Cells of each class in one row of the bitmap, one bit per cell.
+ */
+typedef struct RowClasses {
+    uint64_t *corridor;
+    uint64_t *bend;
+    uint64_t *junction;
+    uint64_t *dead_end;
+} RowClasses;
+
+/**
+ * @brief Classifies every cell of a row by counting its track neighbours bit-parallel.
+ *
+ * @param bitmap Pointer to the bitmap.
+ * @param y Row to classify.
+ * @param out Masks to write, bitmap->words words each.
+ */
+static void classify_row(const TrackBitmap *bitmap, int y, const RowClasses *out) {
+    const uint64_t *mid = bitmap->bits + (size_t) (y + 1) * bitmap->stride;
+    const uint64_t *up = mid - bitmap->stride;
+    const uint64_t *down = mid + bitmap->stride;
+
+    for (size_t i = 0; i < bitmap->words; i += LANE_WORDS) {
+        size_t word = i + 1;  // Skip the padding word
+        Lanes cell = load_lanes(mid + word);
+        Lanes north = load_lanes(up + word);
+        Lanes south = load_lanes(down + word);
+        Lanes west = (cell << 1) | (load_lanes(mid + word - 1) >> 63);
+        Lanes east = (cell >> 1) | (load_lanes(mid + word + 1) << 63);
+
+        // Neighbour count in bit-sliced form: pairs first, then the two pairs together
+        Lanes vertical_both = north & south, vertical_one = north ^ south;
+        Lanes horizontal_both = west & east, horizontal_one = west ^ east;
+        Lanes three_or_more = (vertical_both & (west | east)) | (horizontal_both & (north | south));
+        Lanes odd = vertical_one ^ horizontal_one;
+
+        Lanes corridor = (vertical_both & ~(west | east)) | (horizontal_both & ~(north | south));
+        store_lanes(out->corridor + i, cell & corridor);
+        store_lanes(out->bend + i, cell & vertical_one & horizontal_one);
+        store_lanes(out->junction + i, cell & three_or_more);
+        store_lanes(out->dead_end + i, cell & ~three_or_more & (odd | ~(north | south | west | east)));
+    }
+}
+
+// ======================= TRACK BITMAP ======================= //
+
+/**
+ * @brief Packs the current track into a bitmap.
+ *
+ * @param bitmap Pointer to the bitmap to fill, released with track_bitmap_free().
+ */
+void track_bitmap_create(TrackBitmap *bitmap) {
+    bitmap->width = track_width();
+    bitmap->height = track_height();
+    size_t cell_words = ((size_t) bitmap->width + 63) / 64;
+    bitmap->words = (cell_words + LANE_WORDS - 1) / LANE_WORDS * LANE_WORDS;
+    bitmap->stride = bitmap->words + 2;
+    bitmap->bits = calloc(((size_t) bitmap->height + 2) * bitmap->stride, sizeof(uint64_t));
+    if (!bitmap->bits) {
+        perror("Error: Failed to allocate track bitmap");
+        exit(EXIT_FAILURE);
+    }
+
+    for (int y = 0; y < bitmap->height; y++) {
+        uint64_t *row = bitmap->bits + (size_t) (y + 1) * bitmap->stride + 1;
+        for (int x = 0; x < bitmap->width; x++) {
+            if (track_cell(x, y) != EMPTY) row[x / 64] |= 1ULL << (x % 64);
+        }
+    }
+}
+
+/**
+ * @brief Frees a bitmap.
+ *
+ * @param bitmap Pointer to the bitmap.
+ */
+void track_bitmap_free(TrackBitmap *bitmap) {
+    free(bitmap->bits);
+    bitmap->bits = NULL;
+}
+
+/**
+ * @brief Checks if a cell of a bitmap is track. Cells around the track are not.
+ *
+ * @param bitmap Pointer to the bitmap.
+ * @param x Column of the cell, -1 to width.
+ * @param y Row of the cell, -1 to height.
+ * @return bool True if the car can drive on the cell.
+ */
+static inline bool bitmap_cell(const TrackBitmap *bitmap, int x, int y) {
+    const uint64_t *row = bitmap->bits + (size_t) (y + 1) * bitmap->stride;
+    size_t bit = (size_t) (x + 64);  // The padding word holds x = -1
+    return (row[bit / 64] >> (bit % 64)) & 1;
+}
+
+// ======================= EXTRACTION ======================= //
+
+/**
+ * @brief Appends a node to the graph.
+ *
+ * @param graph Pointer to the graph.
+ * @param x Column of the node.
+ * @param y Row of the node.
+ * @param kind Class of the cell.
+ * @return int Index of the node.
+ */
+static int add_node(GroundTruthGraph *graph, int x, int y, CellClass kind) {
+    if (graph->num_nodes == graph->capacity_nodes) {
+        graph->capacity_nodes = graph->capacity_nodes ? graph->capacity_nodes * 2 : 64;
+        GroundTruthNode *nodes = realloc(graph->nodes, (size_t) graph->capacity_nodes * sizeof(GroundTruthNode));
+        if (!nodes) {
+            perror("Error: Failed to allocate ground truth nodes");
+            exit(EXIT_FAILURE);
+        }
+        graph->nodes = nodes;
+    }
+    GroundTruthNode *node = &graph->nodes[graph->num_nodes];
+    node->x = x;
+    node->y = y;
+    node->kind = kind;
+    for (int d = 0; d < 4; d++) node->edges[d] = -1;
+    return graph->num_nodes++;
+}
+
+/**
+ * @brief Connects two nodes by a straight corridor.
+ *
+ * @param graph Pointer to the graph.
+ * @param from Node north or west of the other.
+ * @param to The other node.
+ * @param direction EAST or SOUTH, from the from node.
+ */
+static void add_edge(GroundTruthGraph *graph, int from, int to, Direction direction) {
+    if (graph->num_edges == graph->capacity_edges) {
+        graph->capacity_edges = graph->capacity_edges ? graph->capacity_edges * 2 : 64;
+        GroundTruthEdge *edges = realloc(graph->edges, (size_t) graph->capacity_edges * sizeof(GroundTruthEdge));
+        if (!edges) {
+            perror("Error: Failed to allocate ground truth edges");
+            exit(EXIT_FAILURE);
+        }
+        graph->edges = edges;
+    }
+    const GroundTruthNode *a = &graph->nodes[from];
+    const GroundTruthNode *b = &graph->nodes[to];
+    graph->edges[graph->num_edges] = (GroundTruthEdge) {from, to, (b->x - a->x) + (b->y - a->y), direction};
+    graph->nodes[from].edges[direction] = graph->num_edges;
+    graph->nodes[to].edges[opposite_direction(direction)] = graph->num_edges;
+    graph->num_edges++;
+}
+
+/**
+ * @brief Classifies every cell of a bitmap and builds the reference graph.
+ *
+ * Rows are classified word-wide, then the node cells of the row are visited in order. A
+ * node with an open west side is joined to the previous node of its row, and one with an
+ * open north side to the previous node of its column: corridors are straight, so the
+ * cells in between are all corridor.
+ *
+ * @param bitmap Pointer to the bitmap of the track.
+ * @param graph Pointer to the graph to fill, released with ground_truth_free().
+ */
+void ground_truth_extract(const TrackBitmap *bitmap, GroundTruthGraph *graph) {
+    memset(graph, 0, sizeof(*graph));
+
+    uint64_t *scratch = malloc(4 * bitmap->words * sizeof(uint64_t));
+    int *column_last = malloc((size_t) bitmap->width * sizeof(int));
+    if (!scratch || !column_last) {
+        perror("Error: Failed to allocate ground truth scratch space");
+        exit(EXIT_FAILURE);
+    }
+    RowClasses classes = {scratch, scratch + bitmap->words, scratch + 2 * bitmap->words,
+                          scratch + 3 * bitmap->words};
+    for (int x = 0; x < bitmap->width; x++) column_last[x] = -1;
+
+    for (int y = 0; y < bitmap->height; y++) {
+        classify_row(bitmap, y, &classes);
+
+        int row_last = -1;
+        for (size_t w = 0; w < bitmap->words; w++) {
+            graph->cells[CELL_CORRIDOR] += __builtin_popcountll(classes.corridor[w]);
+            graph->cells[CELL_BEND] += __builtin_popcountll(classes.bend[w]);
+            graph->cells[CELL_JUNCTION] += __builtin_popcountll(classes.junction[w]);
+            graph->cells[CELL_DEAD_END] += __builtin_popcountll(classes.dead_end[w]);
+
+            uint64_t nodes = classes.bend[w] | classes.junction[w] | classes.dead_end[w];
+            while (nodes) {
+                int bit = __builtin_ctzll(nodes);
+                nodes &= nodes - 1;
+                uint64_t mask = 1ULL << bit;
+                int x = (int) (w * 64) + bit;
+                CellClass kind = (classes.bend[w] & mask) ? CELL_BEND
+                               : (classes.junction[w] & mask) ? CELL_JUNCTION : CELL_DEAD_END;
+
+                int node = add_node(graph, x, y, kind);
+                if (bitmap_cell(bitmap, x - 1, y) && row_last >= 0) add_edge(graph, row_last, node, EAST);
+                if (bitmap_cell(bitmap, x, y - 1) && column_last[x] >= 0) add_edge(graph, column_last[x], node, SOUTH);
+                row_last = node;
+                column_last[x] = node;
+            }
+        }
+    }
+    graph->cells[CELL_EMPTY] = (long) bitmap->width * bitmap->height - graph->cells[CELL_CORRIDOR] -
+                               graph->cells[CELL_BEND] - graph->cells[CELL_JUNCTION] - graph->cells[CELL_DEAD_END];
+
+    free(column_last);
+    free(scratch);
+}
+
+/**
+ * @brief Builds the reference graph of the current track.
+ *
+ * @param graph Pointer to the graph to fill, released with ground_truth_free().
+ */
+void ground_truth_extract_track(GroundTruthGraph *graph) {
+    TrackBitmap bitmap;
+    track_bitmap_create(&bitmap);
+    ground_truth_extract(&bitmap, graph);
+    track_bitmap_free(&bitmap);
+}
+
+/**
+ * @brief Frees a reference graph.
+ *
+ * @param graph Pointer to the graph.
+ */
+void ground_truth_free(GroundTruthGraph *graph) {
+    free(graph->nodes);
+    free(graph->edges);
+    memset(graph, 0, sizeof(*graph));
+}
+
+// ======================= QUERIES ======================= //
+
+/**
+ * @brief Finds the node of a cell by binary search, the nodes being sorted by row and column.
+ *
+ * @param graph Pointer to the graph.
+ * @param x Column of the cell.
+ * @param y Row of the cell.
+ * @return int Index of the node, -1 if the cell is no node.
+ */
+int ground_truth_find_node(const GroundTruthGraph *graph, int x, int y) {
+    int low = 0, high = graph->num_nodes - 1;
+    while (low <= high) {
+        int middle = low + (high - low) / 2;
+        const GroundTruthNode *node = &graph->nodes[middle];
+        if (node->y == y && node->x == x) return middle;
+        if (node->y < y || (node->y == y && node->x < x)) {
+            low = middle + 1;
+        } else {
+            high = middle - 1;
+        }
+    }
+    return -1;
+}
+
+/**
+ * @struct HeapEntry
+ * @brief Tentative distance of a node in the lap search.
+ */
+typedef struct HeapEntry {
+    long distance;
+    int node;
+} HeapEntry;
+
+/**
+ * @brief Adds an entry to a binary min-heap.
+ *
+ * @param heap Heap array, large enough for the entry.
+ * @param size Pointer to the number of entries.
+ * @param entry The entry.
+ */
+static void heap_push(HeapEntry *heap, int *size, HeapEntry entry) {
+    int i = (*size)++;
+    while (i > 0 && heap[(i - 1) / 2].distance > entry.distance) {
+        heap[i] = heap[(i - 1) / 2];
+        i = (i - 1) / 2;
+    }
+    heap[i] = entry;
+}
+
+/**
+ * @brief Removes the closest entry from a binary min-heap.
+ *
+ * @param heap Heap array.
+ * @param size Pointer to the number of entries, at least one.
+ * @return HeapEntry The entry with the smallest distance.
+ */
+static HeapEntry heap_pop(HeapEntry *heap, int *size) {
+    HeapEntry top = heap[0];
+    HeapEntry last = heap[--(*size)];
+    int i = 0;
+    while (2 * i + 1 < *size) {
+        int child = 2 * i + 1;
+        if (child + 1 < *size && heap[child + 1].distance < heap[child].distance) child++;
+        if (heap[child].distance >= last.distance) break;
+        heap[i] = heap[child];
+        i = child;
+    }
+    heap[i] = last;
+    return top;
+}
+
+/**
+ * @brief Computes the length of the shortest closed lap through a node of the reference graph.
+ *
+ * The same search as find_shortest_lap() (lap.h) on the explored map: Dijkstra labels every
+ * node with the edge its shortest path leaves the start by, and an edge whose endpoints
+ * carry different labels closes a lap.
+ *
+ * @param graph Pointer to the graph.
+ * @param x Column of the start cell.
+ * @param y Row of the start cell.
+ * @return long Length of the lap in cells, -1 if the start is no node or lies on no lap.
+ */
+long ground_truth_shortest_lap(const GroundTruthGraph *graph, int x, int y) {
+    int start_node = ground_truth_find_node(graph, x, y);
+    if (start_node < 0) return -1;
+
+    long *distances = malloc((size_t) graph->num_nodes * sizeof(long));
+    int *branches = malloc((size_t) graph->num_nodes * sizeof(int));
+    HeapEntry *heap = malloc(((size_t) graph->num_edges * 2 + 1) * sizeof(HeapEntry));
+    if (!distances || !branches || !heap) {
+        perror("Error: Failed to allocate ground truth lap search");
+        exit(EXIT_FAILURE);
+    }
+    for (int i = 0; i < graph->num_nodes; i++) {
+        distances[i] = LONG_MAX;
+        branches[i] = -1;
+    }
+
+    int size = 0;
+    distances[start_node] = 0;
+    heap_push(heap, &size, (HeapEntry) {0, start_node});
+    while (size > 0) {
+        HeapEntry entry = heap_pop(heap, &size);
+        if (entry.distance > distances[entry.node]) continue;
+
+        const GroundTruthNode *node = &graph->nodes[entry.node];
+        for (int d = 0; d < 4; d++) {
+            if (node->edges[d] < 0) continue;
+            const GroundTruthEdge *edge = &graph->edges[node->edges[d]];
+            int next = edge->from == entry.node ? edge->to : edge->from;
+            long cost = entry.distance + edge->distance;
+            if (cost < distances[next]) {
+                distances[next] = cost;
+                branches[next] = entry.node == start_node ? d : branches[entry.node];
+                heap_push(heap, &size, (HeapEntry) {cost, next});
+            }
+        }
+    }
+
+    long best = LONG_MAX;
+    for (int i = 0; i < graph->num_edges; i++) {
+        const GroundTruthEdge *edge = &graph->edges[i];
+        if (distances[edge->from] == LONG_MAX || distances[edge->to] == LONG_MAX) continue;
+
+        // Both halves must leave the start through different edges
+        int branch_from = edge->from == start_node ? (int) edge->direction : branches[edge->from];
+        int branch_to = edge->to == start_node ? (int) opposite_direction(edge->direction) : branches[edge->to];
+        if (branch_from == branch_to) continue;
+
+        long cost = distances[edge->from] + edge->distance + distances[edge->to];
+        if (cost < best) best = cost;
+    }
+
+    free(heap);
+    free(branches);
+    free(distances);
+    return best == LONG_MAX ? -1 : best;
+}
+
+/**
+ * @brief Names a cell class.
+ *
+ * @param kind The class.
+ * @return const char* Its name.
+ */
+const char *cell_class_name(CellClass kind) {
+    switch (kind) {
+        case CELL_EMPTY:
+            return "empty";
+        case CELL_CORRIDOR:
+            return "corridor";
+        case CELL_BEND:
+            return "bend";
+        case CELL_JUNCTION:
+            return "junction";
+        case CELL_DEAD_END:
+            return "dead end";
+        default:
+            return "unknown";
+    }
+}
+
+/**
+ * @brief Prints the cell classes and the size of a reference graph.
+ *
+ * @param graph Pointer to the graph.
+ * @param out Stream to write to.
+ */
+void ground_truth_report(const GroundTruthGraph *graph, FILE *out) {
+    long length = 0;
+    for (int i = 0; i < graph->num_edges; i++) length += graph->edges[i].distance;
+
+    fprintf(out, "Ground truth: %d MapPoints, %d paths, %ld cells of path\n", graph->num_nodes, graph->num_edges,
+            length);
+    for (int kind = CELL_CORRIDOR; kind < CELL_CLASS_COUNT; kind++) {
+        fprintf(out, "  %-10s %10ld cells\n", cell_class_name((CellClass) kind), graph->cells[kind]);
+    }
+}
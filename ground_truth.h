@@ -0,0 +1,86 @@
+#ifndef GROUND_TRUTH_H
+#define GROUND_TRUTH_H
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+#include "direction.h"
+
+// ======================= GROUND TRUTH ======================= //
+//
+// The reference MapPoint graph of a track, extracted offline from the whole track instead
+// of being explored: every track cell that is not a straight corridor is a node, and every
+// corridor between two nodes is an edge.
+
+// What a track cell is, judged by which of its four neighbours are track
+typedef enum {
+    CELL_EMPTY,
+    CELL_CORRIDOR,      // Two opposite neighbours
+    CELL_BEND,          // Two neighbours at a right angle
+    CELL_JUNCTION,      // Three or four neighbours
+    CELL_DEAD_END,      // One neighbour, or none
+    CELL_CLASS_COUNT
+} CellClass;
+
+/**
+ * @struct TrackBitmap
+ * @brief One bit per cell of a track, set for TRACK and START_FINISH cells.
+ *
+ * Every row is padded with a zero word on both sides and to a whole number of vector
+ * lanes, and a zero row lies above and below the track, so neighbours never need bounds
+ * checks.
+ */
+typedef struct TrackBitmap {
+    int width, height;
+    size_t words;           /**< Words per row holding cells, a multiple of the vector lanes */
+    size_t stride;          /**< Words per row including the padding */
+    uint64_t *bits;
+} TrackBitmap;
+
+/**
+ * @struct GroundTruthNode
+ * @brief A cell the car would record as a MapPoint.
+ */
+typedef struct GroundTruthNode {
+    int x, y;
+    CellClass kind;
+    int edges[4];           /**< Edge leaving towards each Direction, -1 if none */
+} GroundTruthNode;
+
+/**
+ * @struct GroundTruthEdge
+ * @brief A straight corridor between two nodes.
+ */
+typedef struct GroundTruthEdge {
+    int from, to;           /**< Node indices, from lies north or west of to */
+    int distance;           /**< Cells from one node to the other */
+    Direction direction;    /**< EAST or SOUTH, seen from the from node */
+} GroundTruthEdge;
+
+/**
+ * @struct GroundTruthGraph
+ * @brief Reference graph of a track, its nodes sorted by row, then column.
+ */
+typedef struct GroundTruthGraph {
+    GroundTruthNode *nodes;
+    int num_nodes, capacity_nodes;
+    GroundTruthEdge *edges;
+    int num_edges, capacity_edges;
+    long cells[CELL_CLASS_COUNT];   /**< Number of cells of each class */
+} GroundTruthGraph;
+
+void track_bitmap_create(TrackBitmap *bitmap);
+void track_bitmap_free(TrackBitmap *bitmap);
+
+// Classify every cell of the bitmap and build the reference graph in one pass over the rows
+void ground_truth_extract(const TrackBitmap *bitmap, GroundTruthGraph *graph);
+void ground_truth_extract_track(GroundTruthGraph *graph);
+void ground_truth_free(GroundTruthGraph *graph);
+
+int ground_truth_find_node(const GroundTruthGraph *graph, int x, int y);
+long ground_truth_shortest_lap(const GroundTruthGraph *graph, int x, int y);
+const char *cell_class_name(CellClass kind);
+void ground_truth_report(const GroundTruthGraph *graph, FILE *out);
+
+#endif // GROUND_TRUTH_H
@@ -0,0 +1,199 @@
+#include <signal.h>
+#include <time.h>
+#include "instrumentation.h"
+
+// ======================= INSTRUMENTATION ======================= //
+//
+// Counters are plain globals updated by the control loop; the planner thread is not
+// instrumented. Cycles come from the time-stamp counter where available and from the
+// monotonic clock in nanoseconds elsewhere.
+
+static volatile sig_atomic_t dump_requested = 0;
+
+#ifdef ENABLE_INSTRUMENTATION
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define INSTRUMENTATION_CLOCK "tsc"
+#else
+#define INSTRUMENTATION_CLOCK "ns"
+#endif
+
+#define PHASE_STACK_DEPTH 8
+
+/**
+ * @struct InstrumentationTotals
+ * @brief Calls and cycles accumulated for one counter or phase.
+ */
+typedef struct InstrumentationTotals {
+    uint64_t calls;
+    uint64_t cycles;
+} InstrumentationTotals;
+
+static InstrumentationTotals counters[COUNTER_COUNT];
+static InstrumentationTotals timers[TIMER_COUNT];
+
+// Active phases, innermost last
+static InstrumentationTimer phase_stack[PHASE_STACK_DEPTH];
+static uint64_t phase_start = 0;
+static int phase_depth = 0;
+
+/**
+ * @brief Reads the cycle counter.
+ *
+ * @return uint64_t Cycles, or nanoseconds on targets without a time-stamp counter.
+ */
+static uint64_t read_cycles() {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000ULL + (uint64_t) ts.tv_nsec;
+#endif
+}
+
+/**
+ * @brief Starts measuring a call of an instrumented function.
+ *
+ * @param counter The counter of the function.
+ * @return InstrumentationScope The running measurement.
+ */
+InstrumentationScope instrumentation_scope_begin(InstrumentationCounter counter) {
+    return (InstrumentationScope) {counter, read_cycles()};
+}
+
+/**
+ * @brief Finishes measuring a call, run automatically when the scope is left.
+ *
+ * @param scope Pointer to the running measurement.
+ */
+void instrumentation_scope_end(InstrumentationScope *scope) {
+    counters[scope->counter].calls++;
+    counters[scope->counter].cycles += read_cycles() - scope->start;
+}
+
+/**
+ * @brief Counts an event.
+ *
+ * @param counter The counter of the event.
+ */
+void instrumentation_count(InstrumentationCounter counter) {
+    counters[counter].calls++;
+}
+
+/**
+ * @brief Enters a phase, pausing the phase it is nested in.
+ *
+ * @param timer The phase.
+ */
+void instrumentation_phase_enter(InstrumentationTimer timer) {
+    uint64_t now = read_cycles();
+    if (phase_depth > 0) {
+        timers[phase_stack[phase_depth - 1]].cycles += now - phase_start;
+    }
+    if (phase_depth < PHASE_STACK_DEPTH) phase_stack[phase_depth++] = timer;
+    timers[timer].calls++;
+    phase_start = now;
+}
+
+/**
+ * @brief Leaves a phase and resumes the phase it is nested in.
+ *
+ * @param timer The phase, must be the innermost active one.
+ */
+void instrumentation_phase_exit(InstrumentationTimer timer) {
+    if (phase_depth == 0 || phase_stack[phase_depth - 1] != timer) return;
+
+    uint64_t now = read_cycles();
+    timers[timer].cycles += now - phase_start;
+    phase_depth--;
+    phase_start = now;
+}
+
+/**
+ * @brief Enters a phase for the rest of the enclosing scope.
+ *
+ * @param timer The phase.
+ * @return InstrumentationTimer The phase, handed back to the cleanup handler.
+ */
+InstrumentationTimer instrumentation_phase_scope_begin(InstrumentationTimer timer) {
+    instrumentation_phase_enter(timer);
+    return timer;
+}
+
+/**
+ * @brief Leaves a scoped phase, run automatically when the scope is left.
+ *
+ * @param timer Pointer to the phase.
+ */
+void instrumentation_phase_scope_end(InstrumentationTimer *timer) {
+    instrumentation_phase_exit(*timer);
+}
+
+#endif // ENABLE_INSTRUMENTATION
+
+// ======================= REPORTING ======================= //
+
+/**
+ * @brief Writes all counters and phase timers as JSON.
+ *
+ * @param out Stream to write to.
+ */
+void instrumentation_dump_json(FILE *out) {
+#ifdef ENABLE_INSTRUMENTATION
+    static const char *counter_names[COUNTER_COUNT] = {
+        "update_ultrasonic_sensors", "check_map_point_already_exists", "check_mappoints_tbd",
+        "dijkstra_push", "dijkstra_pop", "dijkstra_relaxation", "navigate_path_step",
+        "map_point_malloc", "map_point_realloc", "fundamental_path_malloc", "fundamental_path_realloc"
+    };
+    static const char *timer_names[TIMER_COUNT] = {"exploration", "replanning", "navigation", "rendering"};
+
+    fprintf(out, "{\n  \"enabled\": true,\n  \"clock\": \"%s\",\n  \"counters\": {\n", INSTRUMENTATION_CLOCK);
+    for (int i = 0; i < COUNTER_COUNT; i++) {
+        fprintf(out, "    \"%s\": {\"calls\": %llu, \"cycles\": %llu}%s\n", counter_names[i],
+                (unsigned long long) counters[i].calls, (unsigned long long) counters[i].cycles,
+                i + 1 < COUNTER_COUNT ? "," : "");
+    }
+    fprintf(out, "  },\n  \"phases\": {\n");
+    for (int i = 0; i < TIMER_COUNT; i++) {
+        fprintf(out, "    \"%s\": {\"calls\": %llu, \"cycles\": %llu}%s\n", timer_names[i],
+                (unsigned long long) timers[i].calls, (unsigned long long) timers[i].cycles,
+                i + 1 < TIMER_COUNT ? "," : "");
+    }
+    fprintf(out, "  }\n}\n");
+#else
+    fprintf(out, "{\n  \"enabled\": false\n}\n");
+#endif
+    fflush(out);
+}
+
+/**
+ * @brief Signal handler: only flags the request, the dump happens in the control loop.
+ *
+ * @param signal_number Unused.
+ */
+static void request_dump(int signal_number) {
+    (void) signal_number;
+    dump_requested = 1;
+}
+
+/**
+ * @brief Makes SIGUSR1 dump the counters at the next tick.
+ */
+void instrumentation_install_signal_handler() {
+#ifdef SIGUSR1
+    signal(SIGUSR1, request_dump);
+#endif
+}
+
+/**
+ * @brief Dumps the counters if a signal asked for it since the last poll.
+ *
+ * @param out Stream to write to.
+ */
+void instrumentation_poll_signal(FILE *out) {
+    if (!dump_requested) return;
+    dump_requested = 0;
+    instrumentation_dump_json(out);
+}
@@ -0,0 +1,84 @@
+#ifndef INSTRUMENTATION_H
+#define INSTRUMENTATION_H
+
+#include <stdio.h>
+#include <stdint.h>
+
+// Hot-path counters and per-phase timers. Built only with -DENABLE_INSTRUMENTATION
+// (cmake -DENABLE_INSTRUMENTATION=ON); otherwise every macro below compiles to nothing.
+
+// Instrumented functions and events
+typedef enum {
+    COUNTER_UPDATE_ULTRASONIC_SENSORS,
+    COUNTER_CHECK_MAP_POINT_ALREADY_EXISTS,
+    COUNTER_CHECK_MAPPOINTS_TBD,
+    COUNTER_DIJKSTRA_PUSH,
+    COUNTER_DIJKSTRA_POP,
+    COUNTER_DIJKSTRA_RELAXATION,
+    COUNTER_NAVIGATE_STEP,
+    COUNTER_MAP_POINT_MALLOC,
+    COUNTER_MAP_POINT_REALLOC,
+    COUNTER_FUNDAMENTAL_PATH_MALLOC,
+    COUNTER_FUNDAMENTAL_PATH_REALLOC,
+    COUNTER_COUNT
+} InstrumentationCounter;
+
+// Phases of a run; time is charged to the innermost active phase only
+typedef enum {
+    TIMER_EXPLORATION,
+    TIMER_REPLANNING,
+    TIMER_NAVIGATION,
+    TIMER_RENDERING,
+    TIMER_COUNT
+} InstrumentationTimer;
+
+#ifdef ENABLE_INSTRUMENTATION
+
+/**
+ * @struct InstrumentationScope
+ * @brief A running measurement of one instrumented function.
+ */
+typedef struct InstrumentationScope {
+    InstrumentationCounter counter;
+    uint64_t start;
+} InstrumentationScope;
+
+// Count a call and its cycles until the end of the enclosing scope
+#define INSTRUMENT_FUNCTION(counter) \
+    InstrumentationScope instrumentation_scope __attribute__((cleanup(instrumentation_scope_end))) = \
+        instrumentation_scope_begin(counter)
+
+// Count an event
+#define INSTRUMENT_COUNT(counter) instrumentation_count(counter)
+
+// Charge the time until INSTRUMENT_PHASE_END, or the end of the enclosing scope, to a phase
+#define INSTRUMENT_PHASE_BEGIN(timer) instrumentation_phase_enter(timer)
+#define INSTRUMENT_PHASE_END(timer) instrumentation_phase_exit(timer)
+#define INSTRUMENT_PHASE(timer) \
+    InstrumentationTimer instrumentation_phase __attribute__((cleanup(instrumentation_phase_scope_end))) = \
+        instrumentation_phase_scope_begin(timer)
+
+InstrumentationScope instrumentation_scope_begin(InstrumentationCounter counter);
+void instrumentation_scope_end(InstrumentationScope *scope);
+void instrumentation_count(InstrumentationCounter counter);
+void instrumentation_phase_enter(InstrumentationTimer timer);
+void instrumentation_phase_exit(InstrumentationTimer timer);
+InstrumentationTimer instrumentation_phase_scope_begin(InstrumentationTimer timer);
+void instrumentation_phase_scope_end(InstrumentationTimer *timer);
+
+#else
+
+#define INSTRUMENT_FUNCTION(counter) ((void) 0)
+#define INSTRUMENT_COUNT(counter) ((void) 0)
+#define INSTRUMENT_PHASE_BEGIN(timer) ((void) 0)
+#define INSTRUMENT_PHASE_END(timer) ((void) 0)
+#define INSTRUMENT_PHASE(timer) ((void) 0)
+
+#endif // ENABLE_INSTRUMENTATION
+
+// Reporting, available in every build
+void instrumentation_install_signal_handler();
+void instrumentation_poll_signal(FILE *out);
+void instrumentation_dump_json(FILE *out);
+
+#endif // INSTRUMENTATION_H
@@ -0,0 +1,349 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <limits.h>
+#include "lap.h"
+#include "globals.h"
+#include "pruning.h"
+#include "alloc_tracker.h"
+#include "static_pools.h"
+#include "min_heap.h"
+#include "track_files_PRIVATE/track_navigation.h"
+
+// ======================= LAP SOLVER ======================= //
+
+#ifdef STATIC_POOLS
+// Scratch arrays of the lap search, one entry per MapPoint a map can hold
+static int lap_distances[POOL_MAP_POINTS];
+static int lap_branches[POOL_MAP_POINTS];
+static FundamentalPath *lap_parents[POOL_MAP_POINTS];
+static bool lap_done[POOL_MAP_POINTS];
+static MinHeapEntry lap_heap[POOL_MAP_POINTS * POOL_PATHS_PER_MAP_POINT + 1];  // One push per relaxed path
+static const int lap_heap_capacity = POOL_MAP_POINTS * POOL_PATHS_PER_MAP_POINT + 1;
+#else
+// Scratch arrays of the lap search, kept between searches since it runs at every MapPoint
+static int *lap_distances = NULL;
+static int *lap_branches = NULL;
+static FundamentalPath **lap_parents = NULL;
+static bool *lap_done = NULL;
+static int lap_capacity = 0;
+static MinHeapEntry *lap_heap = NULL;     // One push per relaxed path, plus the start
+static int lap_heap_capacity = 0;
+#endif
+
+/**
+ * @brief Grows the priority queue of the lap search to hold the given number of entries.
+ *
+ * @param entries Number of entries.
+ */
+static void reserve_lap_heap(int entries) {
+#ifdef STATIC_POOLS
+    // A MapPoint never holds more paths than its static slab
+    (void) entries;
+#else
+    if (entries <= lap_heap_capacity) return;
+
+    MinHeapEntry *heap = tracked_realloc(ALLOC_SEARCH, lap_heap, entries * sizeof(MinHeapEntry));
+    if (!heap) {
+        perror("Error: Failed to allocate lap search scratch space");
+        exit(EXIT_FAILURE);
+    }
+    lap_heap = heap;
+    lap_heap_capacity = entries;
+#endif
+}
+
+/**
+ * @brief Grows the scratch arrays of the lap search to hold the given number of MapPoints.
+ *
+ * @param map_points Number of MapPoints.
+ */
+void lap_reserve(int map_points) {
+#ifdef STATIC_POOLS
+    // A map never holds more MapPoints than the static arrays
+    (void) map_points;
+#else
+    if (map_points <= lap_capacity) return;
+
+    int *distances = tracked_realloc(ALLOC_SEARCH, lap_distances, map_points * sizeof(int));
+    if (distances) lap_distances = distances;
+    int *branches = tracked_realloc(ALLOC_SEARCH, lap_branches, map_points * sizeof(int));
+    if (branches) lap_branches = branches;
+    FundamentalPath **parents = tracked_realloc(ALLOC_SEARCH, lap_parents, map_points * sizeof(FundamentalPath *));
+    if (parents) lap_parents = parents;
+    bool *done = tracked_realloc(ALLOC_SEARCH, lap_done, map_points * sizeof(bool));
+    if (done) lap_done = done;
+    if (!distances || !branches || !parents || !done) {
+        perror("Error: Failed to allocate lap search scratch space");
+        exit(EXIT_FAILURE);
+    }
+    lap_capacity = map_points;
+#endif
+    // A grid cell has at most four neighbours, so a MapPoint has at most four paths
+    reserve_lap_heap(4 * map_points + 1);
+}
+
+/**
+ * @brief Finds the MapPoint at the start/finish location.
+ *
+ * @return MapPoint* Pointer to the start MapPoint, or NULL if it was not recorded yet.
+ */
+MapPoint *find_start_map_point() {
+    for (int i = 0; i < num_map_points_all; i++) {
+        if (map_points_all[i]->location.x == start.x && map_points_all[i]->location.y == start.y) {
+            return map_points_all[i];
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief Finds the FundamentalPath from one MapPoint to another with the given length.
+ *
+ * @param from Pointer to the MapPoint the path leaves from.
+ * @param to Pointer to the MapPoint the path leads to.
+ * @param distance Required length of the path.
+ * @return FundamentalPath* Pointer to the path, or NULL if there is none.
+ */
+static FundamentalPath *find_edge(MapPoint *from, MapPoint *to, int distance) {
+    for (int i = 0; i < from->numberOfPaths; i++) {
+        if (fp_end(&from->paths[i]) == to && from->paths[i].distance == distance) {
+            return &from->paths[i];
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief Finds the index of the path that drives the given FundamentalPath in reverse.
+ *
+ * @param path Pointer to the FundamentalPath.
+ * @return int Index in path->end->paths, or -1 if there is none.
+ */
+static int reverse_edge_index(const FundamentalPath *path) {
+    MapPoint *end = fp_end(path);
+    for (int i = 0; i < end->numberOfPaths; i++) {
+        if (fp_end(&end->paths[i]) == fp_start(path) &&
+            end->paths[i].direction == opposite_direction(path->direction)) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+/**
+ * @brief Finds the shortest known closed lap through the start MapPoint.
+ *
+ * Runs Dijkstra from the start over the active graph and labels every MapPoint with the
+ * start edge its shortest path begins with. An edge whose endpoints carry different labels
+ * closes a cycle through the start; the cheapest one is the shortest lap.
+ *
+ * @return Path* The lap, starting and ending at the start MapPoint (release with
+ *               path_free()), or NULL if no lap is known yet.
+ */
+Path *find_shortest_lap() {
+    MapPoint *start_point = find_start_map_point();
+    if (!start_point || num_map_points_all < 2) return NULL;
+
+    lap_reserve(num_map_points_all);
+    int *distances = lap_distances;
+    int *branches = lap_branches;
+    FundamentalPath **parents = lap_parents;
+    bool *done = lap_done;
+
+    int paths = 0;
+    for (int i = 0; i < num_map_points_all; i++) {
+        distances[i] = INT_MAX;
+        branches[i] = -1;
+        parents[i] = NULL;
+        done[i] = false;
+        paths += map_points_all[i]->numberOfPaths;
+    }
+    distances[start_point->id] = 0;
+
+    // === DIJKSTRA FROM THE START === //
+    // Every relaxed path pushes its end at most once, since a MapPoint is settled only once
+    reserve_lap_heap(paths + 1);
+    MinHeap queue;
+    min_heap_init(&queue, lap_heap, lap_heap_capacity);
+    min_heap_push(&queue, 0, start_point->id);
+
+    int key, id;
+    while (min_heap_pop(&queue, &key, &id)) {
+        if (done[id] || key > distances[id]) continue;
+        MapPoint *current = map_points_all[id];
+        done[id] = true;
+
+        for (int i = 0; i < current->numberOfPaths; i++) {
+            FundamentalPath *path = &current->paths[i];
+            if (!fp_is_active_edge(path)) continue;
+
+            int new_cost = distances[current->id] + path->distance;
+            MapPoint *end = fp_end(path);
+            if (new_cost < distances[end->id]) {
+                distances[end->id] = new_cost;
+                parents[end->id] = path;
+                branches[end->id] = (current == start_point) ? i : branches[current->id];
+                min_heap_push(&queue, new_cost, end->id);
+            }
+        }
+    }
+
+    // === CLOSING EDGES === //
+    int best_cost = INT_MAX;
+    FundamentalPath *best_edge = NULL;
+
+    for (int i = 0; i < num_map_points_all; i++) {
+        MapPoint *u = map_points_all[i];
+        if (distances[u->id] == INT_MAX) continue;
+
+        for (int j = 0; j < u->numberOfPaths; j++) {
+            FundamentalPath *path = &u->paths[j];
+            if (!fp_is_active_edge(path) || distances[fp_end(path)->id] == INT_MAX) continue;
+
+            // Both halves must leave the start through different edges
+            int branch_u = (u == start_point) ? j : branches[u->id];
+            int branch_v = (fp_end(path) == start_point) ? reverse_edge_index(path) : branches[fp_end(path)->id];
+            if (branch_u == branch_v) continue;
+
+            int cost = distances[u->id] + path->distance + distances[fp_end(path)->id];
+            if (cost < best_cost) {
+                best_cost = cost;
+                best_edge = path;
+            }
+        }
+    }
+
+    Path *lap = NULL;
+    if (best_edge) {
+        // Count the route: start ~> u, u -> v, v ~> start
+        int length = 1;
+        for (MapPoint *mp = fp_start(best_edge); mp != start_point; mp = fp_start(parents[mp->id])) length++;
+        for (MapPoint *mp = fp_end(best_edge); mp != start_point; mp = fp_start(parents[mp->id])) length++;
+
+        lap = path_create(start_point, start_point, length);
+        if (lap) lap->totalDistance = best_cost;
+    }
+
+    if (lap) {
+        // First half follows the parents backwards from u
+        int index = 0;
+        for (MapPoint *mp = fp_start(best_edge); mp != start_point; mp = fp_start(parents[mp->id])) index++;
+        int position = index;
+        for (MapPoint *mp = fp_start(best_edge); mp != start_point; mp = fp_start(parents[mp->id])) {
+            lap->route[--position] = parents[mp->id];
+        }
+        lap->route[index++] = best_edge;
+
+        // Second half drives the parents of v in reverse
+        for (MapPoint *mp = fp_end(best_edge); mp != start_point; mp = fp_start(parents[mp->id])) {
+            FundamentalPath *tree_edge = parents[mp->id];
+            FundamentalPath *reverse = find_edge(mp, fp_start(tree_edge), tree_edge->distance);
+            if (!reverse) {
+                path_free(lap);
+                lap = NULL;
+                break;
+            }
+            lap->route[index++] = reverse;
+        }
+        if (lap) lap->routeLength = index;
+    }
+
+    return lap;
+}
+
+// ======================= EXPLORATION BOUND ======================= //
+
+/**
+ * @brief Computes a lower bound on the length of any lap that uses an unexplored FundamentalPath.
+ *
+ * A lap through the unexplored path of MapPoint f must drive from the start to f, take at
+ * least one step into the unexplored path and return to the start from there. On the grid,
+ * each of those legs is at least as long as its Manhattan distance.
+ *
+ * @return int The lower bound, or INT_MAX if there are no unexplored paths left.
+ */
+int lap_lower_bound_unexplored() {
+    int bound = INT_MAX;
+
+    for (int i = 0; i < num_map_points_all; i++) {
+        MapPoint *mp = map_points_all[i];
+
+        for (int j = 0; j < mp->numberOfPaths; j++) {
+            if (fp_end(&mp->paths[j]) != NULL) continue;
+
+            // First cell of the unexplored path
+            Location next = mp_location(mp);
+            switch (mp->paths[j].direction) {
+                case NORTH: next.y--; break;
+                case EAST:  next.x++; break;
+                case SOUTH: next.y++; break;
+                case WEST:  next.x--; break;
+                default: break;
+            }
+
+            int candidate = calculate_distance(start, mp_location(mp)) + 1 + calculate_distance(next, start);
+            if (candidate < bound) bound = candidate;
+        }
+    }
+
+    return bound;
+}
+
+/**
+ * @brief Checks if exploration can stop because no unexplored FundamentalPath can lead
+ *        to a shorter lap than the best known one.
+ *
+ * @return bool True if a lap is known and it is no longer than the lower bound of every
+ *              lap through unexplored territory.
+ */
+bool lap_bound_exploration_complete() {
+    Path *lap = find_shortest_lap();
+    if (!lap) return false;
+
+    int best_lap = lap->totalDistance;
+    path_free(lap);
+
+    return best_lap <= lap_lower_bound_unexplored();
+}
+
+// ======================= RACING ======================= //
+
+/**
+ * @brief Drives the car once around a lap.
+ *
+ * @param lap Pointer to the lap, starting and ending at the start MapPoint.
+ */
+static void drive_lap(const Path *lap) {
+    for (int i = 0; i < lap->routeLength; i++) {
+        FundamentalPath *step = lap->route[i];
+
+        // Rotate the car to align with the required direction and move along the path
+        current_car.current_orientation = step->direction;
+        for (int j = 0; j < step->distance; j++) {
+            move_forward();
+            print_grid();  // Visualize movement on the grid
+        }
+
+        // Update the car's position after completing the movement
+        current_car.current_location = mp_location(fp_end(step));
+    }
+}
+
+/**
+ * @brief Drives the shortest known lap the given number of times, starting at the start.
+ *
+ * @param laps Number of laps to drive.
+ * @return bool True if a lap was known and driven, false otherwise.
+ */
+bool race_shortest_lap(int laps) {
+    Path *lap = find_shortest_lap();
+    if (!lap) return false;
+
+    for (int i = 0; i < laps; i++) {
+        drive_lap(lap);
+    }
+
+    printf("Completed %d laps of length %d\n", laps, lap->totalDistance);
+    path_free(lap);
+    return true;
+}
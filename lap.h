@@ -0,0 +1,26 @@
+#ifndef LAP_H
+#define LAP_H
+
+#include <stdbool.h>
+#include "algorithm_structs_PUBLIC/MapPoint.h"
+#include "algorithm_structs_PUBLIC/Path.h"
+
+// Find the MapPoint at the start/finish location
+MapPoint *find_start_map_point();
+
+// Find the shortest known closed lap through the start MapPoint
+Path *find_shortest_lap();
+
+// Preallocate the scratch arrays of the lap search
+void lap_reserve(int map_points);
+
+// Lower bound on the length of any lap that uses an unexplored FundamentalPath
+int lap_lower_bound_unexplored();
+
+// Check if no unexplored FundamentalPath can lead to a shorter lap than the best known one
+bool lap_bound_exploration_complete();
+
+// Drive the shortest known lap the given number of times
+bool race_shortest_lap(int laps);
+
+#endif // LAP_H
@@ -0,0 +1,145 @@
+#include <string.h>
+#include "latency.h"
+
+// ======================= LATENCY HISTOGRAMS ======================= //
+//
+// HDR-style histograms: values below 2^LATENCY_SUB_BUCKET_BITS get a bucket each, larger
+// values are bucketed by their highest set bit and the next bits below it. Every bucket
+// is then at most 1/16 of its value wide, whatever the magnitude.
+
+#define LATENCY_SUB_BUCKET_BITS 5
+#define LATENCY_SUB_BUCKETS     (1 << LATENCY_SUB_BUCKET_BITS)
+#define LATENCY_HALF_BUCKETS    (LATENCY_SUB_BUCKETS / 2)
+#define LATENCY_BUCKETS         ((64 - LATENCY_SUB_BUCKET_BITS + 1) * LATENCY_HALF_BUCKETS + LATENCY_HALF_BUCKETS)
+
+/**
+ * @struct LatencyHistogram
+ * @brief Counts of recorded durations per bucket.
+ */
+typedef struct LatencyHistogram {
+    uint64_t buckets[LATENCY_BUCKETS];
+    uint64_t count;
+    uint64_t max;
+} LatencyHistogram;
+
+bool latency_enabled = false;
+
+static LatencyHistogram histograms[LATENCY_COUNT];
+static uint64_t tick_budget = 0;          // 0 if ticks are not checked against a budget
+static uint64_t ticks_over_budget = 0;
+
+/**
+ * @brief Finds the bucket of a duration.
+ *
+ * @param value Duration in ns.
+ * @return int Index of the bucket.
+ */
+static int bucket_index(uint64_t value) {
+    if (value < LATENCY_SUB_BUCKETS) return (int) value;
+
+    int shift = 63 - __builtin_clzll(value) - (LATENCY_SUB_BUCKET_BITS - 1);
+    return shift * LATENCY_HALF_BUCKETS + (int) (value >> shift);
+}
+
+/**
+ * @brief Gives the largest duration that falls into a bucket.
+ *
+ * @param index Index of the bucket.
+ * @return uint64_t Duration in ns.
+ */
+static uint64_t bucket_upper_bound(int index) {
+    if (index < LATENCY_SUB_BUCKETS) return (uint64_t) index;
+
+    int shift = index / LATENCY_HALF_BUCKETS - 1;
+    uint64_t mantissa = (uint64_t) (index - shift * LATENCY_HALF_BUCKETS);
+    return ((mantissa + 1) << shift) - 1;
+}
+
+/**
+ * @brief Computes a percentile of a histogram.
+ *
+ * @param histogram Pointer to the histogram.
+ * @param percentile Percentile between 0 and 100.
+ * @return uint64_t Duration in ns, never above the largest recorded one.
+ */
+static uint64_t histogram_percentile(const LatencyHistogram *histogram, double percentile) {
+    if (histogram->count == 0) return 0;
+
+    uint64_t rank = (uint64_t) (percentile / 100.0 * (double) histogram->count + 0.5);
+    if (rank == 0) rank = 1;
+
+    uint64_t seen = 0;
+    for (int i = 0; i < LATENCY_BUCKETS; i++) {
+        seen += histogram->buckets[i];
+        if (seen >= rank) {
+            uint64_t bound = bucket_upper_bound(i);
+            return bound < histogram->max ? bound : histogram->max;
+        }
+    }
+    return histogram->max;
+}
+
+/**
+ * @brief Starts recording latencies, clearing earlier recordings.
+ *
+ * @param tick_budget_ns Ticks taking longer are reported as they happen, 0 to disable.
+ */
+void latency_start(uint64_t tick_budget_ns) {
+    memset(histograms, 0, sizeof(histograms));
+    tick_budget = tick_budget_ns;
+    ticks_over_budget = 0;
+    latency_enabled = true;
+}
+
+/**
+ * @brief Adds a duration to a histogram.
+ *
+ * @param id The histogram.
+ * @param duration_ns Duration in ns.
+ */
+void latency_record(LatencyHistogramId id, uint64_t duration_ns) {
+    LatencyHistogram *histogram = &histograms[id];
+    histogram->buckets[bucket_index(duration_ns)]++;
+    histogram->count++;
+    if (duration_ns > histogram->max) histogram->max = duration_ns;
+}
+
+/**
+ * @brief Adds the duration of a tick and flags it if it exceeded the budget.
+ *
+ * @param tick Number of the tick.
+ * @param duration_ns Duration in ns.
+ */
+void latency_record_tick(unsigned long tick, uint64_t duration_ns) {
+    latency_record(LATENCY_TICK, duration_ns);
+
+    if (tick_budget > 0 && duration_ns > tick_budget) {
+        ticks_over_budget++;
+        fprintf(stderr, "Tick %lu took %.1f us, over the budget of %.1f us\n",
+                tick, (double) duration_ns / 1000.0, (double) tick_budget / 1000.0);
+    }
+}
+
+/**
+ * @brief Prints p50, p99, p99.9 and the maximum of every histogram.
+ *
+ * @param out Stream to write to.
+ */
+void latency_report(FILE *out) {
+    static const char *names[LATENCY_COUNT] = {"tick", "existing_map_point", "shortest_path_to_tbd"};
+
+    fprintf(out, "%-22s %8s %10s %10s %10s %10s\n", "Latency (us)", "count", "p50", "p99", "p99.9", "max");
+    for (int i = 0; i < LATENCY_COUNT; i++) {
+        const LatencyHistogram *histogram = &histograms[i];
+        fprintf(out, "%-22s %8llu %10.1f %10.1f %10.1f %10.1f\n", names[i],
+                (unsigned long long) histogram->count,
+                (double) histogram_percentile(histogram, 50.0) / 1000.0,
+                (double) histogram_percentile(histogram, 99.0) / 1000.0,
+                (double) histogram_percentile(histogram, 99.9) / 1000.0,
+                (double) histogram->max / 1000.0);
+    }
+    if (tick_budget > 0) {
+        fprintf(out, "%llu ticks exceeded the budget of %.1f us\n",
+                (unsigned long long) ticks_over_budget, (double) tick_budget / 1000.0);
+    }
+}
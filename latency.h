@@ -0,0 +1,24 @@
+#ifndef LATENCY_H
+#define LATENCY_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+// Latencies recorded in a log-bucketed histogram each
+typedef enum {
+    LATENCY_TICK,                   // One iteration of the exploration loop, without rendering and delay
+    LATENCY_EXISTING_MAP_POINT,     // existing_map_point_algorithm()
+    LATENCY_SHORTEST_PATH,          // find_shortest_path_to_mappoint_tbd()
+    LATENCY_COUNT
+} LatencyHistogramId;
+
+// True while latencies are being recorded
+extern bool latency_enabled;
+
+void latency_start(uint64_t tick_budget_ns);
+void latency_record(LatencyHistogramId id, uint64_t duration_ns);
+void latency_record_tick(unsigned long tick, uint64_t duration_ns);
+void latency_report(FILE *out);
+
+#endif // LATENCY_H
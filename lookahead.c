@@ -0,0 +1,152 @@
+#include <stdio.h>
+#include <limits.h>
+#include "lookahead.h"
+#include "map_version.h"
+#include "ground_truth.h"
+#include "policy.h"
+#include "track_files_PRIVATE/track_grid.h"
+
+// Reference graph of the track the last search ran on, rebuilt when the track changes
+static GroundTruthGraph oracle;
+static uint64_t oracle_hash = 0;
+static bool oracle_valid = false;
+static long oracle_mean_distance = 1;   // Mean corridor length, the estimated cost of a frontier left over
+
+/**
+ * @brief Gets the reference graph of the current track.
+ *
+ * Interleaved simulations of the same track share it, since only the contents count.
+ *
+ * @return const GroundTruthGraph* The reference graph.
+ */
+static const GroundTruthGraph *reference_graph() {
+    uint64_t hash = track_grid_hash();
+    if (oracle_valid && hash == oracle_hash) return &oracle;
+
+    if (oracle_valid) ground_truth_free(&oracle);
+    ground_truth_extract_track(&oracle);
+    oracle_hash = hash;
+    oracle_valid = true;
+
+    long total = 0;
+    for (int i = 0; i < oracle.num_edges; i++) total += oracle.edges[i].distance;
+    oracle_mean_distance = oracle.num_edges > 0 ? (total + oracle.num_edges - 1) / oracle.num_edges : 1;
+    return &oracle;
+}
+
+/**
+ * @brief Drives an unexplored path in a fork, revealing the MapNode at its end.
+ *
+ * @param version Pointer to the fork.
+ * @param graph Pointer to the reference graph.
+ * @param id ID of the MapNode the path leaves from.
+ * @param direction Direction of the path.
+ * @param cost Pointer to add the cells driven to.
+ * @return int ID of the MapNode the car ends at, INT_MIN if the static pools are exhausted.
+ */
+static int reveal_path(MapVersion *version, const GroundTruthGraph *graph, int id, Direction direction, long *cost) {
+    Location location = map_version_get(version, id)->location;
+    int node = ground_truth_find_node(graph, location.x, location.y);
+    int edge = node >= 0 ? graph->nodes[node].edges[direction] : -1;
+
+    // A MapPoint the reference graph does not know: close the path without driving it
+    if (edge < 0) return map_version_set_path(version, id, direction, MAP_EDGE_NONE, 0) ? id : INT_MIN;
+
+    const GroundTruthEdge *corridor = &graph->edges[edge];
+    const GroundTruthNode *other = &graph->nodes[corridor->from == node ? corridor->to : corridor->from];
+    Location other_location = {other->x, other->y};
+    int end = map_version_find(version, other_location);
+    if (end < 0) {
+        int ends[4], distances[4] = {0, 0, 0, 0};
+        for (int d = 0; d < 4; d++) ends[d] = other->edges[d] >= 0 ? MAP_EDGE_UNEXPLORED : MAP_EDGE_NONE;
+        end = version->num_nodes;
+        if (!map_version_set_node(version, end, other_location, ends, distances)) return INT_MIN;
+    }
+
+    if (!map_version_set_path(version, id, direction, end, corridor->distance) ||
+        !map_version_set_path(version, end, opposite_direction(direction), id, corridor->distance)) {
+        return INT_MIN;
+    }
+    *cost += corridor->distance;
+    return end;
+}
+
+/**
+ * @brief Plays out an exploration on a fork: unexplored paths of the current MapNode first,
+ *        otherwise a route to the closest frontier MapNode.
+ *
+ * @param version Pointer to the fork, edited by the play-out.
+ * @param graph Pointer to the reference graph.
+ * @param id ID of the MapNode the car is at.
+ * @return long Cells driven plus an estimate for the frontier left over, LONG_MAX if the
+ *              static pools are exhausted.
+ */
+static long play_out(MapVersion *version, const GroundTruthGraph *graph, int id) {
+    long cost = 0;
+    for (int step = 0; step < LOOKAHEAD_DEPTH && version->num_frontier > 0; step++) {
+        const MapNode *node = map_version_get(version, id);
+        int direction = 0;
+        while (direction < 4 && node->end[direction] != MAP_EDGE_UNEXPLORED) direction++;
+
+        if (direction < 4) {
+            id = reveal_path(version, graph, id, (Direction) direction, &cost);
+            if (id == INT_MIN) return LONG_MAX;
+            continue;
+        }
+
+        int distance;
+        int target = map_version_nearest_frontier(version, id, &distance);
+        if (target < 0) break;
+        cost += distance;
+        id = target;
+    }
+    return cost + version->num_frontier * oracle_mean_distance;
+}
+
+/**
+ * @brief Preallocates the map versions the play-outs work on, and reads the reference graph
+ *        of the current track if the lookahead explores it.
+ *
+ * @param max_map_points Upper bound on the MapPoints of the map.
+ * @param maps Number of maps explored side by side, each with its own live version.
+ */
+void lookahead_reserve(int max_map_points, int maps) {
+    if (exploration_policy->oracle) reference_graph();
+    // A play-out reveals at most one MapNode per step, and a revealed path edits up to three MapNodes
+    map_version_reserve(max_map_points + LOOKAHEAD_DEPTH + 1, 3 * (LOOKAHEAD_DEPTH + 1), maps);
+}
+
+/**
+ * @brief Plays out every candidate direction at a MapPoint on its own fork of the live map.
+ *
+ * @param at Pointer to the MapPoint the car stands on.
+ * @param candidates Directions of unexplored paths the car can take, best first on a tie.
+ * @param count Number of candidates.
+ * @return int Index of the cheapest candidate, -1 if the map could not be forked.
+ */
+int lookahead_best_direction(const MapPoint *at, const Direction candidates[], int count) {
+    if (!map_version_sync_live() || !map_version_get(&live_map_version, at->id)) return -1;
+    const GroundTruthGraph *graph = reference_graph();
+
+    int best = -1;
+    long best_cost = LONG_MAX;
+    for (int i = 0; i < count; i++) {
+        MapVersion fork;
+        map_version_fork(&live_map_version, &fork);
+        long cost = 0;
+        int end = reveal_path(&fork, graph, at->id, candidates[i], &cost);
+        if (end != INT_MIN) {
+            long rest = play_out(&fork, graph, end);
+            cost = rest == LONG_MAX ? LONG_MAX : cost + rest;
+        } else {
+            cost = LONG_MAX;
+        }
+        map_version_release(&fork);
+
+        if (cost < best_cost) {
+            best_cost = cost;
+            best = i;
+        }
+    }
+    return best;
+}
@@ -0,0 +1,23 @@
+#ifndef LOOKAHEAD_H
+#define LOOKAHEAD_H
+
+#include "globals.h"
+
+// ======================= LOOKAHEAD ======================= //
+//
+// What-if search at a MapPoint with several unexplored paths: every choice is played out on
+// its own fork of the explored map (map_version.h). What lies behind an unexplored path is
+// read from the reference graph of the track (ground_truth.h), so the search knows the
+// track in advance: it measures what looking ahead is worth in simulation and tournaments,
+// a car on an unknown track cannot use it. The policy is marked as an oracle (policy.h), so
+// tournaments list it below the ranking of the real explorers.
+
+#define LOOKAHEAD_DEPTH 24  // Paths explored or routes driven per played-out choice
+
+// Pick the direction whose play-out explores the map for the fewest cells, -1 if none works
+int lookahead_best_direction(const MapPoint *at, const Direction candidates[], int count);
+
+// Preallocate the map versions of the play-outs
+void lookahead_reserve(int max_map_points, int maps);
+
+#endif // LOOKAHEAD_H
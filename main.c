@@ -1,17 +1,308 @@
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
 #include "globals.h"
 #include "exploration.h"
+#include "planner.h"
+#include "pipeline.h"
+#include "simulation.h"
+#include "map_snapshot.h"
+#include "lap.h"
+#include "checkpoint.h"
+#include "telemetry.h"
+#include "replay.h"
+#include "instrumentation.h"
+#include "latency.h"
+#include "trace.h"
+#include "perf_counters.h"
+#include "alloc_tracker.h"
+#include "static_pools.h"
+#include "ground_truth.h"
+#include "scoreboard.h"
+#include "policy.h"
+#include "tournament.h"
+#include "noise.h"
+#include "montecarlo.h"
+#include "occupancy.h"
+#include "fleet.h"
 #include "track_files_PRIVATE//track_generation.h"
 
-int main() {
+/**
+ * @brief Stops the hardware counters and prints them, adding them to a totals file if given.
+ *
+ * @param totals_file Path of the totals file of a batch of runs, NULL for none.
+ */
+static void report_perf_counters(const char *totals_file) {
+    perf_counters_stop();
+    perf_counters_report(stdout);
+    if (totals_file) perf_counters_merge_totals(totals_file);
+}
+
+int main(int argc, char *argv[]) {
+    bool async_planner = false;
+    bool pipeline = false;
+    int simulations = 0;
+    const char *map_file = NULL;
+    const char *checkpoint_file = NULL;
+    const char *resume_file = NULL;
+    unsigned long checkpoint_interval = 10;
+    const char *telemetry_file = NULL;
+    const char *record_file = NULL;
+    const char *replay_file = NULL;
+    unsigned long keyframe_interval = 1000;
+    unsigned long seek_tick = 0;
+    bool render = false;
+    const char *stats_file = NULL;
+    bool latency = false;
+    unsigned long tick_budget_us = 0;
+    const char *trace_file = NULL;
+    bool perf = false;
+    const char *perf_totals_file = NULL;
+    bool alloc_stats = false;
+    bool ground_truth = false;
+    bool score = false;
+    const char *score_totals_file = NULL;
+    bool tournament = false;
+    NoiseModel noise = {0.0, 0.0, 0.0, 0.0};
+    uint64_t noise_seed = 1;
+    int monte_carlo_episodes = 0;
+    int fleet_cars = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--async-planner") == 0) {
+            async_planner = true;  // Plan routes on a separate thread
+        } else if (strcmp(argv[i], "--pipeline") == 0) {
+            pipeline = true;  // Sense, decide and actuate on separate threads
+        } else if (strcmp(argv[i], "--simulations") == 0 && i + 1 < argc) {
+            simulations = atoi(argv[++i]);  // Step headless simulations instead
+        } else if (strcmp(argv[i], "--map") == 0 && i + 1 < argc) {
+            map_file = argv[++i];  // Reuse or save the explored map
+        } else if (strcmp(argv[i], "--checkpoint") == 0 && i + 1 < argc) {
+            checkpoint_file = argv[++i];  // Periodically save the exploration state
+        } else if (strcmp(argv[i], "--checkpoint-interval") == 0 && i + 1 < argc) {
+            checkpoint_interval = strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--resume") == 0 && i + 1 < argc) {
+            resume_file = argv[++i];  // Continue an interrupted exploration
+        } else if (strcmp(argv[i], "--telemetry") == 0 && i + 1 < argc) {
+            telemetry_file = argv[++i];  // Record a binary telemetry log
+        } else if (strcmp(argv[i], "--record") == 0 && i + 1 < argc) {
+            record_file = argv[++i];  // Record the run for replay
+        } else if (strcmp(argv[i], "--keyframe-interval") == 0 && i + 1 < argc) {
+            keyframe_interval = strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--replay") == 0 && i + 1 < argc) {
+            replay_file = argv[++i];  // Replay a recorded run
+        } else if (strcmp(argv[i], "--seek") == 0 && i + 1 < argc) {
+            seek_tick = strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--render") == 0) {
+            render = true;
+        } else if (strcmp(argv[i], "--stats") == 0 && i + 1 < argc) {
+            stats_file = argv[++i];  // Write the instrumentation counters, "-" for stderr
+        } else if (strcmp(argv[i], "--latency") == 0) {
+            latency = true;  // Report latency percentiles of the control loop
+        } else if (strcmp(argv[i], "--tick-budget-us") == 0 && i + 1 < argc) {
+            tick_budget_us = strtoul(argv[++i], NULL, 10);  // Flag ticks taking longer
+            latency = true;
+        } else if (strcmp(argv[i], "--trace") == 0 && i + 1 < argc) {
+            trace_file = argv[++i];  // Write a Chrome/Perfetto trace of the exploration
+        } else if (strcmp(argv[i], "--perf") == 0) {
+            perf = true;  // Count hardware events around the hot call sites
+        } else if (strcmp(argv[i], "--perf-totals") == 0 && i + 1 < argc) {
+            perf_totals_file = argv[++i];  // Aggregate the counts of a batch of runs
+            perf = true;
+        } else if (strcmp(argv[i], "--presize") == 0) {
+            presize_explorations = true;  // Preallocate so no tick allocates, in every mode
+        } else if (strcmp(argv[i], "--alloc-stats") == 0) {
+            alloc_stats = true;  // Report heap allocations per subsystem and tick
+        } else if (strcmp(argv[i], "--ground-truth") == 0) {
+            ground_truth = true;  // Print the reference MapPoint graph of the track instead
+        } else if (strcmp(argv[i], "--score") == 0) {
+            score = true;  // Compare the exploration with the reference graph of the track
+        } else if (strcmp(argv[i], "--score-totals") == 0 && i + 1 < argc) {
+            score_totals_file = argv[++i];  // Rank the policies of a batch of runs
+            score = true;
+        } else if (strcmp(argv[i], "--policy") == 0 && i + 1 < argc) {
+            exploration_policy = policy_find(argv[++i]);  // Explore with another policy (see policy.h)
+            if (!exploration_policy) {
+                fprintf(stderr, "Unknown policy: %s\nPolicies:\n", argv[i]);
+                policy_print_list(stderr);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--tournament") == 0) {
+            tournament = true;  // Rank every policy on the variants of the loop track instead
+        } else if (strcmp(argv[i], "--false-positive") == 0 && i + 1 < argc) {
+            noise.false_positive = atof(argv[++i]);  // Sensors see walls that are not there (see noise.h)
+        } else if (strcmp(argv[i], "--false-negative") == 0 && i + 1 < argc) {
+            noise.false_negative = atof(argv[++i]);  // Sensors miss walls
+        } else if (strcmp(argv[i], "--range-noise") == 0 && i + 1 < argc) {
+            noise.range_sigma = atof(argv[++i]);  // Deviation of the measured range in cells
+        } else if (strcmp(argv[i], "--missed-move") == 0 && i + 1 < argc) {
+            noise.missed_move = atof(argv[++i]);  // Motor commands that do not happen
+        } else if (strcmp(argv[i], "--noise-seed") == 0 && i + 1 < argc) {
+            noise_seed = strtoull(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--monte-carlo") == 0 && i + 1 < argc) {
+            monte_carlo_episodes = atoi(argv[++i]);  // Noisy episodes per variant of the loop track instead
+        } else if (strcmp(argv[i], "--fleet") == 0 && i + 1 < argc) {
+            fleet_cars = atoi(argv[++i]);  // Explore with fleets of 1 to N cars on one map instead (see fleet.h)
+        } else if (strcmp(argv[i], "--occupancy") == 0 && i + 1 < argc) {
+            // Record the sensor readings per cell, and fuse them into the readings (see occupancy.h)
+            if (!occupancy_mode_parse(argv[++i], &occupancy_mode)) {
+                fprintf(stderr, "Unknown occupancy mode: %s (off, record or fuse)\n", argv[i]);
+                return 1;
+            }
+        } else {
+            fprintf(stderr, "Unknown option: %s\n", argv[i]);
+            return 1;
+        }
+    }
+
+    if (perf && !perf_counters_start()) perf = false;
+    if (score && pipeline) {
+        fprintf(stderr, "--score needs the tick loop and cannot be combined with --pipeline\n");
+        return 1;
+    }
+    if (fleet_cars > 0 && (async_planner || pipeline)) {
+        fprintf(stderr, "--fleet takes turns on one thread and cannot be combined with --async-planner or --pipeline\n");
+        return 1;
+    }
+    ScoreReport score_report = {0};
+    noise_model_set(&noise);
+    noise_stream_init(&sensor_noise, noise_seed, 0, NOISE_STREAM_SENSORS);
+    noise_stream_init(&motor_noise, noise_seed, 0, NOISE_STREAM_MOTORS);
+
+    if (monte_carlo_episodes > 0) {
+        return run_monte_carlo(monte_carlo_episodes, NUM_TRACK_VARIANTS, noise_seed) ? 0 : 1;
+    }
+
+    if (fleet_cars > 0) {
+        return run_fleet_comparison(fleet_cars, noise_seed) ? 0 : 1;
+    }
+
+    if (tournament) {
+        return run_tournament(NUM_TRACK_VARIANTS, score_totals_file) ? 0 : 1;
+    }
+
+    if (simulations > 0) {
+        run_interleaved_simulations(simulations, score ? &score_report : NULL);
+        if (score) score_report_print(&score_report, stdout);
+        if (score_totals_file && !score_totals_merge(score_totals_file, &exploration_policy->name, &score_report, 1)) {
+            return 1;
+        }
+        if (perf) report_perf_counters(perf_totals_file);
+        if (alloc_stats) alloc_tracker_report(stdout);
+#ifdef STATIC_POOLS
+        if (alloc_stats) static_pools_report(stdout);
+#endif
+        return static_pools_exhausted() ? 1 : 0;
+    }
+
     initialize_globals();
     initialize_grid();  // Initialize grid from track_generation
     create_loop_track();  // Create the track layout
 
-    printf("Starting Automatic Exploration...\n");
     start = current_car.current_location;
     start_orientation = current_car.current_orientation;
-    start_exploration();
 
-    return 0;
+    if (ground_truth) {
+        GroundTruthGraph graph;
+        ground_truth_extract_track(&graph);
+        ground_truth_report(&graph, stdout);
+        for (int i = 0; i < graph.num_nodes; i++) {
+            printf("  (%d, %d) %s\n", graph.nodes[i].x, graph.nodes[i].y, cell_class_name(graph.nodes[i].kind));
+        }
+        ground_truth_free(&graph);
+        return 0;
+    }
+
+    if (replay_file) {
+        return replay_run(replay_file, seek_tick, render) ? 0 : 1;
+    }
+
+    // A map saved for this track lets the car skip exploration and race straight away
+    if (map_file && map_snapshot_load(map_file)) {
+        printf("Loaded map snapshot %s\n", map_file);
+        if (!race_shortest_lap(3)) printf("The map snapshot contains no lap\n");
+        return 0;
+    }
+
+    ExplorationState resumed;
+    if (resume_file) {
+        if (!checkpoint_load(resume_file, &resumed)) {
+            fprintf(stderr, "Cannot resume from checkpoint: %s\n", resume_file);
+            return 1;
+        }
+        printf("Resuming Automatic Exploration at tick %lu...\n", resumed.ticks);
+    } else {
+        printf("Starting Automatic Exploration...\n");
+    }
+
+    if (presize_explorations) exploration_presize((int) track_cells_on_track(), 1);
+    instrumentation_install_signal_handler();
+    if (latency) latency_start((uint64_t) tick_budget_us * 1000);
+    if (telemetry_file && !telemetry_start(telemetry_file)) return 1;
+    if (trace_file && !trace_start(trace_file)) return 1;
+    if (checkpoint_file) checkpoint_writer_start(checkpoint_file, checkpoint_interval);
+    if (record_file && !recording_start(record_file, keyframe_interval)) return 1;
+    if (async_planner) planner_start();
+    Scoreboard scoreboard;
+    if (score) scoreboard_init(&scoreboard);
+    if (resume_file) {
+        resumed.scoreboard = score ? &scoreboard : NULL;
+        run_exploration(&resumed);
+    } else if (pipeline) {
+        start_pipeline_exploration();
+    } else {
+        ExplorationState state;
+        exploration_state_init(&state);
+        state.scoreboard = score ? &scoreboard : NULL;
+        run_exploration(&state);
+    }
+    planner_stop();
+    checkpoint_writer_stop();
+    telemetry_stop();
+    trace_stop();
+    recording_stop();
+
+    if (latency) latency_report(stdout);
+    if (occupancy_mode != OCCUPANCY_OFF) occupancy_report(stdout);
+    if (perf) report_perf_counters(perf_totals_file);
+    if (alloc_stats) alloc_tracker_report(stdout);
+    if (alloc_stats) {
+        printf("Track storage: %zu bytes for %dx%d cells\n", track_memory_bytes(), track_width(), track_height());
+    }
+#ifdef STATIC_POOLS
+    if (alloc_stats) static_pools_report(stdout);
+#endif
+    if (stats_file) {
+        FILE *stats = strcmp(stats_file, "-") == 0 ? stderr : fopen(stats_file, "w");
+        if (stats) {
+            instrumentation_dump_json(stats);
+            if (stats != stderr) fclose(stats);
+        } else {
+            perror("Failed to open stats file");
+        }
+    }
+
+    if (map_file || score) exploration_record_final_map_point();
+    if (score) {
+        GroundTruthGraph graph;
+        ground_truth_extract_track(&graph);
+        scoreboard_evaluate(&scoreboard, &graph, &score_report);
+        ground_truth_free(&graph);
+        scoreboard_free(&scoreboard);
+        score_report_print(&score_report, stdout);
+        if (score_totals_file && !score_totals_merge(score_totals_file, &exploration_policy->name, &score_report, 1)) {
+            return 1;
+        }
+    }
+
+    // Only a map with a known lap is worth reusing
+    if (map_file) {
+        Path *lap = find_shortest_lap();
+        if (lap && map_snapshot_save(map_file)) printf("Saved map snapshot %s\n", map_file);
+        path_free(lap);
+    }
+
+    // The exploration was cut short by a full static pool
+    return static_pools_exhausted() ? 1 : 0;
 }
@@ -0,0 +1,253 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "map_snapshot.h"
+#include "globals.h"
+#include "track_files_PRIVATE/track_generation.h"
+
+// ======================= FILE FORMAT ======================= //
+//
+// A snapshot is position independent: MapPoints and FundamentalPaths are stored as flat
+// arrays and refer to each other by index, so the file can be mapped at any address.
+//
+//   SnapshotHeader | SnapshotNode[node_count] | SnapshotEdge[edge_count]
+//
+// The paths of node i are edges[first_edge .. first_edge + edge_count). All fields are
+// fixed-width little-endian integers.
+
+/**
+ * @struct SnapshotHeader
+ * @brief Identifies the format, the track and the size of the stored graph.
+ */
+typedef struct SnapshotHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t grid_hash;         /**< track_grid_hash() of the explored track */
+    int32_t start_x, start_y;
+    uint32_t node_count;
+    uint32_t edge_count;
+} SnapshotHeader;
+
+/**
+ * @struct SnapshotNode
+ * @brief A MapPoint with its paths stored as a range of edges.
+ */
+typedef struct SnapshotNode {
+    int32_t x, y;
+    uint32_t first_edge;
+    uint32_t edge_count;
+    int32_t prune_exit;
+    uint32_t active;
+} SnapshotNode;
+
+/**
+ * @struct SnapshotEdge
+ * @brief A FundamentalPath, with its end stored as a node index.
+ */
+typedef struct SnapshotEdge {
+    int32_t end;                /**< Index of the end node, -1 if unexplored */
+    int32_t distance;
+    int32_t direction;
+} SnapshotEdge;
+
+// ======================= SAVING ======================= //
+
+/**
+ * @brief Saves the explored MapPoint/FundamentalPath graph of the current track.
+ *
+ * The file is written next to its destination and renamed into place, so a reader
+ * never maps a half-written snapshot.
+ *
+ * @param filename Path of the snapshot file.
+ * @return bool True if the snapshot was written, false otherwise.
+ */
+bool map_snapshot_save(const char *filename) {
+    if (!filename) return false;
+
+    SnapshotHeader header = {MAP_SNAPSHOT_MAGIC, MAP_SNAPSHOT_VERSION, track_grid_hash(),
+                             start.x, start.y, (uint32_t) num_map_points_all, 0};
+    for (int i = 0; i < num_map_points_all; i++) {
+        header.edge_count += map_points_all[i]->numberOfPaths;
+    }
+
+    SnapshotNode *nodes = calloc(header.node_count ? header.node_count : 1, sizeof(SnapshotNode));
+    SnapshotEdge *edges = calloc(header.edge_count ? header.edge_count : 1, sizeof(SnapshotEdge));
+    if (!nodes || !edges) {
+        perror("Error: Failed to allocate map snapshot");
+        exit(EXIT_FAILURE);
+    }
+
+    // MapPoint ids are their index in map_points_all
+    uint32_t edge = 0;
+    for (int i = 0; i < num_map_points_all; i++) {
+        MapPoint *mp = map_points_all[i];
+        nodes[i] = (SnapshotNode) {mp->location.x, mp->location.y, edge, (uint32_t) mp->numberOfPaths,
+                                   mp->prune_exit, mp->active};
+
+        for (int j = 0; j < mp->numberOfPaths; j++, edge++) {
+            FundamentalPath *fp = &mp->paths[j];
+            edges[edge] = (SnapshotEdge) {fp_end(fp) ? fp_end(fp)->id : -1, fp->distance, fp->direction};
+        }
+    }
+
+    size_t length = strlen(filename);
+    char *temporary = malloc(length + 5);
+    if (!temporary) {
+        perror("Error: Failed to allocate map snapshot filename");
+        exit(EXIT_FAILURE);
+    }
+    memcpy(temporary, filename, length);
+    memcpy(temporary + length, ".tmp", 5);
+
+    FILE *file = fopen(temporary, "wb");
+    bool written = file &&
+                   fwrite(&header, sizeof(header), 1, file) == 1 &&
+                   fwrite(nodes, sizeof(SnapshotNode), header.node_count, file) == header.node_count &&
+                   fwrite(edges, sizeof(SnapshotEdge), header.edge_count, file) == header.edge_count;
+    if (file && fclose(file) != 0) written = false;
+    if (written && rename(temporary, filename) != 0) written = false;
+    if (!written) {
+        perror("Error: Failed to write map snapshot");
+        remove(temporary);
+    }
+
+    free(temporary);
+    free(nodes);
+    free(edges);
+    return written;
+}
+
+// ======================= LOADING ======================= //
+
+/**
+ * @brief Checks that a mapped file is a complete snapshot of the current track.
+ *
+ * @param data Start of the mapped file.
+ * @param size Size of the mapped file in bytes.
+ * @return bool True if the snapshot can be adopted, false otherwise.
+ */
+static bool validate_snapshot(const unsigned char *data, size_t size) {
+    if (size < sizeof(SnapshotHeader)) return false;
+
+    const SnapshotHeader *header = (const SnapshotHeader *) data;
+    if (header->magic != MAP_SNAPSHOT_MAGIC) return false;
+    if (header->version != MAP_SNAPSHOT_VERSION) {
+        fprintf(stderr, "Map snapshot version %u is not supported\n", header->version);
+        return false;
+    }
+    if (header->grid_hash != track_grid_hash() || header->start_x != start.x || header->start_y != start.y) {
+        return false;
+    }
+
+    size_t expected = sizeof(SnapshotHeader) + (size_t) header->node_count * sizeof(SnapshotNode)
+                      + (size_t) header->edge_count * sizeof(SnapshotEdge);
+    if (size != expected) return false;
+
+    // Every index must stay inside the arrays
+    const SnapshotNode *nodes = (const SnapshotNode *) (header + 1);
+    const SnapshotEdge *edges = (const SnapshotEdge *) (nodes + header->node_count);
+    for (uint32_t i = 0; i < header->node_count; i++) {
+        if (nodes[i].first_edge > header->edge_count ||
+            nodes[i].edge_count > header->edge_count - nodes[i].first_edge ||
+            nodes[i].edge_count > (uint32_t) MP_MAX_PATHS ||
+            nodes[i].prune_exit < -1 || nodes[i].prune_exit >= (int32_t) nodes[i].edge_count) {
+            return false;
+        }
+    }
+    for (uint32_t i = 0; i < header->edge_count; i++) {
+        if (edges[i].end < -1 || edges[i].end >= (int32_t) header->node_count) return false;
+        if (edges[i].direction < NORTH || edges[i].direction > WEST) return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Memory-maps a saved graph of the current track and adopts it as the explored map.
+ *
+ * The current map must be empty. Nothing is adopted if the file is missing, belongs to a
+ * different track or is not a valid snapshot.
+ *
+ * @param filename Path of the snapshot file.
+ * @return bool True if the map was adopted, false otherwise.
+ */
+bool map_snapshot_load(const char *filename) {
+    if (!filename || num_map_points_all != 0) return false;
+
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size <= 0) {
+        close(fd);
+        return false;
+    }
+
+    size_t size = (size_t) info.st_size;
+    unsigned char *data = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) return false;
+
+    if (!validate_snapshot(data, size)) {
+        munmap(data, size);
+        return false;
+    }
+
+    const SnapshotHeader *header = (const SnapshotHeader *) data;
+    const SnapshotNode *nodes = (const SnapshotNode *) (header + 1);
+    const SnapshotEdge *edges = (const SnapshotEdge *) (nodes + header->node_count);
+
+#ifdef STATIC_POOLS
+    // The static lists cannot grow to take the map
+    if (header->node_count > (uint32_t) (capacity_map_points_all - num_map_points_all)) {
+        munmap(data, size);
+        return false;
+    }
+#endif
+
+    // Create every MapPoint first, so edges can be resolved to pointers
+    MapPoint **adopted = malloc((header->node_count ? header->node_count : 1) * sizeof(MapPoint *));
+    if (!adopted) {
+        perror("Error: Failed to allocate adopted MapPoints");
+        exit(EXIT_FAILURE);
+    }
+    for (uint32_t i = 0; i < header->node_count; i++) {
+        adopted[i] = map_point_create();
+        if (!adopted[i] || !mp_reserve_paths(adopted[i], (int) nodes[i].edge_count)) {
+            // The map does not fit the static pools
+            for (uint32_t j = 0; j <= i; j++) map_point_free(adopted[j]);
+            free(adopted);
+            munmap(data, size);
+            return false;
+        }
+        adopted[i]->id = map_point_counter + (int) i;  // IDs first, the edges refer to them
+    }
+    map_point_counter += (int) header->node_count;
+
+    for (uint32_t i = 0; i < header->node_count; i++) {
+        MapPoint *mp = adopted[i];
+        mp_set_location(mp, (Location) {nodes[i].x, nodes[i].y});
+        mp->numberOfPaths = (int) nodes[i].edge_count;
+        mp->active = nodes[i].active != 0;
+        mp->prune_exit = nodes[i].prune_exit;
+        mp->changed = false;
+
+        for (uint32_t j = 0; j < nodes[i].edge_count; j++) {
+            const SnapshotEdge *edge = &edges[nodes[i].first_edge + j];
+            initialize_fundamental_path(&mp->paths[j], mp, edge->distance);
+            fp_set_end(&mp->paths[j], edge->end >= 0 ? adopted[edge->end] : NULL);
+            mp->paths[j].direction = (Direction) edge->direction;
+        }
+    }
+
+    for (uint32_t i = 0; i < header->node_count; i++) {
+        append_map_point(adopted[i]);
+    }
+
+    free(adopted);
+    munmap(data, size);
+    return true;
+}
@@ -0,0 +1,17 @@
+#ifndef MAP_SNAPSHOT_H
+#define MAP_SNAPSHOT_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "track_files_PRIVATE/track_grid.h"
+
+#define MAP_SNAPSHOT_MAGIC   0x50414D54u   // "TMAP" in little-endian
+#define MAP_SNAPSHOT_VERSION 1u
+
+// Save the explored MapPoint/FundamentalPath graph of the current track
+bool map_snapshot_save(const char *filename);
+
+// Memory-map a saved graph of the current track and adopt it as the explored map
+bool map_snapshot_load(const char *filename);
+
+#endif // MAP_SNAPSHOT_H
@@ -0,0 +1,524 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include "map_version.h"
+#include "alloc_tracker.h"
+#include "static_pools.h"
+
+#define MAP_VERSION_MASK (MAP_VERSION_FANOUT - 1)
+
+MapVersion live_map_version = {NULL, 0, 0, 0};
+
+// Released nodes and trie levels are kept for the next edit, so a warmed-up search never allocates
+static void *free_nodes = NULL;
+static void *free_tries = NULL;
+
+#ifdef STATIC_POOLS
+STATIC_POOL_DEFINE(map_node_pool, "MapNodes (POOL_MAP_NODES)", MapNode, POOL_MAP_NODES)
+STATIC_POOL_DEFINE(map_trie_pool, "Map trie levels (POOL_MAP_TRIES)", MapTrie, POOL_MAP_TRIES)
+
+// Scratch arrays of the frontier search, one entry per MapNode a version can hold
+static int search_distances[POOL_MAP_POINTS];
+static int search_heap[POOL_MAP_POINTS * POOL_PATHS_PER_MAP_POINT];
+static int search_heap_keys[POOL_MAP_POINTS * POOL_PATHS_PER_MAP_POINT];
+static const int search_capacity = POOL_MAP_POINTS;
+#else
+// Scratch arrays of the frontier search, grown to the number of MapNodes and kept between searches
+static int *search_distances = NULL;
+static int *search_heap = NULL;
+static int *search_heap_keys = NULL;
+static int search_capacity = 0;
+#endif
+
+// ======================= NODE STORAGE ======================= //
+
+/**
+ * @brief Takes a block from a free list, allocating one if the list is empty.
+ *
+ * @param free_list Pointer to the free list, linked through the first bytes of its blocks.
+ * @param size Size of a block.
+ * @param pool Static pool to take from when the list is empty (unused without STATIC_POOLS).
+ * @return void* The block, or NULL if the static pool is exhausted.
+ */
+static void *take_block(void **free_list, size_t size, void *pool) {
+    void *block = *free_list;
+    if (block) {
+        *free_list = *(void **) block;
+        return block;
+    }
+
+#ifdef STATIC_POOLS
+    (void) size;
+    return static_pool_take(pool);
+#else
+    (void) pool;
+    block = tracked_malloc(ALLOC_MAP_VERSIONS, size);
+    if (!block) {
+        perror("Error: Memory allocation failed for a map version");
+        exit(EXIT_FAILURE);
+    }
+    return block;
+#endif
+}
+
+/**
+ * @brief Returns a block to a free list.
+ *
+ * @param free_list Pointer to the free list.
+ * @param block Pointer to the block.
+ */
+static void give_block(void **free_list, void *block) {
+    *(void **) block = *free_list;
+    *free_list = block;
+}
+
+#ifdef STATIC_POOLS
+#define NODE_POOL &map_node_pool
+#define TRIE_POOL &map_trie_pool
+#else
+#define NODE_POOL NULL
+#define TRIE_POOL NULL
+#endif
+
+/**
+ * @brief Drops one reference to a trie level, releasing it and its children with the last one.
+ *
+ * @param trie Pointer to the trie level, may be NULL.
+ * @param levels Levels from this one down to the MapNodes, 1 for the lowest.
+ */
+static void unref_trie(MapTrie *trie, int levels) {
+    if (!trie || --trie->refs > 0) return;
+
+    for (int i = 0; i < MAP_VERSION_FANOUT; i++) {
+        if (!trie->slots[i]) continue;
+        if (levels == 1) {
+            MapNode *node = trie->slots[i];
+            if (--node->refs == 0) give_block(&free_nodes, node);
+        } else {
+            unref_trie(trie->slots[i], levels - 1);
+        }
+    }
+    give_block(&free_tries, trie);
+}
+
+/**
+ * @brief Makes a trie level writable, copying it if another version shares it.
+ *
+ * @param slot Pointer to the slot holding the level, which is updated to the copy.
+ * @param levels Levels from this one down to the MapNodes, 1 for the lowest.
+ * @return MapTrie* The writable level, or NULL if the static pool is exhausted.
+ */
+static MapTrie *writable_trie(MapTrie **slot, int levels) {
+    MapTrie *trie = *slot;
+    if (!trie) {
+        trie = take_block(&free_tries, sizeof(MapTrie), TRIE_POOL);
+        if (!trie) return NULL;
+        memset(trie, 0, sizeof(MapTrie));
+        trie->refs = 1;
+    } else if (trie->refs > 1) {
+        MapTrie *copy = take_block(&free_tries, sizeof(MapTrie), TRIE_POOL);
+        if (!copy) return NULL;
+        memcpy(copy->slots, trie->slots, sizeof(trie->slots));
+        copy->refs = 1;
+        for (int i = 0; i < MAP_VERSION_FANOUT; i++) {
+            if (!copy->slots[i]) continue;
+            if (levels == 1) {
+                ((MapNode *) copy->slots[i])->refs++;
+            } else {
+                ((MapTrie *) copy->slots[i])->refs++;
+            }
+        }
+        trie->refs--;
+        trie = copy;
+    }
+    *slot = trie;
+    return trie;
+}
+
+/**
+ * @brief Makes a MapNode writable, copying it if another version shares it.
+ *
+ * A new MapNode has no paths.
+ *
+ * @param slot Pointer to the slot holding the MapNode, which is updated to the copy.
+ * @param id ID of the MapNode.
+ * @return MapNode* The writable MapNode, or NULL if the static pool is exhausted.
+ */
+static MapNode *writable_node(MapNode **slot, int id) {
+    MapNode *node = *slot;
+    if (!node) {
+        node = take_block(&free_nodes, sizeof(MapNode), NODE_POOL);
+        if (!node) return NULL;
+        node->id = id;
+        node->location = (Location) {0, 0};
+        for (int d = 0; d < 4; d++) {
+            node->end[d] = MAP_EDGE_NONE;
+            node->distance[d] = 0;
+        }
+        node->refs = 1;
+    } else if (node->refs > 1) {
+        MapNode *copy = take_block(&free_nodes, sizeof(MapNode), NODE_POOL);
+        if (!copy) return NULL;
+        *copy = *node;
+        copy->refs = 1;
+        node->refs--;
+        node = copy;
+    }
+    *slot = node;
+    return node;
+}
+
+/**
+ * @brief Makes the MapNode with an ID writable, copying the shared trie levels on the way.
+ *
+ * @param version Pointer to the version.
+ * @param id ID of the MapNode, created if the version has none by that ID.
+ * @return MapNode* The writable MapNode, or NULL if the static pool is exhausted.
+ */
+static MapNode *edit_node(MapVersion *version, int id) {
+    // Grow the trie by a level above the root until the ID fits
+    while (!version->root || id >> (MAP_VERSION_BITS * version->levels) != 0) {
+        MapTrie *root = NULL;
+        if (!writable_trie(&root, version->levels + 1)) return NULL;
+        root->slots[0] = version->root;
+        version->root = root;
+        version->levels++;
+    }
+
+    MapTrie **slot = &version->root;
+    for (int level = version->levels; level > 1; level--) {
+        MapTrie *trie = writable_trie(slot, level);
+        if (!trie) return NULL;
+        slot = (MapTrie **) &trie->slots[(id >> (MAP_VERSION_BITS * (level - 1))) & MAP_VERSION_MASK];
+    }
+    MapTrie *lowest = writable_trie(slot, 1);
+    if (!lowest) return NULL;
+    return writable_node((MapNode **) &lowest->slots[id & MAP_VERSION_MASK], id);
+}
+
+/**
+ * @brief Checks if a MapNode is on the frontier.
+ *
+ * @param node Pointer to the MapNode, may be NULL.
+ * @return int 1 if one of its paths is unexplored, 0 otherwise.
+ */
+static int on_frontier(const MapNode *node) {
+    if (!node) return 0;
+    for (int d = 0; d < 4; d++) {
+        if (node->end[d] == MAP_EDGE_UNEXPLORED) return 1;
+    }
+    return 0;
+}
+
+#ifndef STATIC_POOLS
+/**
+ * @brief Counts the blocks of a free list.
+ *
+ * @param free_list The free list.
+ * @return int Number of blocks.
+ */
+static int free_list_length(void *free_list) {
+    int length = 0;
+    for (void *block = free_list; block; block = *(void **) block) length++;
+    return length;
+}
+
+/**
+ * @brief Puts blocks on a free list until it holds the given number.
+ *
+ * @param free_list Pointer to the free list.
+ * @param size Size of a block.
+ * @param count Number of blocks to keep ready.
+ */
+static void fill_free_list(void **free_list, size_t size, int count) {
+    for (int ready = free_list_length(*free_list); ready < count; ready++) {
+        void *block = tracked_malloc(ALLOC_MAP_VERSIONS, size);
+        if (!block) {
+            perror("Error: Failed to reserve map versions");
+            exit(EXIT_FAILURE);
+        }
+        give_block(free_list, block);
+    }
+}
+#endif
+
+// ======================= VERSIONS ======================= //
+
+/**
+ * @brief Forks a version: both share every node until one of them is edited.
+ *
+ * @param from Pointer to the version to fork.
+ * @param to Pointer to the new version, released with map_version_release().
+ */
+void map_version_fork(const MapVersion *from, MapVersion *to) {
+    *to = *from;
+    if (to->root) to->root->refs++;
+}
+
+/**
+ * @brief Releases a version, freeing the nodes no other version shares.
+ *
+ * @param version Pointer to the version, left empty.
+ */
+void map_version_release(MapVersion *version) {
+    unref_trie(version->root, version->levels);
+    *version = (MapVersion) {NULL, 0, 0, 0};
+}
+
+/**
+ * @brief Gets a MapNode of a version.
+ *
+ * @param version Pointer to the version.
+ * @param id ID of the MapNode.
+ * @return const MapNode* The MapNode, or NULL if the version has none by that ID.
+ */
+const MapNode *map_version_get(const MapVersion *version, int id) {
+    if (id < 0 || id >= version->num_nodes) return NULL;
+
+    const MapTrie *trie = version->root;
+    for (int level = version->levels; level > 1 && trie; level--) {
+        trie = trie->slots[(id >> (MAP_VERSION_BITS * (level - 1))) & MAP_VERSION_MASK];
+    }
+    return trie ? trie->slots[id & MAP_VERSION_MASK] : NULL;
+}
+
+/**
+ * @brief Writes a whole MapNode into a version.
+ *
+ * @param version Pointer to the version.
+ * @param id ID of the MapNode.
+ * @param location Location of the MapPoint.
+ * @param end Per Direction: ID of the MapNode the path leads to, or MAP_EDGE_*.
+ * @param distance Per Direction: cells to that MapNode.
+ * @return bool True if the node was written, false if the static pools are exhausted.
+ */
+bool map_version_set_node(MapVersion *version, int id, Location location, const int end[4], const int distance[4]) {
+    MapNode *node = edit_node(version, id);
+    if (!node) return false;
+
+    int was_frontier = on_frontier(node);
+    node->location = location;
+    memcpy(node->end, end, sizeof(node->end));
+    memcpy(node->distance, distance, sizeof(node->distance));
+    version->num_frontier += on_frontier(node) - was_frontier;
+    if (id >= version->num_nodes) version->num_nodes = id + 1;
+    return true;
+}
+
+/**
+ * @brief Writes one path of a MapNode into a version.
+ *
+ * @param version Pointer to the version.
+ * @param id ID of the MapNode, which must exist.
+ * @param direction Direction the path leaves in.
+ * @param end ID of the MapNode the path leads to, or MAP_EDGE_*.
+ * @param distance Cells to that MapNode.
+ * @return bool True if the path was written, false if the static pools are exhausted.
+ */
+bool map_version_set_path(MapVersion *version, int id, Direction direction, int end, int distance) {
+    MapNode *node = edit_node(version, id);
+    if (!node) return false;
+
+    int was_frontier = on_frontier(node);
+    node->end[direction] = end;
+    node->distance[direction] = distance;
+    version->num_frontier += on_frontier(node) - was_frontier;
+    if (id >= version->num_nodes) version->num_nodes = id + 1;
+    return true;
+}
+
+/**
+ * @brief Finds the MapNode at a location.
+ *
+ * @param version Pointer to the version.
+ * @param location Location to look for.
+ * @return int ID of the MapNode, -1 if there is none.
+ */
+int map_version_find(const MapVersion *version, Location location) {
+    for (int id = 0; id < version->num_nodes; id++) {
+        const MapNode *node = map_version_get(version, id);
+        if (node && node->location.x == location.x && node->location.y == location.y) return id;
+    }
+    return -1;
+}
+
+// ======================= LIVE VERSION ======================= //
+
+/**
+ * @brief Writes a MapPoint of the explored map into a version.
+ *
+ * @param version Pointer to the version.
+ * @param mp Pointer to the MapPoint.
+ * @return bool True if the node was written, false if the static pools are exhausted.
+ */
+static bool store_map_point(MapVersion *version, const MapPoint *mp) {
+    int end[4] = {MAP_EDGE_NONE, MAP_EDGE_NONE, MAP_EDGE_NONE, MAP_EDGE_NONE};
+    int distance[4] = {0, 0, 0, 0};
+    for (int i = 0; i < mp->numberOfPaths; i++) {
+        const FundamentalPath *fp = &mp->paths[i];
+        MapPoint *path_end = fp_end(fp);
+        end[fp->direction] = path_end ? path_end->id : MAP_EDGE_UNEXPLORED;
+        distance[fp->direction] = fp->distance;
+    }
+    return map_version_set_node(version, mp->id, mp_location(mp), end, distance);
+}
+
+/**
+ * @brief Brings the live version up to date with the explored map.
+ *
+ * The first call copies every MapPoint; after that only the MapPoints queued in
+ * map_points_changed are copied, so it must run before every publication of the changes
+ * (see exploration_after_move()).
+ *
+ * @return bool True if the live version is up to date, false if the static pools are exhausted.
+ */
+bool map_version_sync_live() {
+    if (live_map_version.num_nodes == 0) {
+        for (int i = 0; i < num_map_points_all; i++) {
+            if (!store_map_point(&live_map_version, map_points_all[i])) return false;
+        }
+        return true;
+    }
+
+    for (int i = 0; i < num_map_points_changed; i++) {
+        if (!store_map_point(&live_map_version, map_points_changed[i])) return false;
+    }
+    return true;
+}
+
+// ======================= FRONTIER SEARCH ======================= //
+
+/**
+ * @brief Grows the search scratch arrays to hold the given number of MapNodes.
+ *
+ * @param count Number of MapNodes.
+ * @return bool True if the arrays are large enough.
+ */
+static bool reserve_search(int count) {
+#ifdef STATIC_POOLS
+    return count <= search_capacity;
+#else
+    if (count <= search_capacity) return true;
+
+    int capacity = search_capacity ? search_capacity : 32;
+    while (capacity < count) capacity *= 2;
+    int *distances = tracked_realloc(ALLOC_SEARCH, search_distances, capacity * sizeof(int));
+    if (!distances) {
+        perror("Error: Failed to allocate the frontier search");
+        exit(EXIT_FAILURE);
+    }
+    search_distances = distances;
+    int *heap = tracked_realloc(ALLOC_SEARCH, search_heap, 4 * capacity * sizeof(int));
+    int *keys = heap ? tracked_realloc(ALLOC_SEARCH, search_heap_keys, 4 * capacity * sizeof(int)) : NULL;
+    if (!heap || !keys) {
+        perror("Error: Failed to allocate the frontier search");
+        exit(EXIT_FAILURE);
+    }
+    search_heap = heap;
+    search_heap_keys = keys;
+    search_capacity = capacity;
+    return true;
+#endif
+}
+
+/**
+ * @brief Preallocates the MapNodes, trie levels and search arrays of the live map versions and
+ *        of one fork at a time, so what-if searches do not allocate.
+ *
+ * Simulations stepped side by side share the free lists, so each of their live versions
+ * needs its own share.
+ *
+ * @param max_nodes Upper bound on the MapNodes of a version.
+ * @param fork_edits Upper bound on the MapNodes a fork edits before it is released.
+ * @param live_versions Number of live versions growing side by side.
+ */
+void map_version_reserve(int max_nodes, int fork_edits, int live_versions) {
+#ifdef STATIC_POOLS
+    // Nodes, trie levels and search arrays come from their static pools
+    (void) max_nodes;
+    (void) fork_edits;
+    (void) live_versions;
+#else
+    int levels = 1;
+    while (max_nodes >> (MAP_VERSION_BITS * levels) != 0) levels++;
+
+    // Every level of the live trie, and a copy of the levels above every node a fork edits
+    int tries = 0;
+    for (int level = 1; level <= levels; level++) {
+        int span = 1 << (MAP_VERSION_BITS * level);
+        tries += (max_nodes + span - 1) / span;
+    }
+    tries = live_versions * tries + fork_edits * levels;
+
+    fill_free_list(&free_nodes, sizeof(MapNode), live_versions * max_nodes + fork_edits);
+    fill_free_list(&free_tries, sizeof(MapTrie), tries);
+    reserve_search(max_nodes);
+#endif
+}
+
+/**
+ * @brief Finds the closest MapNode with an unexplored path, driving over explored paths only.
+ *
+ * A binary heap with lazy deletion; every MapNode is queued at most once per path into it.
+ *
+ * @param version Pointer to the version.
+ * @param from ID of the MapNode to start at.
+ * @param distance Pointer to store the cells to the frontier MapNode in.
+ * @return int ID of the frontier MapNode, -1 if none can be reached.
+ */
+int map_version_nearest_frontier(const MapVersion *version, int from, int *distance) {
+    if (!map_version_get(version, from) || !reserve_search(version->num_nodes)) return -1;
+
+    for (int i = 0; i < version->num_nodes; i++) search_distances[i] = INT_MAX;
+    search_distances[from] = 0;
+    int size = 0;
+    search_heap[size] = from;
+    search_heap_keys[size++] = 0;
+
+    while (size > 0) {
+        int id = search_heap[0];
+        int key = search_heap_keys[0];
+
+        // Pop the minimum by moving the last entry down from the top
+        size--;
+        int moved = search_heap[size], moved_key = search_heap_keys[size];
+        int hole = 0;
+        while (2 * hole + 1 < size) {
+            int child = 2 * hole + 1;
+            if (child + 1 < size && search_heap_keys[child + 1] < search_heap_keys[child]) child++;
+            if (search_heap_keys[child] >= moved_key) break;
+            search_heap[hole] = search_heap[child];
+            search_heap_keys[hole] = search_heap_keys[child];
+            hole = child;
+        }
+        search_heap[hole] = moved;
+        search_heap_keys[hole] = moved_key;
+
+        if (key > search_distances[id]) continue;
+        const MapNode *node = map_version_get(version, id);
+        if (on_frontier(node)) {
+            *distance = key;
+            return id;
+        }
+
+        for (int d = 0; d < 4; d++) {
+            int next = node->end[d];
+            if (next < 0 || next >= version->num_nodes) continue;
+            int cost = key + node->distance[d];
+            if (cost >= search_distances[next] || size >= 4 * search_capacity) continue;
+            search_distances[next] = cost;
+
+            // Push by moving the new entry up from the bottom
+            int slot = size++;
+            while (slot > 0 && search_heap_keys[(slot - 1) / 2] > cost) {
+                search_heap[slot] = search_heap[(slot - 1) / 2];
+                search_heap_keys[slot] = search_heap_keys[(slot - 1) / 2];
+                slot = (slot - 1) / 2;
+            }
+            search_heap[slot] = next;
+            search_heap_keys[slot] = cost;
+        }
+    }
+    return -1;
+}
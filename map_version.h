@@ -0,0 +1,76 @@
+#ifndef MAP_VERSION_H
+#define MAP_VERSION_H
+
+#include <stdbool.h>
+#include "globals.h"
+
+// ======================= MAP VERSIONS ======================= //
+//
+// A persistent copy of the explored map for what-if searches (see lookahead.h). A version
+// is a 32-way trie of immutable MapNodes indexed by MapPoint ID; nodes and trie levels are
+// shared between versions and reference counted. Forking a version only counts one more
+// reference to its root, and editing a version copies just the nodes and trie levels on the
+// way to the edited MapNode while they are shared. The frontier is kept with the nodes: a
+// node is on it while one of its paths is unexplored.
+
+#define MAP_VERSION_BITS 5
+#define MAP_VERSION_FANOUT (1 << MAP_VERSION_BITS)
+
+// Values of MapNode.end besides a MapNode ID
+#define MAP_EDGE_UNEXPLORED (-1)   // A path nobody drove yet
+#define MAP_EDGE_NONE (-2)         // No path in this direction
+
+/**
+ * @struct MapNode
+ * @brief A MapPoint as one version of the map sees it; only written while unshared.
+ */
+typedef struct MapNode {
+    int refs;                       /**< Trie levels holding the node */
+    int id;
+    Location location;
+    int end[4];                     /**< Per Direction: ID of the MapNode the path leads to, or MAP_EDGE_* */
+    int distance[4];                /**< Per Direction: cells to that MapNode */
+} MapNode;
+
+/**
+ * @struct MapTrie
+ * @brief One level of the trie; only written while unshared.
+ */
+typedef struct MapTrie {
+    int refs;                       /**< Versions and trie levels holding this level */
+    void *slots[MAP_VERSION_FANOUT];/**< MapTrie on the upper levels, MapNode on the lowest */
+} MapTrie;
+
+/**
+ * @struct MapVersion
+ * @brief One version of the map, owning a reference to its trie.
+ */
+typedef struct MapVersion {
+    MapTrie *root;                  /**< NULL while the version is empty */
+    int levels;                     /**< Trie levels, IDs below 32^levels fit */
+    int num_nodes;                  /**< Highest MapNode ID plus one */
+    int num_frontier;               /**< MapNodes with an unexplored path */
+} MapVersion;
+
+// Version of the explored map kept up to date once a search asked for it, swapped with the
+// other globals by simulations (see simulation.h)
+extern MapVersion live_map_version;
+
+void map_version_fork(const MapVersion *from, MapVersion *to);
+void map_version_release(MapVersion *version);
+
+const MapNode *map_version_get(const MapVersion *version, int id);
+bool map_version_set_node(MapVersion *version, int id, Location location, const int end[4], const int distance[4]);
+bool map_version_set_path(MapVersion *version, int id, Direction direction, int end, int distance);
+int map_version_find(const MapVersion *version, Location location);
+
+// Copy the MapPoints changed since the last sync into the live version, all of them at first
+bool map_version_sync_live();
+
+// Preallocate the nodes, trie levels and search arrays of the live versions and one fork
+void map_version_reserve(int max_nodes, int fork_edits, int live_versions);
+
+// Closest MapNode with an unexplored path over explored paths
+int map_version_nearest_frontier(const MapVersion *version, int from, int *distance);
+
+#endif // MAP_VERSION_H
@@ -0,0 +1,75 @@
+#include "min_heap.h"
+
+/**
+ * @brief Checks if an entry pops before another one.
+ *
+ * @param a Pointer to the first entry.
+ * @param b Pointer to the second entry.
+ * @return bool True if a has the smaller key, or the same key and the smaller id.
+ */
+static bool entry_before(const MinHeapEntry *a, const MinHeapEntry *b) {
+    return a->key < b->key || (a->key == b->key && a->id < b->id);
+}
+
+/**
+ * @brief Starts an empty heap on the given storage.
+ *
+ * @param heap Pointer to the heap.
+ * @param entries Storage for capacity entries, e.g. a static array.
+ * @param capacity Maximum number of queued entries.
+ */
+void min_heap_init(MinHeap *heap, MinHeapEntry *entries, int capacity) {
+    heap->entries = entries;
+    heap->size = 0;
+    heap->capacity = capacity;
+}
+
+/**
+ * @brief Queues an id with a key.
+ *
+ * @param heap Pointer to the heap.
+ * @param key Key of the entry, e.g. a distance.
+ * @param id ID of the entry.
+ * @return bool True if the entry was queued, false if the heap is full.
+ */
+bool min_heap_push(MinHeap *heap, int key, int id) {
+    if (heap->size >= heap->capacity) return false;
+
+    // Move the new entry up from the bottom
+    MinHeapEntry entry = {key, id};
+    int slot = heap->size++;
+    while (slot > 0 && entry_before(&entry, &heap->entries[(slot - 1) / 2])) {
+        heap->entries[slot] = heap->entries[(slot - 1) / 2];
+        slot = (slot - 1) / 2;
+    }
+    heap->entries[slot] = entry;
+    return true;
+}
+
+/**
+ * @brief Removes the entry with the smallest key.
+ *
+ * @param heap Pointer to the heap.
+ * @param key Pointer to store the key of the entry in.
+ * @param id Pointer to store the ID of the entry in.
+ * @return bool True if an entry was removed, false if the heap is empty.
+ */
+bool min_heap_pop(MinHeap *heap, int *key, int *id) {
+    if (heap->size == 0) return false;
+
+    *key = heap->entries[0].key;
+    *id = heap->entries[0].id;
+
+    // Move the last entry down from the top
+    MinHeapEntry moved = heap->entries[--heap->size];
+    int hole = 0;
+    while (2 * hole + 1 < heap->size) {
+        int child = 2 * hole + 1;
+        if (child + 1 < heap->size && entry_before(&heap->entries[child + 1], &heap->entries[child])) child++;
+        if (!entry_before(&heap->entries[child], &moved)) break;
+        heap->entries[hole] = heap->entries[child];
+        hole = child;
+    }
+    heap->entries[hole] = moved;
+    return true;
+}
@@ -0,0 +1,25 @@
+#ifndef MIN_HEAP_H
+#define MIN_HEAP_H
+
+#include <stdbool.h>
+
+// Binary min-heap of (key, id) pairs on storage owned by the caller, for Dijkstra searches
+// with lazy deletion: an id is pushed again whenever its key improves, and entries whose key
+// is no longer current are skipped when popped. Equal keys pop in ascending id order, the
+// order a linear scan over the ids would settle them in.
+typedef struct MinHeapEntry {
+    int key;
+    int id;
+} MinHeapEntry;
+
+typedef struct MinHeap {
+    MinHeapEntry *entries;
+    int size;
+    int capacity;
+} MinHeap;
+
+void min_heap_init(MinHeap *heap, MinHeapEntry *entries, int capacity);
+bool min_heap_push(MinHeap *heap, int key, int id);
+bool min_heap_pop(MinHeap *heap, int *key, int *id);
+
+#endif // MIN_HEAP_H
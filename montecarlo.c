@@ -0,0 +1,311 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/wait.h>
+#include "montecarlo.h"
+#include "simulation.h"
+#include "noise.h"
+
+// As in a tournament (tournament.h), the exploration code works on the globals of globals.h,
+// so the episodes run in forked workers; worker w plays the episodes w, w + workers, ... and
+// sends one result per episode back through a pipe.
+
+#define MONTE_CARLO_TICKS_PER_CELL 16   // An episode still exploring after this many ticks per track cell is stopped
+#define MONTE_CARLO_MAX_WORKERS 256
+#define MONTE_CARLO_WATCHDOG_SECONDS 10 // An episode still running after this long is killed with its worker
+
+// How an episode ended
+typedef enum {
+    EPISODE_OPTIMAL_LAP = 0,    // Finished with the shortest lap of the track in its map
+    EPISODE_LAP = 1,            // Finished with another lap, longer or through misread paths
+    EPISODE_NO_LAP = 2,         // Finished without a lap
+    EPISODE_STOPPED = 3         // Stopped by the tick limit
+} EpisodeOutcome;
+
+/**
+ * @struct EpisodeResult
+ * @brief What a worker sends back per episode.
+ */
+typedef struct EpisodeResult {
+    uint32_t ticks;
+    uint32_t outcome;           /**< EpisodeOutcome */
+} EpisodeResult;
+
+/**
+ * @brief Explores one track once with its own noise streams.
+ *
+ * @param track Variant of the loop track.
+ * @param episode Number of the episode in the batch, keys its noise streams.
+ * @param seed Seed of the batch.
+ * @return EpisodeResult How the episode ended.
+ */
+static EpisodeResult play_episode(int track, uint64_t episode, uint64_t seed) {
+    Simulation sim;
+    Scoreboard scoreboard;
+    simulation_init(&sim, track);
+    noise_stream_init(&sim.sensor_noise, seed, episode, NOISE_STREAM_SENSORS);
+    noise_stream_init(&sim.motor_noise, seed, episode, NOISE_STREAM_MOTORS);
+    simulation_start_scoring(&sim, &scoreboard);
+
+    EpisodeResult result = {0, EPISODE_NO_LAP};
+    unsigned long tick_limit = (unsigned long) (sim.track->on_track * MONTE_CARLO_TICKS_PER_CELL);
+    while (exploration_step(&sim) != EXPLORATION_DONE) {
+        if (sim.exploration.ticks >= tick_limit) {
+            result.outcome = EPISODE_STOPPED;
+            break;
+        }
+    }
+    result.ticks = (uint32_t) sim.exploration.ticks;
+
+    if (result.outcome != EPISODE_STOPPED) {
+        ScoreReport report;
+        simulation_score(&sim, &report);
+        if (report.laps_missing == 0) {
+            result.outcome = report.lap == report.optimal_lap ? EPISODE_OPTIMAL_LAP : EPISODE_LAP;
+        }
+    }
+    scoreboard_free(&scoreboard);
+    simulation_free(&sim);
+    return result;
+}
+
+/**
+ * @brief Writes a whole buffer to a pipe.
+ *
+ * @param fd Write end of the pipe.
+ * @param data Buffer to write.
+ * @param size Bytes to write.
+ * @return bool True if everything was written.
+ */
+static bool write_all(int fd, const void *data, size_t size) {
+    size_t sent = 0;
+    while (sent < size) {
+        ssize_t n = write(fd, (const char *) data + sent, size - sent);
+        if (n <= 0) return false;
+        sent += (size_t) n;
+    }
+    return true;
+}
+
+/**
+ * @brief Reads a whole buffer from a pipe.
+ *
+ * @param fd Read end of the pipe.
+ * @param data Buffer to fill.
+ * @param size Bytes to read.
+ * @return bool True if everything arrived.
+ */
+static bool read_all(int fd, void *data, size_t size) {
+    size_t received = 0;
+    while (received < size) {
+        ssize_t n = read(fd, (char *) data + received, size - received);
+        if (n <= 0) return false;
+        received += (size_t) n;
+    }
+    return true;
+}
+
+/**
+ * @brief Compares two tick counts for qsort().
+ *
+ * @param a Pointer to a uint32_t.
+ * @param b Pointer to a uint32_t.
+ * @return int Negative if a is smaller.
+ */
+static int compare_ticks(const void *a, const void *b) {
+    uint32_t x = *(const uint32_t *) a, y = *(const uint32_t *) b;
+    return (x > y) - (x < y);
+}
+
+/**
+ * @brief Prints the outcome counts and time-to-lap percentiles of a set of episodes.
+ *
+ * @param label Name of the row.
+ * @param results Results of the episodes.
+ * @param count Number of episodes.
+ * @param ticks Scratch space for count tick counts.
+ */
+static void print_row(const char *label, const EpisodeResult *results, int count, uint32_t *ticks) {
+    int outcomes[4] = {0, 0, 0, 0};
+    int laps = 0;
+    double total = 0.0;
+    for (int i = 0; i < count; i++) {
+        outcomes[results[i].outcome]++;
+        if (results[i].outcome == EPISODE_OPTIMAL_LAP || results[i].outcome == EPISODE_LAP) {
+            ticks[laps++] = results[i].ticks;
+            total += results[i].ticks;
+        }
+    }
+    qsort(ticks, (size_t) laps, sizeof(uint32_t), compare_ticks);
+
+    printf("  %-6s %8.2f%% %8.2f%% %8d %8d", label, 100.0 * laps / count, 100.0 * outcomes[EPISODE_OPTIMAL_LAP] / count,
+           outcomes[EPISODE_NO_LAP], outcomes[EPISODE_STOPPED]);
+    if (laps == 0) {
+        printf(" %7s %7s %7s %7s %8s\n", "-", "-", "-", "-", "-");
+        return;
+    }
+    const double percentiles[3] = {50.0, 90.0, 99.0};
+    for (int p = 0; p < 3; p++) {
+        int rank = (int) (percentiles[p] / 100.0 * laps + 0.5);
+        printf(" %7u", ticks[rank > 0 ? rank - 1 : 0]);
+    }
+    printf(" %7u %8.1f\n", ticks[laps - 1], total / laps);
+}
+
+/**
+ * @brief Forks a worker that plays the episodes first, first + stride, ... and sends each
+ *        result through a pipe as soon as the episode ends.
+ *
+ * Every episode runs under an alarm, so a worker stuck within a tick is killed by SIGALRM
+ * instead of holding up the batch.
+ *
+ * @param first First episode of the worker.
+ * @param stride Distance between two episodes of the worker.
+ * @param total Number of episodes of the batch.
+ * @param episodes Episodes per track.
+ * @param seed Seed of the batch.
+ * @param read_end Pointer to store the read end of the worker's pipe in.
+ * @return pid_t Process ID of the worker, -1 if it could not be started.
+ */
+static pid_t start_worker(int first, int stride, int total, int episodes, uint64_t seed, int *read_end) {
+    int fds[2];
+    if (pipe(fds) != 0) {
+        perror("Error: Failed to create a Monte-Carlo pipe");
+        return -1;
+    }
+
+    // Nothing buffered may be printed twice by the workers
+    fflush(stdout);
+    fflush(stderr);
+    pid_t child = fork();
+    if (child < 0) {
+        perror("Error: Failed to start a Monte-Carlo worker");
+        close(fds[0]);
+        close(fds[1]);
+        return -1;
+    }
+    if (child == 0) {
+        close(fds[0]);
+        // Only the parent prints the table. Misread maps make the navigation complain in many
+        // episodes, on both streams; the table counts them instead
+        int quiet = open("/dev/null", O_WRONLY);
+        if (quiet >= 0) {
+            dup2(quiet, STDOUT_FILENO);
+            if (noise_enabled) dup2(quiet, STDERR_FILENO);
+            close(quiet);
+        }
+        for (int i = first; i < total; i += stride) {
+            alarm(MONTE_CARLO_WATCHDOG_SECONDS);
+            EpisodeResult result = play_episode(i / episodes, (uint64_t) i, seed);
+            alarm(0);
+            if (!write_all(fds[1], &result, sizeof(result))) _exit(EXIT_FAILURE);
+        }
+        _exit(EXIT_SUCCESS);
+    }
+    close(fds[1]);
+    *read_end = fds[0];
+    return child;
+}
+
+/**
+ * @brief Explores every track the given number of times with the current noise model.
+ *
+ * @param episodes Episodes per track.
+ * @param tracks Number of variants of the loop track to explore, at most NUM_TRACK_VARIANTS.
+ * @param seed Seed of the noise streams.
+ * @return bool True if every worker finished.
+ */
+bool run_monte_carlo(int episodes, int tracks, uint64_t seed) {
+    if (tracks < 1 || tracks > NUM_TRACK_VARIANTS || episodes < 1) {
+        fprintf(stderr, "Error: Monte-Carlo runs need episodes and 1 to %d tracks\n", NUM_TRACK_VARIANTS);
+        return false;
+    }
+    int total = episodes * tracks;
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    int workers = cores < 1 ? 1 : cores > MONTE_CARLO_MAX_WORKERS ? MONTE_CARLO_MAX_WORKERS : (int) cores;
+    if (workers > total) workers = total;
+
+    EpisodeResult *results = malloc((size_t) total * sizeof(EpisodeResult));
+    uint32_t *ticks = malloc((size_t) total * sizeof(uint32_t));
+    if (!results || !ticks) {
+        perror("Error: Failed to allocate Monte-Carlo results");
+        exit(EXIT_FAILURE);
+    }
+    pid_t children[MONTE_CARLO_MAX_WORKERS];
+    int pipes[MONTE_CARLO_MAX_WORKERS];
+    int started = 0;
+
+    struct timespec begin, end;
+    clock_gettime(CLOCK_MONOTONIC, &begin);
+
+    for (int w = 0; w < workers; w++) {
+        children[started] = start_worker(w, workers, total, episodes, seed, &pipes[started]);
+        if (children[started] < 0) break;
+        started++;
+    }
+
+    // The workers block on full pipes until their turn, so each is read before it is waited for.
+    // A worker killed by the watchdog loses the episode it was stuck in, and a new worker plays
+    // the rest of its episodes.
+    int finished = 0, hung = 0;
+    for (int w = 0; w < started; w++) {
+        pid_t child = children[w];
+        int fd = pipes[w];
+        int next = w;
+        bool arrived = true;
+        while (child >= 0) {
+            if (next < total && read_all(fd, &results[next], sizeof(EpisodeResult))) {
+                next += workers;
+                continue;
+            }
+            close(fd);
+            int status;
+            bool exited = waitpid(child, &status, 0) == child;
+            child = -1;
+            if (exited && WIFEXITED(status) && WEXITSTATUS(status) == EXIT_SUCCESS && next >= total) break;
+            if (!exited || !WIFSIGNALED(status) || WTERMSIG(status) != SIGALRM || next >= total) {
+                arrived = false;
+                break;
+            }
+
+            results[next] = (EpisodeResult) {0, EPISODE_STOPPED};
+            hung++;
+            next += workers;
+            if (next < total) {
+                child = start_worker(next, workers, total, episodes, seed, &fd);
+                if (child < 0) arrived = false;
+            }
+        }
+        if (arrived) finished++;
+    }
+    bool complete = finished == workers;
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double elapsed_ms = (end.tv_sec - begin.tv_sec) * 1e3 + (end.tv_nsec - begin.tv_nsec) / 1e6;
+
+    if (complete) {
+        printf("Monte-Carlo: %d episodes on each of %d tracks, %d workers, %.3f ms (%.0f episodes/s)\n", episodes,
+               tracks, workers, elapsed_ms, elapsed_ms > 0 ? total / (elapsed_ms / 1e3) : 0.0);
+        printf("Noise: false positives %.3f, false negatives %.3f, range sigma %.2f cells, missed moves %.3f, seed %llu\n",
+               noise_model.false_positive, noise_model.false_negative, noise_model.range_sigma,
+               noise_model.missed_move, (unsigned long long) seed);
+        printf("  %-6s %9s %9s %8s %8s %7s %7s %7s %7s %8s   (ticks to lap)\n", "track", "success", "optimal",
+               "no lap", "stopped", "p50", "p90", "p99", "max", "mean");
+        for (int track = 0; track < tracks; track++) {
+            char label[8];
+            snprintf(label, sizeof(label), "%d", track);
+            print_row(label, results + track * episodes, episodes, ticks);
+        }
+        if (tracks > 1) print_row("all", results, total, ticks);
+        if (hung > 0) printf("%d episodes hung and were stopped by the watchdog\n", hung);
+    } else {
+        fprintf(stderr, "Error: %d of %d Monte-Carlo workers did not finish\n", workers - finished, workers);
+    }
+
+    free(ticks);
+    free(results);
+    return complete;
+}
@@ -0,0 +1,19 @@
+#ifndef MONTECARLO_H
+#define MONTECARLO_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// ======================= MONTE-CARLO RUNS ======================= //
+//
+// Many explorations of the variants of the loop track with the noise model of noise.h, spread
+// over one process per core. An episode succeeds if the exploration ends within the tick limit
+// with a lap in its map; the ticks it took are its time to lap. Every episode draws from its own
+// noise streams, keyed by the seed and the episode's number, so a batch gives the same results
+// on any number of cores.
+
+// Explore every track the given number of times with the current noise model and print the
+// success rate and the distribution of the time to lap
+bool run_monte_carlo(int episodes, int tracks, uint64_t seed);
+
+#endif // MONTECARLO_H
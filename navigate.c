@@ -4,6 +4,9 @@
 #include "algorithm_structs_PUBLIC/Path.h"
 #include "track_files_PRIVATE/track_navigation.h"
 #include "algorithm_structs_PUBLIC/MapPoint.h"
+#include "instrumentation.h"
+#include "telemetry.h"
+#include "trace.h"
 
 /**
  * @brief Rotates the car to face the specified direction.
@@ -20,41 +23,87 @@ void rotate_to(Direction target_direction) {
  * @param p Pointer to the Path structure containing the route.
  */
 void navigate_path(const Path *p) {
+    uint64_t navigation_start = trace_enabled ? telemetry_now() : 0;
+    RouteCursor cursor;
+    route_cursor_init(&cursor, p);
+
+    while (navigate_path_step(&cursor)) {
+        print_grid();  // Visualize movement on the grid
+    }
+    if (trace_enabled) trace_span("navigate_path", navigation_start, telemetry_now(), "distance", p ? p->totalDistance : 0);
+}
+
+/**
+ * @brief Prepares a cursor to drive the given path one cell at a time.
+ *
+ * @param cursor Pointer to the cursor to initialize.
+ * @param p Pointer to the Path structure containing the route.
+ */
+void route_cursor_init(RouteCursor *cursor, const Path *p) {
+    cursor->path = p;
+    cursor->step = 0;
+    cursor->cell = 0;
+    cursor->finished = false;
+}
+
+/**
+ * @brief Moves the car one cell further along the route of a cursor.
+ *
+ * Once the final destination is reached, the car is turned towards an unexplored
+ * FundamentalPath and the route is finished.
+ *
+ * @param cursor Pointer to the cursor of the route being driven.
+ * @return bool True if the car moved one cell, false once the route is finished.
+ */
+bool navigate_path_step(RouteCursor *cursor) {
+    INSTRUMENT_FUNCTION(COUNTER_NAVIGATE_STEP);
+    INSTRUMENT_PHASE(TIMER_NAVIGATION);
+    const Path *p = cursor->path;
+
     // Validate the path before proceeding
-    if (!p || !p->route || p->totalDistance == 0) {
-        return;
+    if (cursor->finished || !p || !p->route || p->totalDistance == 0) {
+        cursor->finished = true;
+        return false;
     }
 
     // Iterate through each step in the path
-    for (int i = 0; i < p->totalDistance; i++) {
-        FundamentalPath *step = p->route[i];
+    while (cursor->step < p->routeLength) {
+        FundamentalPath *step = p->route[cursor->step];
 
-        // Stop if the car has reached the final destination
-        if (current_car.current_location.x == p->end->location.x &&
-            current_car.current_location.y == p->end->location.y) {
-            break;
-        }
+        if (cursor->cell == 0) {
+            // Stop if the car has reached the final destination
+            if (current_car.current_location.x == p->end->location.x &&
+                current_car.current_location.y == p->end->location.y) {
+                break;
+            }
 
-        // Validate the step before proceeding
-        if (!step || !step->end) {
-            return;
-        }
+            // Validate the step before proceeding
+            if (!step || !fp_end(step)) {
+                cursor->finished = true;
+                return false;
+            }
 
-        // Rotate the car to align with the required direction
-        rotate_to(step->direction);
+            // Rotate the car to align with the required direction
+            rotate_to(step->direction);
+        }
 
         // Move forward along the path
-        for (int j = 0; j < step->distance; j++) {
+        if (cursor->cell < step->distance) {
             move_forward();
-            print_grid();  // Visualize movement on the grid
+            cursor->cell++;
+            return true;
         }
 
         // Update the car's position after completing the movement
-        current_car.current_location = step->end->location;
+        current_car.current_location = mp_location(fp_end(step));
+        cursor->step++;
+        cursor->cell = 0;
     }
 
     // Adjust the car's orientation after reaching the final destination
     turn_to_undiscovered_fundamental_path(p->end);
+    cursor->finished = true;
+    return false;
 }
 
 /**
@@ -65,7 +114,7 @@ void navigate_path(const Path *p) {
 void turn_to_undiscovered_fundamental_path(MapPoint* mp) {
     for (int i = 0; i < mp->numberOfPaths; i++) {
         // Check for an unexplored path
-        if (mp->paths[i].end == NULL) {
+        if (fp_end(&mp->paths[i]) == NULL) {
             current_car.current_orientation = mp->paths[i].direction;
             break;
         }
@@ -6,6 +6,16 @@
 #define NAVIGATE_H
 #include "algorithm_structs_PUBLIC/Path.h"
 
+// Progress of the car along a route driven one cell at a time
+typedef struct RouteCursor {
+    const Path *path;
+    int step;          // Index of the FundamentalPath being driven
+    int cell;          // Cells driven along that FundamentalPath
+    bool finished;
+} RouteCursor;
+
 void navigate_path(const Path *p) ;
+void route_cursor_init(RouteCursor *cursor, const Path *p);
+bool navigate_path_step(RouteCursor *cursor);
 void turn_to_undiscovered_fundamental_path(MapPoint* mp);
 #endif //NAVIGATE_H
@@ -0,0 +1,113 @@
+#include "noise.h"
+#include "track_files_PRIVATE/track_detection.h"
+
+#define NOISE_GAMMA 0x9E3779B97F4A7C15ULL   // Odd constant spreading consecutive counters apart
+
+NoiseModel noise_model = {0.0, 0.0, 0.0, 0.0};
+bool noise_enabled = false;
+NoiseStream sensor_noise = {0, 0};
+NoiseStream motor_noise = {0, 0};
+
+// ======================= GENERATOR ======================= //
+
+/**
+ * @brief Scrambles a 64-bit word (the SplitMix64 finalizer).
+ *
+ * @param z Word to scramble.
+ * @return uint64_t The scrambled word.
+ */
+static uint64_t mix64(uint64_t z) {
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+/**
+ * @brief Sets the noise of the sensors and motors.
+ *
+ * @param model Pointer to the noise model, all zero for a perfect car.
+ */
+void noise_model_set(const NoiseModel *model) {
+    noise_model = *model;
+    noise_enabled = model->false_positive > 0.0 || model->false_negative > 0.0 || model->range_sigma > 0.0 ||
+                    model->missed_move > 0.0;
+}
+
+/**
+ * @brief Starts a stream at its first number.
+ *
+ * @param stream Pointer to the stream.
+ * @param seed Seed of the whole batch of episodes.
+ * @param episode Number of the episode the stream belongs to.
+ * @param kind Which of the episode's streams it is.
+ */
+void noise_stream_init(NoiseStream *stream, uint64_t seed, uint64_t episode, NoiseStreamKind kind) {
+    stream->key = mix64(mix64(seed) + NOISE_GAMMA * (episode * 2 + (uint64_t) kind + 1));
+    stream->counter = 0;
+}
+
+/**
+ * @brief Draws the next number of a stream.
+ *
+ * @param stream Pointer to the stream.
+ * @return uint64_t A hash of the stream's key and the number of earlier draws.
+ */
+uint64_t noise_next(NoiseStream *stream) {
+    return mix64(stream->key + NOISE_GAMMA * ++stream->counter);
+}
+
+/**
+ * @brief Draws a uniform number of a stream.
+ *
+ * @param stream Pointer to the stream.
+ * @return double A number in [0, 1).
+ */
+double noise_uniform(NoiseStream *stream) {
+    return (double) (noise_next(stream) >> 11) * 0x1.0p-53;
+}
+
+/**
+ * @brief Draws an approximately standard normal number of a stream.
+ *
+ * The sum of four uniform numbers (Irwin-Hall) needs no math library and is close enough
+ * for range noise; it never leaves +-3.5 deviations.
+ *
+ * @param stream Pointer to the stream.
+ * @return double A number with mean 0 and deviation 1.
+ */
+static double noise_gaussian(NoiseStream *stream) {
+    double sum = 0.0;
+    for (int i = 0; i < 4; i++) sum += noise_uniform(stream);
+    return (sum - 2.0) * 1.7320508075688772;   // sqrt(12 / 4)
+}
+
+// ======================= SENSORS AND MOTORS ======================= //
+
+/**
+ * @brief Turns the perfect ranges of the sensors into noisy ones.
+ *
+ * With range noise the measured range is rounded to whole cells, so a sensor reads a free
+ * path when it measured at least half a cell; the misreadings are applied afterwards.
+ *
+ * @param ranges Free cells in front of the {forward, left, right} sensors, changed in place.
+ */
+void noise_apply_ranges(int ranges[3]) {
+    for (int i = 0; i < 3; i++) {
+        if (noise_model.range_sigma > 0.0) {
+            double measured = ranges[i] + noise_model.range_sigma * noise_gaussian(&sensor_noise) + 0.5;
+            ranges[i] = measured < 1.0 ? 0 : measured >= ULTRASONIC_RANGE_CELLS ? ULTRASONIC_RANGE_CELLS : (int) measured;
+        }
+        bool free_path = ranges[i] > 0;
+        double misread = free_path ? noise_model.false_positive : noise_model.false_negative;
+        if (misread > 0.0 && noise_uniform(&sensor_noise) < misread) ranges[i] = free_path ? 0 : 1;
+    }
+}
+
+/**
+ * @brief Checks if the next motor command is skipped.
+ *
+ * @return bool True if the rotation or step forward does not happen.
+ */
+bool noise_missed_move() {
+    return noise_model.missed_move > 0.0 && noise_uniform(&motor_noise) < noise_model.missed_move;
+}
@@ -0,0 +1,63 @@
+#ifndef NOISE_H
+#define NOISE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// ======================= NOISE MODELS ======================= //
+//
+// Imperfect sensors and motors for robustness runs. The ultrasonic sensors measure the free
+// cells in front of them (measure_ultrasonic_ranges()) with Gaussian range noise and then
+// misread with a fixed probability: a false positive sees a wall on a free path, a false
+// negative misses a wall. A motor command (one rotation or one cell forward) is skipped with
+// the missed-move probability.
+//
+// Every draw comes from a counter-based generator: the n-th number of a stream is a hash of
+// the stream's key and n, so a stream is reproduced from its key alone, no matter which
+// thread or process runs it. Sensors and motors draw from separate streams, which the staged
+// pipeline (pipeline.h) reads on separate threads, and simulations swap both with the other
+// globals (simulation.h). Without noise no number is drawn and the car behaves as before.
+
+/**
+ * @struct NoiseModel
+ * @brief How wrong the sensors and motors are; all zero for a perfect car.
+ */
+typedef struct NoiseModel {
+    double false_positive;      /**< Probability a free path reads as blocked */
+    double false_negative;      /**< Probability a blocked path reads as free */
+    double range_sigma;         /**< Standard deviation of a range reading, in cells */
+    double missed_move;         /**< Probability a rotation or step forward does not happen */
+} NoiseModel;
+
+/**
+ * @struct NoiseStream
+ * @brief A counter-based random stream.
+ */
+typedef struct NoiseStream {
+    uint64_t key;
+    uint64_t counter;           /**< Numbers drawn so far */
+} NoiseStream;
+
+// Kinds of streams of one episode
+typedef enum {
+    NOISE_STREAM_SENSORS = 0,
+    NOISE_STREAM_MOTORS = 1
+} NoiseStreamKind;
+
+extern NoiseModel noise_model;
+extern bool noise_enabled;              // Set by noise_model_set() when any probability or sigma is non-zero
+extern NoiseStream sensor_noise;        // Drawn by update_ultrasonic_sensors()
+extern NoiseStream motor_noise;         // Drawn by the motor commands
+
+void noise_model_set(const NoiseModel *model);
+void noise_stream_init(NoiseStream *stream, uint64_t seed, uint64_t episode, NoiseStreamKind kind);
+uint64_t noise_next(NoiseStream *stream);
+double noise_uniform(NoiseStream *stream);
+
+// Turn the perfect ranges of the sensors into noisy ones
+void noise_apply_ranges(int ranges[3]);
+
+// Check if the next motor command is skipped
+bool noise_missed_move();
+
+#endif // NOISE_H
@@ -0,0 +1,210 @@
+#include <stdlib.h>
+#include <string.h>
+#include "occupancy.h"
+#include "alloc_tracker.h"
+#include "direction.h"
+#include "track_files_PRIVATE/track_generation.h"
+#include "track_files_PRIVATE/track_detection.h"
+
+_Static_assert(ULTRASONIC_RANGE_CELLS + 1 <= OCCUPANCY_ROW_PAD, "A beam and its wall must fit one row update");
+
+// Log-odds of a row update; the add is done unsigned so a lane may wrap before it is saturated
+typedef int8_t CellLanes __attribute__((vector_size(OCCUPANCY_ROW_PAD)));
+typedef uint8_t CellLanesUnsigned __attribute__((vector_size(OCCUPANCY_ROW_PAD)));
+
+OccupancyMode occupancy_mode = OCCUPANCY_OFF;
+OccupancyGrid occupancy_grid = {0, 0, 0, NULL, 0};
+
+static const int step_x[4] = {0, 1, 0, -1};    // Per Direction
+static const int step_y[4] = {-1, 0, 1, 0};
+
+/**
+ * @brief Looks up an occupancy mode by its name.
+ *
+ * @param name "off", "record" or "fuse".
+ * @param mode Pointer to store the mode in.
+ * @return bool True if the name is known.
+ */
+bool occupancy_mode_parse(const char *name, OccupancyMode *mode) {
+    static const char *const names[3] = {"off", "record", "fuse"};
+    for (int i = 0; i < 3; i++) {
+        if (strcmp(name, names[i]) == 0) {
+            *mode = (OccupancyMode) i;
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Allocates an empty grid for the current track, unless the grid already fits it.
+ */
+void occupancy_reserve() {
+    if (occupancy_grid.cells && occupancy_grid.width == track_width() && occupancy_grid.height == track_height()) {
+        return;
+    }
+    occupancy_free();
+
+    occupancy_grid.width = track_width();
+    occupancy_grid.height = track_height();
+    occupancy_grid.stride = occupancy_grid.width + OCCUPANCY_ROW_PAD;
+    size_t bytes = (size_t) occupancy_grid.stride * (size_t) occupancy_grid.height;
+    occupancy_grid.cells = tracked_malloc(ALLOC_OCCUPANCY, bytes);
+    if (!occupancy_grid.cells) {
+        perror("Failed to allocate occupancy grid");
+        exit(EXIT_FAILURE);
+    }
+    memset(occupancy_grid.cells, 0, bytes);
+    occupancy_grid.readings = 0;
+}
+
+/**
+ * @brief Frees the grid.
+ */
+void occupancy_free() {
+    free(occupancy_grid.cells);
+    occupancy_grid = (OccupancyGrid) {0, 0, 0, NULL, 0};
+}
+
+// ======================= BEAMS ======================= //
+
+/**
+ * @brief Adds log-odds to a cell, saturating at the int8 limits.
+ *
+ * @param cell Pointer to the cell.
+ * @param delta Log-odds to add.
+ */
+static inline void add_cell(int8_t *cell, int delta) {
+    int sum = *cell + delta;
+    *cell = (int8_t) (sum > INT8_MAX ? INT8_MAX : sum < INT8_MIN ? INT8_MIN : sum);
+}
+
+/**
+ * @brief Adds log-odds to OCCUPANCY_ROW_PAD consecutive cells of a row at once, saturating.
+ *
+ * A lane overflowed if both addends have the same sign and the sum the other one; it is
+ * then set to the limit of the sign of the delta.
+ *
+ * @param cells Pointer to the first cell, followed by at least OCCUPANCY_ROW_PAD bytes of the row.
+ * @param deltas Log-odds per cell, 0 for the cells to leave alone.
+ */
+static void add_row(int8_t *cells, const int8_t deltas[OCCUPANCY_ROW_PAD]) {
+    CellLanes old, delta;
+    memcpy(&old, cells, sizeof(old));
+    memcpy(&delta, deltas, sizeof(delta));
+
+    CellLanes sum = (CellLanes) ((CellLanesUnsigned) old + (CellLanesUnsigned) delta);
+    CellLanes overflow = ((old ^ sum) & (delta ^ sum)) >> 7;    // All ones where the sign flipped
+    CellLanes limit = (delta >> 7) ^ INT8_MAX;                  // INT8_MAX or INT8_MIN
+    sum = (sum & ~overflow) | (limit & overflow);
+    memcpy(cells, &sum, sizeof(sum));
+}
+
+/**
+ * @brief Adds the evidence of one beam: the cells it measured as free and the wall it ends at.
+ *
+ * A beam that leaves the grid or reaches the end of the sensor's range saw no wall.
+ *
+ * @param x Column of the car.
+ * @param y Row of the car.
+ * @param direction Direction of the beam.
+ * @param range Free cells measured.
+ */
+static void add_beam(int x, int y, Direction direction, int range) {
+    int dx = step_x[direction], dy = step_y[direction];
+    int free_cells = 0;
+    while (free_cells < range) {
+        int cx = x + dx * (free_cells + 1), cy = y + dy * (free_cells + 1);
+        if (cx < 0 || cy < 0 || cx >= occupancy_grid.width || cy >= occupancy_grid.height) break;
+        free_cells++;
+    }
+    int wall_x = x + dx * (free_cells + 1), wall_y = y + dy * (free_cells + 1);
+    int wall = free_cells == range && range < ULTRASONIC_RANGE_CELLS && wall_x >= 0 && wall_y >= 0 &&
+               wall_x < occupancy_grid.width && wall_y < occupancy_grid.height;
+    if (free_cells + wall == 0) return;
+
+    int8_t *row = occupancy_grid.cells + (size_t) y * (size_t) occupancy_grid.stride;
+    if (dy == 0) {
+        // Along the row: the beam and its wall are consecutive cells
+        int8_t deltas[OCCUPANCY_ROW_PAD] = {0};
+        int first;
+        if (dx > 0) {
+            first = x + 1;
+            for (int i = 0; i < free_cells; i++) deltas[i] = OCCUPANCY_MISS;
+            if (wall) deltas[free_cells] = OCCUPANCY_HIT;
+        } else {
+            first = x - free_cells - wall;
+            if (wall) deltas[0] = OCCUPANCY_HIT;
+            for (int i = 0; i < free_cells; i++) deltas[wall + i] = OCCUPANCY_MISS;
+        }
+        add_row(row + first, deltas);
+        return;
+    }
+
+    // Along the column: one cell per row
+    for (int i = 1; i <= free_cells; i++) add_cell(row + (ptrdiff_t) dy * i * occupancy_grid.stride + x, OCCUPANCY_MISS);
+    if (wall) add_cell(row + (ptrdiff_t) dy * (free_cells + 1) * occupancy_grid.stride + x, OCCUPANCY_HIT);
+}
+
+/**
+ * @brief Gets the thresholded state of a cell.
+ *
+ * @param x Column of the cell.
+ * @param y Row of the cell.
+ * @return OccupancyState OCCUPANCY_UNKNOWN outside of the grid or without enough evidence.
+ */
+OccupancyState occupancy_state(int x, int y) {
+    if (!occupancy_grid.cells || x < 0 || y < 0 || x >= occupancy_grid.width || y >= occupancy_grid.height) {
+        return OCCUPANCY_UNKNOWN;
+    }
+    int8_t log_odds = occupancy_grid.cells[(size_t) y * (size_t) occupancy_grid.stride + (size_t) x];
+    if (log_odds >= OCCUPANCY_THRESHOLD) return OCCUPANCY_OCCUPIED;
+    if (log_odds <= -OCCUPANCY_THRESHOLD) return OCCUPANCY_FREE;
+    return OCCUPANCY_UNKNOWN;
+}
+
+/**
+ * @brief Adds the beams of one sensor reading and, when fusing, replaces the readings with
+ *        the thresholded cells next to the car.
+ *
+ * @param sensors Readings {forward, left, right}, true for a free path.
+ * @param x Column of the car.
+ * @param y Row of the car.
+ * @param orientation Direction the car faces.
+ * @param ranges Free cells measured by each sensor.
+ */
+void occupancy_sense(bool sensors[3], int x, int y, int orientation, const int ranges[3]) {
+    occupancy_reserve();
+    Direction forward = (Direction) orientation;
+    const Direction directions[3] = {forward, turn_left(forward), turn_right(forward)};
+
+    for (int i = 0; i < 3; i++) add_beam(x, y, directions[i], ranges[i]);
+    occupancy_grid.readings++;
+
+    if (occupancy_mode != OCCUPANCY_FUSE) return;
+    for (int i = 0; i < 3; i++) {
+        OccupancyState state = occupancy_state(x + step_x[directions[i]], y + step_y[directions[i]]);
+        if (state != OCCUPANCY_UNKNOWN) sensors[i] = state == OCCUPANCY_FREE;
+    }
+}
+
+/**
+ * @brief Prints how many cells are known and how many of them disagree with the track.
+ *
+ * @param out Stream to write to.
+ */
+void occupancy_report(FILE *out) {
+    long counts[3] = {0, 0, 0}, wrong = 0;
+    for (int y = 0; y < occupancy_grid.height; y++) {
+        for (int x = 0; x < occupancy_grid.width; x++) {
+            OccupancyState state = occupancy_state(x, y);
+            counts[state]++;
+            char cell = track_cell(x, y);
+            bool on_track = cell == TRACK || cell == START_FINISH;
+            if ((state == OCCUPANCY_FREE && !on_track) || (state == OCCUPANCY_OCCUPIED && on_track)) wrong++;
+        }
+    }
+    fprintf(out, "Occupancy grid: %lu readings, %ld free, %ld occupied, %ld unknown cells, %ld wrong\n",
+            occupancy_grid.readings, counts[OCCUPANCY_FREE], counts[OCCUPANCY_OCCUPIED], counts[OCCUPANCY_UNKNOWN],
+            wrong);
+}
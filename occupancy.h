@@ -0,0 +1,66 @@
+#ifndef OCCUPANCY_H
+#define OCCUPANCY_H
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+// ======================= OCCUPANCY GRID ======================= //
+//
+// Evidence of every sensor reading per cell of the track, so repeated noisy readings can be
+// fused (see noise.h). A cell holds the log-odds of being a wall as a saturating int8: every
+// beam adds OCCUPANCY_MISS to the cells it measured as free and OCCUPANCY_HIT to the wall it
+// ends at. Cells past the thresholds read as free or occupied; in OCCUPANCY_FUSE mode those
+// states replace the single readings the MapPoint builder gets from update_ultrasonic_sensors().
+//
+// Rows are padded so a beam along a row is one 16-lane saturating add; beams along a column
+// touch one cell per row and are added cell by cell. The grid belongs to the map: like the
+// track it is sized by, it is taken from the heap at the first reading (or by
+// exploration_presize()), and simulations swap it with the other globals.
+
+#define OCCUPANCY_HIT 12            // Log-odds of a wall at the end of a beam, in eighths of a nat
+#define OCCUPANCY_MISS (-6)         // Log-odds of a cell a beam passed
+#define OCCUPANCY_THRESHOLD 16      // Magnitude from which a cell is known free or occupied
+#define OCCUPANCY_ROW_PAD 16        // Lanes of a row update, padding after every row
+
+typedef enum {
+    OCCUPANCY_OFF = 0,              // Sensor readings are not recorded
+    OCCUPANCY_RECORD = 1,           // Readings are recorded, the MapPoint builder gets them unchanged
+    OCCUPANCY_FUSE = 2              // The MapPoint builder gets the thresholded cells where they are known
+} OccupancyMode;
+
+typedef enum {
+    OCCUPANCY_UNKNOWN = 0,
+    OCCUPANCY_FREE = 1,
+    OCCUPANCY_OCCUPIED = 2
+} OccupancyState;
+
+/**
+ * @struct OccupancyGrid
+ * @brief Log-odds per cell of the current track, row-major with padded rows.
+ */
+typedef struct OccupancyGrid {
+    int width, height;
+    int stride;                     /**< Bytes from one row to the next, at least width + OCCUPANCY_ROW_PAD */
+    int8_t *cells;                  /**< NULL until the first reading */
+    unsigned long readings;         /**< Sensor readings added */
+} OccupancyGrid;
+
+extern OccupancyMode occupancy_mode;
+extern OccupancyGrid occupancy_grid;
+
+bool occupancy_mode_parse(const char *name, OccupancyMode *mode);
+
+// Allocate the grid for the current track, or keep it if it fits
+void occupancy_reserve();
+void occupancy_free();
+
+// Add the beams of one reading {forward, left, right} and, when fusing, replace the readings
+void occupancy_sense(bool sensors[3], int x, int y, int orientation, const int ranges[3]);
+
+OccupancyState occupancy_state(int x, int y);
+
+// Count the known cells and compare them with the track
+void occupancy_report(FILE *out);
+
+#endif // OCCUPANCY_H
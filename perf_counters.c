@@ -0,0 +1,293 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "perf_counters.h"
+
+#ifdef __linux__
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#endif
+
+// ======================= HARDWARE COUNTERS ======================= //
+//
+// All events are opened as one perf_event group led by the cycle counter, so a single
+// read() returns consistent values of every event. The group counts the thread that opened
+// it in user space only; calls measured on other threads (pipeline stages) are skipped.
+// Events the CPU or hypervisor does not offer are left out of the group and reported as n/a.
+
+#define PERF_TOTALS_HEADER "# perf totals v1"
+
+/**
+ * @struct PerfTotals
+ * @brief Calls and event counts accumulated for one call site.
+ */
+typedef struct PerfTotals {
+    uint64_t calls;
+    uint64_t values[PERF_EVENT_COUNT];
+} PerfTotals;
+
+bool perf_counters_enabled = false;
+
+static PerfTotals totals[PERF_SITE_COUNT];
+static bool event_available[PERF_EVENT_COUNT];
+
+static const char *site_names[PERF_SITE_COUNT] = {
+    "tick", "simulation_tick", "sensors_tick", "sensors_decision", "shortest_path"
+};
+
+#ifdef __linux__
+
+static int group_fd = -1;
+static int event_fds[PERF_EVENT_COUNT];
+static int group_slot[PERF_EVENT_COUNT];    // Position of the event in a group read, -1 if absent
+static int group_size = 0;
+static pthread_t owner;
+
+/**
+ * @brief Opens one hardware event for the calling thread.
+ *
+ * @param type perf_event type of the event.
+ * @param config perf_event config of the event.
+ * @param leader File descriptor of the group leader, -1 to open the leader itself.
+ * @return int File descriptor of the event, -1 if the event is not available.
+ */
+static int open_event(uint32_t type, uint64_t config, int leader) {
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = type;
+    attr.config = config;
+    attr.disabled = leader == -1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_GROUP;
+    return (int) syscall(SYS_perf_event_open, &attr, 0, -1, leader, 0);
+}
+
+/**
+ * @brief Reads every event of the group.
+ *
+ * @param values Array to store the counts in, indexed by PerfEvent.
+ * @return bool True if the group was read, false otherwise.
+ */
+static bool read_group(uint64_t values[PERF_EVENT_COUNT]) {
+    uint64_t buffer[1 + PERF_EVENT_COUNT];
+    ssize_t expected = (ssize_t) ((1 + group_size) * sizeof(uint64_t));
+    if (read(group_fd, buffer, sizeof(buffer)) != expected) return false;
+
+    for (int i = 0; i < PERF_EVENT_COUNT; i++) {
+        values[i] = group_slot[i] >= 0 ? buffer[1 + group_slot[i]] : 0;
+    }
+    return true;
+}
+
+#endif // __linux__
+
+/**
+ * @brief Opens the hardware counters for the calling thread and starts counting.
+ *
+ * @return bool True if at least the cycle counter is available, false otherwise.
+ */
+bool perf_counters_start() {
+#ifdef __linux__
+    if (perf_counters_enabled) return true;
+
+    static const struct {uint32_t type; uint64_t config;} events[PERF_EVENT_COUNT] = {
+        {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+        {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+        {PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                             (PERF_COUNT_HW_CACHE_RESULT_MISS << 16)},
+        {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES},
+        {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+    };
+
+    group_fd = open_event(events[PERF_CYCLES].type, events[PERF_CYCLES].config, -1);
+    if (group_fd < 0) {
+        perror("Error: perf_event_open failed (see /proc/sys/kernel/perf_event_paranoid)");
+        return false;
+    }
+
+    group_size = 0;
+    for (int i = 0; i < PERF_EVENT_COUNT; i++) {
+        event_fds[i] = i == PERF_CYCLES ? group_fd : open_event(events[i].type, events[i].config, group_fd);
+        event_available[i] = event_fds[i] >= 0;
+        group_slot[i] = event_available[i] ? group_size++ : -1;
+    }
+
+    memset(totals, 0, sizeof(totals));
+    owner = pthread_self();
+    ioctl(group_fd, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+    ioctl(group_fd, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    perf_counters_enabled = true;
+    return true;
+#else
+    fprintf(stderr, "Error: Hardware counters need Linux perf_event\n");
+    return false;
+#endif
+}
+
+/**
+ * @brief Stops counting and closes the counters. The totals stay available for reporting.
+ */
+void perf_counters_stop() {
+#ifdef __linux__
+    if (!perf_counters_enabled) return;
+    perf_counters_enabled = false;
+
+    ioctl(group_fd, PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+    for (int i = PERF_EVENT_COUNT - 1; i >= 0; i--) {
+        if (event_fds[i] >= 0) close(event_fds[i]);
+    }
+    group_fd = -1;
+#endif
+}
+
+/**
+ * @brief Reads the counters at the start of a measured call.
+ *
+ * @param sample Pointer to the sample to fill, left invalid if the call is not measured.
+ */
+void perf_site_begin(PerfSample *sample) {
+    sample->valid = false;
+#ifdef __linux__
+    if (!perf_counters_enabled || !pthread_equal(pthread_self(), owner)) return;
+    sample->valid = read_group(sample->values);
+#endif
+}
+
+/**
+ * @brief Reads the counters at the end of a measured call and charges the difference to its site.
+ *
+ * @param site The call site.
+ * @param sample Pointer to the sample taken by perf_site_begin().
+ */
+void perf_site_end(PerfSite site, const PerfSample *sample) {
+#ifdef __linux__
+    uint64_t values[PERF_EVENT_COUNT];
+    if (!sample->valid || !read_group(values)) return;
+
+    totals[site].calls++;
+    for (int i = 0; i < PERF_EVENT_COUNT; i++) {
+        totals[site].values[i] += values[i] - sample->values[i];
+    }
+#else
+    (void) site;
+    (void) sample;
+#endif
+}
+
+// ======================= REPORTING ======================= //
+
+/**
+ * @brief Prints per-call averages of every call site.
+ *
+ * @param out Stream to write to.
+ * @param sites Totals of every call site.
+ */
+static void print_table(FILE *out, const PerfTotals sites[PERF_SITE_COUNT]) {
+    fprintf(out, "%-18s %8s %12s %12s %6s %10s %10s %10s\n", "Perf (per call)", "calls", "cycles",
+            "instructions", "IPC", "L1D miss", "LLC miss", "br miss");
+
+    for (int i = 0; i < PERF_SITE_COUNT; i++) {
+        const PerfTotals *site = &sites[i];
+        double calls = site->calls > 0 ? (double) site->calls : 1.0;
+        fprintf(out, "%-18s %8llu", site_names[i], (unsigned long long) site->calls);
+
+        for (int e = 0; e < PERF_EVENT_COUNT; e++) {
+            int width = e == PERF_CYCLES || e == PERF_INSTRUCTIONS ? 12 : 10;
+            if (e == PERF_L1D_MISSES) {
+                // IPC sits between the core and the memory events
+                if (event_available[PERF_INSTRUCTIONS] && site->values[PERF_CYCLES] > 0) {
+                    fprintf(out, " %6.2f", (double) site->values[PERF_INSTRUCTIONS] / (double) site->values[PERF_CYCLES]);
+                } else {
+                    fprintf(out, " %6s", "n/a");
+                }
+            }
+            if (event_available[e]) {
+                fprintf(out, " %*.1f", width, (double) site->values[e] / calls);
+            } else {
+                fprintf(out, " %*s", width, "n/a");
+            }
+        }
+        fputc('\n', out);
+    }
+}
+
+/**
+ * @brief Prints the counters of this run.
+ *
+ * @param out Stream to write to.
+ */
+void perf_counters_report(FILE *out) {
+    print_table(out, totals);
+}
+
+/**
+ * @brief Adds the counters of this run to a totals file shared by a batch of runs.
+ *
+ * The file is created if it does not exist yet, and the aggregated totals are printed.
+ *
+ * @param filename Path of the totals file.
+ * @return bool True if the totals were written, false otherwise.
+ */
+bool perf_counters_merge_totals(const char *filename) {
+    PerfTotals merged[PERF_SITE_COUNT];
+    memcpy(merged, totals, sizeof(merged));
+    unsigned long runs = 1;
+
+    FILE *in = fopen(filename, "r");
+    if (in) {
+        char line[512];
+        if (!fgets(line, sizeof(line), in) || strncmp(line, PERF_TOTALS_HEADER, strlen(PERF_TOTALS_HEADER)) != 0) {
+            fprintf(stderr, "Error: %s is not a perf totals file\n", filename);
+            fclose(in);
+            return false;
+        }
+        while (fgets(line, sizeof(line), in)) {
+            char name[64];
+            unsigned long long v[1 + PERF_EVENT_COUNT];
+            unsigned long previous_runs;
+            if (sscanf(line, "runs %lu", &previous_runs) == 1) {
+                runs += previous_runs;
+                continue;
+            }
+            if (sscanf(line, "%63s %llu %llu %llu %llu %llu %llu", name,
+                       &v[0], &v[1], &v[2], &v[3], &v[4], &v[5]) != 2 + PERF_EVENT_COUNT) continue;
+
+            for (int i = 0; i < PERF_SITE_COUNT; i++) {
+                if (strcmp(name, site_names[i]) != 0) continue;
+                merged[i].calls += v[0];
+                for (int e = 0; e < PERF_EVENT_COUNT; e++) merged[i].values[e] += v[1 + e];
+            }
+        }
+        fclose(in);
+    }
+
+    // Write a temporary file first so an interrupted run never loses the earlier totals
+    char temp_name[1024];
+    snprintf(temp_name, sizeof(temp_name), "%s.tmp", filename);
+    FILE *out = fopen(temp_name, "w");
+    if (!out) {
+        perror("Error: Failed to write perf totals");
+        return false;
+    }
+    fprintf(out, "%s\n# site calls cycles instructions l1d_misses llc_misses branch_misses\nruns %lu\n",
+            PERF_TOTALS_HEADER, runs);
+    for (int i = 0; i < PERF_SITE_COUNT; i++) {
+        fprintf(out, "%s %llu", site_names[i], (unsigned long long) merged[i].calls);
+        for (int e = 0; e < PERF_EVENT_COUNT; e++) fprintf(out, " %llu", (unsigned long long) merged[i].values[e]);
+        fputc('\n', out);
+    }
+    if (fclose(out) != 0 || rename(temp_name, filename) != 0) {
+        perror("Error: Failed to write perf totals");
+        remove(temp_name);
+        return false;
+    }
+
+    printf("Perf totals over %lu runs in %s:\n", runs, filename);
+    print_table(stdout, merged);
+    return true;
+}
@@ -0,0 +1,47 @@
+#ifndef PERF_COUNTERS_H
+#define PERF_COUNTERS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+// Hardware events counted around each measured call site
+typedef enum {
+    PERF_CYCLES,
+    PERF_INSTRUCTIONS,
+    PERF_L1D_MISSES,
+    PERF_LLC_MISSES,
+    PERF_BRANCH_MISSES,
+    PERF_EVENT_COUNT
+} PerfEvent;
+
+// Measured call sites
+typedef enum {
+    PERF_SITE_TICK,                 // exploration_tick() in run_exploration()
+    PERF_SITE_SIMULATION_TICK,      // exploration_tick() in exploration_step()
+    PERF_SITE_SENSORS_TICK,         // update_ultrasonic_sensors() at the start of a tick
+    PERF_SITE_SENSORS_DECISION,     // update_ultrasonic_sensors() in decide_next_move()
+    PERF_SITE_SHORTEST_PATH,        // find_shortest_path_to_mappoint_tbd() in existing_map_point_algorithm()
+    PERF_SITE_COUNT
+} PerfSite;
+
+/**
+ * @struct PerfSample
+ * @brief Counter values read at the start of a measured call.
+ */
+typedef struct PerfSample {
+    uint64_t values[PERF_EVENT_COUNT];
+    bool valid;
+} PerfSample;
+
+// True while the counters of the control loop thread are open
+extern bool perf_counters_enabled;
+
+bool perf_counters_start();
+void perf_counters_stop();
+void perf_site_begin(PerfSample *sample);
+void perf_site_end(PerfSite site, const PerfSample *sample);
+void perf_counters_report(FILE *out);
+bool perf_counters_merge_totals(const char *filename);
+
+#endif // PERF_COUNTERS_H
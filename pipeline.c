@@ -0,0 +1,337 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <time.h>
+#include <sched.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "pipeline.h"
+#include "spsc_ring.h"
+#include "exploration.h"
+#include "navigate.h"
+#include "globals.h"
+#include "track_files_PRIVATE/track_detection.h"
+#include "track_files_PRIVATE/track_navigation.h"
+#include "trace.h"
+
+// ======================= STAGED PIPELINE ======================= //
+//
+// The exploration loop split over three threads, as laid out in the README:
+//
+//   sensor stage ──SensorMessage──> decision stage ──CommandMessage──> actuation stage
+//        ^                                                                   │
+//        └─────────────────────────────PoseMessage───────────────────────────┘
+//
+// Every connection is a bounded lock-free SPSC ring of timestamped messages. The car is a
+// closed loop (the sensors must see the pose after the last move), so the actuation stage
+// hands the pose back to the sensor stage. Shared state is only touched by the stage that
+// currently holds the message, the rings order the accesses between the threads.
+
+#define PIPELINE_RING_SIZE 16
+
+/**
+ * @struct PoseMessage
+ * @brief Actuation -> sensor: the car finished moving.
+ */
+typedef struct PoseMessage {
+    unsigned long tick;
+    long long timestamp;    /**< Monotonic time the message was sent (ns) */
+    bool after_route;       /**< The car just drove a planned route */
+    bool stop;
+} PoseMessage;
+
+/**
+ * @struct SensorMessage
+ * @brief Sensor -> decision: readings taken at the car's pose.
+ */
+typedef struct SensorMessage {
+    unsigned long tick;
+    long long timestamp;
+    bool after_route;
+    bool stop;
+    Location location;
+    Direction orientation;
+    bool sensors[3];
+} SensorMessage;
+
+typedef enum {
+    COMMAND_MOVE,
+    COMMAND_ROUTE,
+    COMMAND_STOP
+} CommandKind;
+
+/**
+ * @struct CommandMessage
+ * @brief Decision -> actuation: what the car should do next.
+ */
+typedef struct CommandMessage {
+    unsigned long tick;
+    long long timestamp;
+    CommandKind kind;
+    Move move;              /**< Move to execute for COMMAND_MOVE */
+    Path *route;            /**< Route to drive for COMMAND_ROUTE, freed by the actuation stage */
+} CommandMessage;
+
+/**
+ * @struct StageStats
+ * @brief Latency and queue depth measured by one stage.
+ */
+typedef struct StageStats {
+    const char *name;
+    unsigned long messages;
+    long long total_wait_ns;        /**< Time messages spent in the input queue */
+    long long total_latency_ns;     /**< Time spent processing messages */
+    long long max_latency_ns;
+    unsigned max_depth;             /**< Deepest input queue seen */
+} StageStats;
+
+static SpscRing pose_ring, sensor_ring, command_ring;
+static StageStats sensor_stats = {.name = "sensor"};
+static StageStats decision_stats = {.name = "decision"};
+static StageStats actuation_stats = {.name = "actuation"};
+
+/**
+ * @brief Reads the monotonic clock.
+ *
+ * @return long long Time in nanoseconds.
+ */
+static long long monotonic_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long) ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+/**
+ * @brief Takes the next message from a ring, backing off while it is empty.
+ *
+ * @param ring Pointer to the input ring of the stage.
+ * @param message Pointer to copy the message to.
+ * @param stats Pointer to the stage statistics.
+ */
+static void wait_for_message(SpscRing *ring, void *message, StageStats *stats) {
+    unsigned depth = spsc_ring_depth(ring);
+    for (int attempt = 0; !spsc_ring_pop(ring, message); attempt++) {
+        if (attempt < 64) {
+            sched_yield();
+        } else {
+            struct timespec pause = {0, 100000};  // 100 us
+            nanosleep(&pause, NULL);
+        }
+        depth = spsc_ring_depth(ring);
+    }
+    if (depth > stats->max_depth) stats->max_depth = depth;
+}
+
+/**
+ * @brief Appends a message to a ring, backing off while it is full.
+ *
+ * @param ring Pointer to the output ring of the stage.
+ * @param message Pointer to the message.
+ */
+static void send_message(SpscRing *ring, const void *message) {
+    while (!spsc_ring_push(ring, message)) {
+        sched_yield();
+    }
+}
+
+/**
+ * @brief Records the statistics of one processed message.
+ *
+ * @param stats Pointer to the stage statistics.
+ * @param sent Time the message was sent.
+ * @param received Time the stage took the message.
+ */
+static void record_stage(StageStats *stats, long long sent, long long received) {
+    long long latency = monotonic_ns() - received;
+    stats->messages++;
+    stats->total_wait_ns += received - sent;
+    stats->total_latency_ns += latency;
+    if (latency > stats->max_latency_ns) stats->max_latency_ns = latency;
+}
+
+// ======================= STAGES ======================= //
+
+/**
+ * @brief Sensor stage: samples the ultrasonic sensors at every new pose.
+ *
+ * @param arg Unused.
+ * @return void* Always NULL.
+ */
+static void *sensor_stage(void *arg) {
+    (void) arg;
+    trace_name_thread("sensor stage");
+
+    while (1) {
+        PoseMessage pose;
+        wait_for_message(&pose_ring, &pose, &sensor_stats);
+        long long received = monotonic_ns();
+
+        SensorMessage reading = {.tick = pose.tick, .after_route = pose.after_route, .stop = pose.stop};
+        if (!pose.stop) {
+            if (!pose.after_route) print_grid(current_car);
+
+            update_ultrasonic_sensors();
+            reading.location = current_car.current_location;
+            reading.orientation = (Direction) current_car.current_orientation;
+            for (int i = 0; i < 3; i++) reading.sensors[i] = ultrasonic_sensors[i];
+        }
+
+        reading.timestamp = monotonic_ns();
+        send_message(&sensor_ring, &reading);
+        record_stage(&sensor_stats, pose.timestamp, received);
+
+        if (pose.stop) break;
+    }
+    return NULL;
+}
+
+/**
+ * @brief Decision stage: updates the map and chooses the next move or route.
+ *
+ * @param arg Unused.
+ * @return void* Always NULL.
+ */
+static void *decision_stage(void *arg) {
+    (void) arg;
+    trace_name_thread("decision stage");
+    bool moved = false;
+
+    while (1) {
+        SensorMessage reading;
+        wait_for_message(&sensor_ring, &reading, &decision_stats);
+        long long received = monotonic_ns();
+
+        CommandMessage command = {.tick = reading.tick, .kind = COMMAND_STOP};
+        if (!reading.stop) {
+            if (!reading.after_route) {
+                // Finish the previous tick now that the move is done
+                if (moved) {
+                    exploration_after_move();
+                    if (exploration_complete()) {
+                        command.kind = COMMAND_STOP;
+                        goto send;
+                    }
+                }
+
+                command.route = process_sensor_readings();
+                if (command.route) {
+                    command.kind = COMMAND_ROUTE;
+                    goto send;
+                }
+            }
+
+            exploration_before_move();
+            command.kind = COMMAND_MOVE;
+            command.move = choose_next_move(reading.sensors, reading.orientation);
+            moved = true;
+        }
+
+    send:
+        command.timestamp = monotonic_ns();
+        send_message(&command_ring, &command);
+        record_stage(&decision_stats, reading.timestamp, received);
+
+        if (command.kind == COMMAND_STOP) break;
+    }
+    return NULL;
+}
+
+/**
+ * @brief Actuation stage: executes moves and routes, then hands the pose back to the sensors.
+ *
+ * @param arg Unused.
+ * @return void* Always NULL.
+ */
+static void *actuation_stage(void *arg) {
+    (void) arg;
+    trace_name_thread("actuation stage");
+
+    while (1) {
+        CommandMessage command;
+        wait_for_message(&command_ring, &command, &actuation_stats);
+        long long received = monotonic_ns();
+
+        PoseMessage pose = {.tick = command.tick};
+        switch (command.kind) {
+            case COMMAND_MOVE:
+                apply_move(command.move);
+                pose.tick++;
+                break;
+            case COMMAND_ROUTE:
+                navigate_path(command.route);
+                path_free(command.route);
+                pose.after_route = true;
+                break;
+            case COMMAND_STOP:
+                pose.stop = true;
+                break;
+        }
+
+        record_stage(&actuation_stats, command.timestamp, received);
+
+        // The sensor stage already stopped when the stop came from the decision stage
+        if (pose.stop) break;
+
+        if (command.kind == COMMAND_MOVE) usleep(500000);  // Delay for realistic movement speed
+
+        pose.timestamp = monotonic_ns();
+        send_message(&pose_ring, &pose);
+    }
+    return NULL;
+}
+
+// ======================= DRIVER ======================= //
+
+/**
+ * @brief Prints the statistics of one stage.
+ *
+ * @param stats Pointer to the stage statistics.
+ */
+static void print_stage_stats(const StageStats *stats) {
+    double messages = stats->messages ? (double) stats->messages : 1.0;
+    printf("%-10s %9lu %14.1f %17.1f %17.1f %16u\n", stats->name, stats->messages,
+           stats->total_wait_ns / messages / 1000.0, stats->total_latency_ns / messages / 1000.0,
+           stats->max_latency_ns / 1000.0, stats->max_depth);
+}
+
+/**
+ * @brief Runs the exploration as a pipeline of sensor, decision and actuation threads.
+ *
+ * Blocks until exploration is complete, then prints the latency and queue depth of every stage.
+ */
+void start_pipeline_exploration() {
+    spsc_ring_init(&pose_ring, PIPELINE_RING_SIZE, sizeof(PoseMessage));
+    spsc_ring_init(&sensor_ring, PIPELINE_RING_SIZE, sizeof(SensorMessage));
+    spsc_ring_init(&command_ring, PIPELINE_RING_SIZE, sizeof(CommandMessage));
+
+    // The first pose kicks off the loop
+    PoseMessage first = {.timestamp = monotonic_ns()};
+    send_message(&pose_ring, &first);
+
+    pthread_t sensor_thread, decision_thread, actuation_thread;
+    if (pthread_create(&sensor_thread, NULL, sensor_stage, NULL) != 0 ||
+        pthread_create(&decision_thread, NULL, decision_stage, NULL) != 0 ||
+        pthread_create(&actuation_thread, NULL, actuation_stage, NULL) != 0) {
+        perror("Error: Failed to start pipeline threads");
+        exit(EXIT_FAILURE);
+    }
+
+    pthread_join(actuation_thread, NULL);
+
+    // The decision stage stopped the loop; release the sensor stage as well
+    PoseMessage stop = {.timestamp = monotonic_ns(), .stop = true};
+    send_message(&pose_ring, &stop);
+    pthread_join(sensor_thread, NULL);
+    pthread_join(decision_thread, NULL);
+
+    printf("\n===== Pipeline Stages =====\n");
+    printf("%-10s %9s %14s %17s %17s %16s\n", "Stage", "Messages", "Avg wait (us)",
+           "Avg latency (us)", "Max latency (us)", "Max queue depth");
+    print_stage_stats(&sensor_stats);
+    print_stage_stats(&decision_stats);
+    print_stage_stats(&actuation_stats);
+
+    spsc_ring_free(&pose_ring);
+    spsc_ring_free(&sensor_ring);
+    spsc_ring_free(&command_ring);
+}
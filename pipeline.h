@@ -0,0 +1,7 @@
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+// Run the exploration as a pipeline of sensor, decision and actuation threads
+void start_pipeline_exploration();
+
+#endif // PIPELINE_H
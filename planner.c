@@ -0,0 +1,583 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <limits.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <stdatomic.h>
+#include "planner.h"
+#include "spsc_ring.h"
+#include "globals.h"
+#include "pruning.h"
+#include "exploration.h"
+#include "telemetry.h"
+#include "trace.h"
+#include "static_pools.h"
+#include "min_heap.h"
+
+// ======================= ASYNCHRONOUS PLANNER ======================= //
+//
+// The planner thread keeps its own mirror of the MapPoint graph, so it never touches the
+// structures the control loop is mutating. The control loop sends a snapshot of every
+// changed MapPoint through a lock-free single-producer/single-consumer queue, including the
+// MapPoint it just left: the unexplored path the car is driving no longer counts as frontier,
+// since it will be closed on arrival.
+//
+// After applying a batch of snapshots, the planner runs one multi-source Dijkstra from all
+// unexplored MapPoints that keeps the two closest frontier MapPoints of every MapPoint. That
+// routing table already holds the route from whichever MapPoint the car arrives at next, even
+// when arriving there closes its own last unexplored path, and is handed back through a
+// single-slot mailbox. Neither side ever waits for the other: a full queue is retried on the
+// next tick, and a missing or outdated route simply lets the car keep exploring until a fresh
+// table is available.
+
+#define PLANNER_QUEUE_SIZE 1024
+#define PLANNER_MAX_PATHS 4           // A grid cell has at most four neighbours
+
+/**
+ * @struct PlannerUpdate
+ * @brief Snapshot of one MapPoint as seen by the control loop.
+ */
+typedef struct PlannerUpdate {
+    int id;
+    bool active;
+    bool frontier;          /**< MapPoint is in the "To Be Discovered" list */
+    int numberOfPaths;
+    int ends[PLANNER_MAX_PATHS];      /**< MapPoint ID each path leads to, -1 if unexplored */
+    int distances[PLANNER_MAX_PATHS];
+    unsigned generation;    /**< Map generation the snapshot was taken at */
+} PlannerUpdate;
+
+/**
+ * @struct PlannerLabel
+ * @brief Routing table entry: how to get from a MapPoint to one of the closest unexplored MapPoints.
+ */
+typedef struct PlannerLabel {
+    int distance;           /**< Distance to the unexplored MapPoint, INT_MAX if unreachable */
+    int source;             /**< MapPoint ID of the unexplored MapPoint */
+    int path_index;         /**< Index in paths of the next step, -1 if already there */
+    int next;               /**< MapPoint ID the next step leads to */
+    int next_label;         /**< Label of the next MapPoint that continues the route */
+    bool done;              /**< Distance is final */
+} PlannerLabel;
+
+/**
+ * @struct PlannerHop
+ * @brief Routing table entry for one MapPoint: its two closest unexplored MapPoints.
+ */
+typedef struct PlannerHop {
+    PlannerLabel labels[2];  /**< Sorted by distance, with different sources */
+} PlannerHop;
+
+/**
+ * @struct PlannerTable
+ * @brief Routing table published by the planner thread.
+ */
+typedef struct PlannerTable {
+    unsigned generation;    /**< Map generation the table was computed for */
+    int count;
+    PlannerHop *hops;
+} PlannerTable;
+
+#ifdef STATIC_POOLS
+/**
+ * @struct PlannerTableBlock
+ * @brief A routing table together with an entry for every MapPoint a map can hold.
+ */
+typedef struct PlannerTableBlock {
+    PlannerTable table;
+    PlannerHop hops[POOL_MAP_POINTS];
+} PlannerTableBlock;
+
+STATIC_POOL_DEFINE(planner_table_pool, "Planner tables (POOL_PLANNER_TABLES)", PlannerTableBlock, POOL_PLANNER_TABLES)
+
+static PlannerUpdate queue_slots[PLANNER_QUEUE_SIZE];
+#endif
+
+// Queue between control loop (producer) and planner (consumer)
+static SpscRing queue;
+
+// Single-slot mailbox between planner (producer) and control loop (consumer)
+static _Atomic(PlannerTable *) mailbox = NULL;
+
+static pthread_t planner_thread;
+static sem_t planner_wakeup;
+static atomic_bool running = false;
+
+// Control loop side
+static unsigned map_generation = 0;
+static PlannerTable *latest_table = NULL;
+
+// Planner side: mirror of the MapPoint graph
+#ifdef STATIC_POOLS
+static PlannerUpdate mirror[POOL_MAP_POINTS];
+static int mirror_count = 0, mirror_capacity = POOL_MAP_POINTS;
+
+// Priority queue of the table search: the sources, plus one push per label offered along a path
+static MinHeapEntry search_queue[POOL_MAP_POINTS * (2 * PLANNER_MAX_PATHS + 1)];
+static const int search_queue_capacity = POOL_MAP_POINTS * (2 * PLANNER_MAX_PATHS + 1);
+#else
+static PlannerUpdate *mirror = NULL;
+static int mirror_count = 0, mirror_capacity = 0;
+
+// Priority queue of the table search, grown with the mirror
+static MinHeapEntry *search_queue = NULL;
+static int search_queue_capacity = 0;
+#endif
+
+// ======================= PLANNER THREAD ======================= //
+
+/**
+ * @brief Stores a MapPoint snapshot in the planner's mirror of the graph.
+ *
+ * @param update Pointer to the snapshot.
+ */
+static void apply_update(const PlannerUpdate *update) {
+    if (update->id >= mirror_capacity) {
+#ifdef STATIC_POOLS
+        static_pools_fail("Planner mirror (POOL_MAP_POINTS)");
+        return;
+#else
+        int capacity = mirror_capacity ? mirror_capacity : 64;
+        while (capacity <= update->id) capacity *= 2;
+
+        PlannerUpdate *temp = realloc(mirror, capacity * sizeof(PlannerUpdate));
+        if (!temp) {
+            perror("Error: Failed to expand planner mirror");
+            exit(EXIT_FAILURE);
+        }
+        mirror = temp;
+        mirror_capacity = capacity;
+#endif
+    }
+
+    // IDs are handed out in order, but updates for a batch may arrive in any order
+    while (mirror_count <= update->id) {
+        mirror[mirror_count].id = mirror_count;
+        mirror[mirror_count].active = false;
+        mirror[mirror_count].frontier = false;
+        mirror[mirror_count].numberOfPaths = 0;
+        mirror_count++;
+    }
+    mirror[update->id] = *update;
+}
+
+/**
+ * @brief Offers a route to a MapPoint's labels, keeping the two best with different sources.
+ *
+ * @param hop Pointer to the routing table entry of the MapPoint.
+ * @param candidate The route on offer.
+ * @return bool True if one of the labels took the route.
+ */
+static bool offer_label(PlannerHop *hop, PlannerLabel candidate) {
+    PlannerLabel *first = &hop->labels[0];
+    PlannerLabel *second = &hop->labels[1];
+
+    if (candidate.source == first->source) {
+        if (first->done || candidate.distance >= first->distance) return false;
+        *first = candidate;
+        return true;
+    }
+    bool taken = true;
+    if (candidate.source == second->source) {
+        if (second->done || candidate.distance >= second->distance) return false;
+        *second = candidate;
+    } else if (!first->done && candidate.distance < first->distance) {
+        if (!second->done) *second = *first;
+        *first = candidate;
+    } else if (!second->done && candidate.distance < second->distance) {
+        *second = candidate;
+    } else {
+        taken = false;
+    }
+
+    // Keep the labels sorted
+    if (!first->done && second->distance < first->distance) {
+        PlannerLabel temp = *first;
+        *first = *second;
+        *second = temp;
+    }
+    return taken;
+}
+
+/**
+ * @brief Computes the routing table for the current mirror.
+ *
+ * Multi-source Dijkstra from all unexplored MapPoints over the active graph, settling up to
+ * two labels with different sources per MapPoint. Paths are stored in both directions with
+ * the same distance, so the search can run backwards.
+ *
+ * @param generation Map generation of the latest applied snapshot.
+ * @return PlannerTable* The new table, or NULL if the static pool is exhausted.
+ */
+static PlannerTable *compute_table(unsigned generation) {
+#ifdef STATIC_POOLS
+    PlannerTableBlock *block = static_pool_take(&planner_table_pool);
+    if (!block) return NULL;
+    PlannerTable *table = &block->table;
+    table->hops = block->hops;
+#else
+    PlannerTable *table = malloc(sizeof(PlannerTable));
+    if (!table) {
+        perror("Error: Failed to allocate planner table");
+        exit(EXIT_FAILURE);
+    }
+    table->hops = malloc(mirror_count * sizeof(PlannerHop));
+    if (!table->hops) {
+        perror("Error: Failed to allocate planner table");
+        exit(EXIT_FAILURE);
+    }
+#endif
+    table->generation = generation;
+    table->count = mirror_count;
+
+#ifndef STATIC_POOLS
+    // Every MapPoint settles at most two labels, each offered along at most PLANNER_MAX_PATHS paths
+    if (mirror_count * (2 * PLANNER_MAX_PATHS + 1) > search_queue_capacity) {
+        int capacity = mirror_capacity * (2 * PLANNER_MAX_PATHS + 1);
+        MinHeapEntry *entries = realloc(search_queue, capacity * sizeof(MinHeapEntry));
+        if (!entries) {
+            perror("Error: Failed to expand planner search queue");
+            exit(EXIT_FAILURE);
+        }
+        search_queue = entries;
+        search_queue_capacity = capacity;
+    }
+#endif
+    MinHeap queue_by_distance;
+    min_heap_init(&queue_by_distance, search_queue, search_queue_capacity);
+
+    PlannerLabel unreachable = {INT_MAX, -1, -1, -1, -1, false};
+    for (int i = 0; i < mirror_count; i++) {
+        table->hops[i].labels[0] = unreachable;
+        table->hops[i].labels[1] = unreachable;
+        if (mirror[i].frontier && mirror[i].active) {
+            table->hops[i].labels[0] = (PlannerLabel) {0, i, -1, -1, -1, false};
+            min_heap_push(&queue_by_distance, 0, i);
+        }
+    }
+
+    int distance, current;
+    while (min_heap_pop(&queue_by_distance, &distance, &current)) {
+        // The labels are sorted, so the first open one is the closest; an entry of a label that
+        // was improved or pushed out since is skipped
+        PlannerHop *hop = &table->hops[current];
+        int label = !hop->labels[0].done ? 0 : !hop->labels[1].done ? 1 : -1;
+        if (label < 0 || hop->labels[label].distance != distance) continue;
+
+        PlannerLabel *settled = &hop->labels[label];
+        settled->done = true;
+
+        // Relax every active neighbour, which reaches 'current' over its reverse path
+        const PlannerUpdate *node = &mirror[current];
+        for (int i = 0; i < node->numberOfPaths; i++) {
+            int neighbour = node->ends[i];
+            if (neighbour < 0 || neighbour == current || neighbour >= mirror_count) continue;
+            if (!mirror[neighbour].active) continue;
+
+            const PlannerUpdate *from = &mirror[neighbour];
+            for (int j = 0; j < from->numberOfPaths; j++) {
+                if (from->ends[j] == current && from->distances[j] == node->distances[i]) {
+                    PlannerLabel candidate = {settled->distance + node->distances[i], settled->source,
+                                              j, current, label, false};
+                    if (offer_label(&table->hops[neighbour], candidate)) {
+                        min_heap_push(&queue_by_distance, candidate.distance, neighbour);
+                    }
+                    break;
+                }
+            }
+        }
+    }
+
+    return table;
+}
+
+/**
+ * @brief Frees a routing table.
+ *
+ * @param table Pointer to the table, may be NULL.
+ */
+static void free_table(PlannerTable *table) {
+    if (!table) return;
+#ifdef STATIC_POOLS
+    // The table is the first member of its block
+    static_pool_give(&planner_table_pool, table);
+#else
+    free(table->hops);
+    free(table);
+#endif
+}
+
+/**
+ * @brief Main loop of the planner thread.
+ *
+ * @param arg Unused.
+ * @return void* Always NULL.
+ */
+static void *planner_main(void *arg) {
+    (void) arg;
+    trace_name_thread("planner");
+
+    while (atomic_load(&running)) {
+        sem_wait(&planner_wakeup);
+
+        // Drain all pending snapshots
+        PlannerUpdate update;
+        bool applied = false;
+        unsigned generation = 0;
+        while (spsc_ring_pop(&queue, &update)) {
+            apply_update(&update);
+            generation = update.generation;
+            applied = true;
+        }
+        if (!applied) continue;
+
+        // Publish, reclaiming a table the control loop never picked up
+        uint64_t compute_start = telemetry_enabled || trace_enabled ? telemetry_now() : 0;
+        PlannerTable *table = compute_table(generation);
+        if (!table) continue;
+        if (trace_enabled) trace_span("planner_table", compute_start, telemetry_now(), "map_points", table->count);
+        if (telemetry_enabled) {
+            telemetry_record((TelemetryEvent) {.type = TELEMETRY_PLANNER_TABLE, .decision = TELEMETRY_NO_DECISION,
+                                               .value = table->count,
+                                               .value2 = (int32_t) (telemetry_now() - compute_start)});
+        }
+        free_table(atomic_exchange(&mailbox, table));
+    }
+
+    return NULL;
+}
+
+// ======================= CONTROL LOOP SIDE ======================= //
+
+/**
+ * @brief Starts the planner thread.
+ */
+void planner_start() {
+    if (atomic_load(&running)) return;
+
+    if (sem_init(&planner_wakeup, 0, 0) != 0) {
+        perror("Error: Failed to create planner semaphore");
+        exit(EXIT_FAILURE);
+    }
+
+#ifdef STATIC_POOLS
+    spsc_ring_init_static(&queue, queue_slots, PLANNER_QUEUE_SIZE, sizeof(PlannerUpdate));
+#else
+    spsc_ring_init(&queue, PLANNER_QUEUE_SIZE, sizeof(PlannerUpdate));
+#endif
+
+    atomic_store(&running, true);
+    if (pthread_create(&planner_thread, NULL, planner_main, NULL) != 0) {
+        perror("Error: Failed to start planner thread");
+        exit(EXIT_FAILURE);
+    }
+
+    // Everything recorded so far has to reach the mirror as well
+    for (int i = 0; i < num_map_points_all; i++) {
+        mark_map_point_changed(map_points_all[i]);
+    }
+}
+
+/**
+ * @brief Stops the planner thread and releases its resources.
+ */
+void planner_stop() {
+    if (!atomic_load(&running)) return;
+
+    atomic_store(&running, false);
+    sem_post(&planner_wakeup);
+    pthread_join(planner_thread, NULL);
+    sem_destroy(&planner_wakeup);
+
+    free_table(atomic_exchange(&mailbox, NULL));
+    free_table(latest_table);
+    latest_table = NULL;
+
+#ifdef STATIC_POOLS
+    mirror_count = 0;
+#else
+    free(mirror);
+    mirror = NULL;
+    mirror_count = mirror_capacity = 0;
+    free(search_queue);
+    search_queue = NULL;
+    search_queue_capacity = 0;
+#endif
+    spsc_ring_free(&queue);
+}
+
+/**
+ * @brief Checks if the planner thread is running.
+ *
+ * @return bool True if routes come from the planner thread.
+ */
+bool planner_is_running() {
+    return atomic_load(&running);
+}
+
+/**
+ * @brief Takes a snapshot of a MapPoint for the planner.
+ *
+ * @param mp Pointer to the MapPoint.
+ * @param update Pointer to the snapshot to fill.
+ */
+static void snapshot_map_point(const MapPoint *mp, PlannerUpdate *update) {
+    // The unexplored path the car is driving right now will be closed on arrival
+    bool departed = mp == former_map_point &&
+                    (current_car.current_location.x != mp->location.x ||
+                     current_car.current_location.y != mp->location.y);
+
+    update->id = mp->id;
+    update->active = mp->active;
+    update->frontier = false;
+    update->generation = map_generation;
+
+    int count = mp->numberOfPaths < PLANNER_MAX_PATHS ? mp->numberOfPaths : PLANNER_MAX_PATHS;
+    update->numberOfPaths = count;
+    for (int i = 0; i < count; i++) {
+        update->ends[i] = fp_end(&mp->paths[i]) ? fp_end(&mp->paths[i])->id : -1;
+        update->distances[i] = mp->paths[i].distance;
+
+        bool driving = departed && mp->paths[i].direction == (Direction) current_car.current_orientation;
+        if (!fp_end(&mp->paths[i]) && !driving) update->frontier = true;
+    }
+
+    // The start is never on the "To Be Discovered" list; its ID depends on how the map was built
+    Location location = mp_location(mp);
+    if (location.x == start.x && location.y == start.y) update->frontier = false;
+}
+
+/**
+ * @brief Sends the MapPoints changed since the last call to the planner thread.
+ *
+ * MapPoints that do not fit in the queue stay marked as changed and are sent on the
+ * next call, so the control loop never waits. Without a running planner, the changes
+ * are simply dropped.
+ */
+void planner_publish_changes() {
+    if (num_map_points_changed == 0) return;
+
+    if (!atomic_load(&running)) {
+        clear_map_points_changed();
+        return;
+    }
+
+    map_generation++;
+
+    int sent = 0;
+    while (sent < num_map_points_changed) {
+        PlannerUpdate update;
+        snapshot_map_point(map_points_changed[sent], &update);
+        if (!spsc_ring_push(&queue, &update)) break;
+        map_points_changed[sent++]->changed = false;
+    }
+
+    // Keep whatever did not fit for the next tick
+    for (int i = sent; i < num_map_points_changed; i++) {
+        map_points_changed[i - sent] = map_points_changed[i];
+    }
+    num_map_points_changed -= sent;
+
+    if (sent > 0) sem_post(&planner_wakeup);
+}
+
+/**
+ * @brief Selects the label of a MapPoint that does not lead to the excluded MapPoint.
+ *
+ * @param table Pointer to the routing table.
+ * @param id MapPoint ID whose labels are inspected.
+ * @param excluded MapPoint ID the route must not end at.
+ * @return int Index of the label to follow.
+ */
+static int other_label(const PlannerTable *table, int id, int excluded) {
+    return table->hops[id].labels[0].source == excluded ? 1 : 0;
+}
+
+/**
+ * @brief Builds the route to the closest unexplored MapPoint from the latest planner result.
+ *
+ * Never blocks. The table may be a few map updates old: every hop is checked against the
+ * current map and the route must still end at an unexplored MapPoint. Routes that end at the
+ * starting MapPoint itself are skipped, since arriving there closed its last unexplored path.
+ *
+ * @param current_map_point Pointer to the MapPoint the car is at.
+ * @return Path* Pointer to the route (release with path_free()), or NULL if the planner
+ *               has no usable route yet.
+ */
+Path *planner_route_to_mappoint_tbd(MapPoint *current_map_point) {
+    PlannerTable *fresh = atomic_exchange(&mailbox, NULL);
+    if (fresh) {
+        free_table(latest_table);
+        latest_table = fresh;
+    }
+    if (!latest_table || !current_map_point) return NULL;
+
+    // A car inside a pruned branch first drives back into the active graph
+    Path *path = route_to_active_graph(current_map_point);
+    if (!path) {
+        path = path_create(current_map_point, current_map_point, 0);
+        if (!path) return NULL;
+    }
+
+    MapPoint *step = path->end;
+    if (step->id >= latest_table->count) {
+        path_free(path);
+        return NULL;
+    }
+
+    // Pick the closest unexplored MapPoint other than the one we are standing on
+    int label = other_label(latest_table, step->id, step->id);
+    int best_cost = latest_table->hops[step->id].labels[label].distance;
+
+    // The path we just arrived over is newer than the table, so also try every first step
+    FundamentalPath *first_step = NULL;
+    int first_label = 0;
+    for (int i = 0; i < step->numberOfPaths; i++) {
+        FundamentalPath *fp = &step->paths[i];
+        if (!fp_is_active_edge(fp) || fp_end(fp)->id >= latest_table->count) continue;
+
+        int k = other_label(latest_table, fp_end(fp)->id, step->id);
+        int distance = latest_table->hops[fp_end(fp)->id].labels[k].distance;
+        if (distance != INT_MAX && fp->distance + distance < best_cost) {
+            best_cost = fp->distance + distance;
+            first_step = fp;
+            first_label = k;
+        }
+    }
+
+    if (first_step) {
+        if (!path_reserve_route(path, path->routeLength + 1)) {
+            path_free(path);
+            return NULL;
+        }
+        path->route[path->routeLength++] = first_step;
+        path->totalDistance += first_step->distance;
+        step = fp_end(first_step);
+        label = first_label;
+    }
+
+    while (step->id < latest_table->count) {
+        PlannerLabel *hop = &latest_table->hops[step->id].labels[label];
+        if (hop->distance == INT_MAX || hop->path_index < 0) break;
+
+        // The hop must still exist in the current map
+        if (hop->path_index >= step->numberOfPaths) break;
+        FundamentalPath *fp = &step->paths[hop->path_index];
+        if (!fp_end(fp) || fp_end(fp)->id != hop->next || path->routeLength > num_map_points_all) break;
+
+        if (!path_reserve_route(path, path->routeLength + 1)) break;
+        path->route[path->routeLength++] = fp;
+        path->totalDistance += fp->distance;
+        step = fp_end(fp);
+        label = hop->next_label;
+    }
+    path->end = step;
+
+    // Only a route that still ends at an unexplored MapPoint is usable
+    if (path->routeLength == 0 || !mp_has_unexplored_paths(step)) {
+        path_free(path);
+        return NULL;
+    }
+
+    return path;
+}
@@ -0,0 +1,19 @@
+#ifndef PLANNER_H
+#define PLANNER_H
+
+#include <stdbool.h>
+#include "algorithm_structs_PUBLIC/MapPoint.h"
+#include "algorithm_structs_PUBLIC/Path.h"
+
+// Start and stop the asynchronous planner thread
+void planner_start();
+void planner_stop();
+bool planner_is_running();
+
+// Send the MapPoints changed since the last call to the planner thread
+void planner_publish_changes();
+
+// Route to the closest unexplored MapPoint from the latest planner result (never blocks)
+Path *planner_route_to_mappoint_tbd(MapPoint *current_map_point);
+
+#endif // PLANNER_H
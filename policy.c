@@ -0,0 +1,276 @@
+#include <stdio.h>
+#include <string.h>
+#include "policy.h"
+#include "lap.h"
+#include "lookahead.h"
+#include "fleet.h"
+
+// ======================= MOVE CHOICE ======================= //
+
+/**
+ * @brief Tries moves in a fixed order and takes the first one the sensors allow.
+ *
+ * MOVE_FORWARD, MOVE_LEFT and MOVE_RIGHT double as the index of their sensor reading.
+ *
+ * @param sensors Sensor readings (0: forward, 1: left, 2: right).
+ * @param order The moves to try, best first.
+ * @return Move The first open move, a U-turn if every direction is blocked.
+ */
+static Move first_open_move(const bool sensors[3], const Move order[3]) {
+    for (int i = 0; i < 3; i++) {
+        if (sensors[order[i]]) return order[i];
+    }
+    return MOVE_U_TURN;
+}
+
+/**
+ * @brief Checks if the path leaving a MapPoint in a direction is unexplored.
+ *
+ * @param at Pointer to the MapPoint.
+ * @param direction Direction the path leaves in.
+ * @return bool True if the MapPoint has an unexplored path in that direction.
+ */
+static bool leads_to_frontier(const MapPoint *at, Direction direction) {
+    for (int i = 0; i < at->numberOfPaths; i++) {
+        if ((Direction) at->paths[i].direction == direction) return fp_end(&at->paths[i]) == NULL;
+    }
+    return false;
+}
+
+/**
+ * @brief Takes the first open move in a fixed order, an unexplored path of the MapPoint the
+ *        car stands on before any explored one.
+ *
+ * @param sensors Sensor readings (0: forward, 1: left, 2: right).
+ * @param orientation Direction the car faces.
+ * @param at Pointer to the MapPoint the car stands on, NULL between MapPoints.
+ * @param order The moves to try, best first.
+ * @return Move The chosen move.
+ */
+static Move first_unexplored_move(const bool sensors[3], Direction orientation, const MapPoint *at,
+                                  const Move order[3]) {
+    if (at) {
+        for (int i = 0; i < 3; i++) {
+            if (sensors[order[i]] && leads_to_frontier(at, move_direction(orientation, order[i]))) return order[i];
+        }
+    }
+    return first_open_move(sensors, order);
+}
+
+/**
+ * @brief Drives forward whenever possible, otherwise turns left, then right.
+ *
+ * @param sensors Sensor readings (0: forward, 1: left, 2: right).
+ * @param orientation Unused.
+ * @param at Unused.
+ * @return Move The chosen move.
+ */
+static Move forward_first_move(const bool sensors[3], Direction orientation, const MapPoint *at) {
+    (void) orientation;
+    (void) at;
+    static const Move order[3] = {MOVE_FORWARD, MOVE_LEFT, MOVE_RIGHT};
+    return first_open_move(sensors, order);
+}
+
+/**
+ * @brief Keeps the left hand on the wall: turns left whenever possible, then forward, then right.
+ *
+ * A plain wall follower circles forever around a loop that does not touch the start, so at
+ * a MapPoint it follows the wall along the unexplored paths first.
+ *
+ * @param sensors Sensor readings (0: forward, 1: left, 2: right).
+ * @param orientation Direction the car faces.
+ * @param at Pointer to the MapPoint the car stands on, NULL between MapPoints.
+ * @return Move The chosen move.
+ */
+static Move left_hand_wall_move(const bool sensors[3], Direction orientation, const MapPoint *at) {
+    static const Move order[3] = {MOVE_LEFT, MOVE_FORWARD, MOVE_RIGHT};
+    return first_unexplored_move(sensors, orientation, at, order);
+}
+
+/**
+ * @brief Takes an unexplored path of the MapPoint the car stands on before any explored one.
+ *
+ * The frontier at the car's own MapPoint is the nearest one there is; without one the car
+ * drives forward first.
+ *
+ * @param sensors Sensor readings (0: forward, 1: left, 2: right).
+ * @param orientation Direction the car faces.
+ * @param at Pointer to the MapPoint the car stands on, NULL between MapPoints.
+ * @return Move The chosen move.
+ */
+static Move nearest_frontier_move(const bool sensors[3], Direction orientation, const MapPoint *at) {
+    static const Move order[3] = {MOVE_FORWARD, MOVE_LEFT, MOVE_RIGHT};
+    return first_unexplored_move(sensors, orientation, at, order);
+}
+
+/**
+ * @brief Plays out every unexplored path of the MapPoint the car stands on and takes the
+ *        cheapest one (see lookahead.h); drives forward first otherwise.
+ *
+ * @param sensors Sensor readings (0: forward, 1: left, 2: right).
+ * @param orientation Direction the car faces.
+ * @param at Pointer to the MapPoint the car stands on, NULL between MapPoints.
+ * @return Move The chosen move.
+ */
+static Move lookahead_move(const bool sensors[3], Direction orientation, const MapPoint *at) {
+    static const Move order[3] = {MOVE_FORWARD, MOVE_LEFT, MOVE_RIGHT};
+    Move moves[3];
+    Direction candidates[3];
+    int count = 0;
+    if (at) {
+        for (int i = 0; i < 3; i++) {
+            Direction direction = move_direction(orientation, order[i]);
+            if (sensors[order[i]] && leads_to_frontier(at, direction)) {
+                moves[count] = order[i];
+                candidates[count++] = direction;
+            }
+        }
+    }
+    if (count < 2) return first_unexplored_move(sensors, orientation, at, order);
+
+    int best = lookahead_best_direction(at, candidates, count);
+    return best >= 0 ? moves[best] : moves[0];
+}
+
+// ======================= FRONTIER CHOICE ======================= //
+
+/**
+ * @brief Ranks an unexplored MapPoint by the shortest lap that could pass through it: the
+ *        drive there plus the Manhattan distance back to the start.
+ *
+ * Exploring the frontiers with the lowest bound first raises the bound of
+ * lap_lower_bound_unexplored() soonest, so the lap is proven with less driving.
+ *
+ * @param frontier Pointer to the unexplored MapPoint.
+ * @param distance Driving distance from the car to the MapPoint.
+ * @return int The rank, lower is better.
+ */
+static int lap_frontier_rank(const MapPoint *frontier, int distance) {
+    return distance + calculate_distance(mp_location(frontier), start);
+}
+
+/**
+ * @brief Plans the route to the unexplored MapPoint with the lowest lap_frontier_rank().
+ *
+ * @param current Pointer to the MapPoint the car is at.
+ * @return Path* Route to the unexplored MapPoint (release with path_free()), NULL if there is none.
+ */
+static Path *route_to_lap_frontier(MapPoint *current) {
+    return route_to_ranked_frontier(current, lap_frontier_rank);
+}
+
+// ======================= TERMINATION ======================= //
+
+/**
+ * @brief Checks if the map in the globals holds a closed lap through the start.
+ *
+ * @return bool True if a lap is known.
+ */
+static bool lap_is_known() {
+    Path *lap = find_shortest_lap();
+    path_free(lap);
+    return lap != NULL;
+}
+
+/**
+ * @brief Stops once the map is complete, the car is back at the start, or no unexplored
+ *        path can lead to a shorter lap than the best known one.
+ *
+ * A single car knows a lap once it is back at the start. The cars of a fleet leave the start
+ * on different paths and close the lap where their paths meet, rarely at the start, so for
+ * them a known lap counts as being back.
+ *
+ * @return bool True if exploration should stop.
+ */
+static bool stop_at_start() {
+    return exploration_map_complete() || checkValidTrackCompletion() ||
+           (map_changed && fleet_active && lap_is_known()) ||
+           (map_changed && lap_bound_exploration_complete());
+}
+
+/**
+ * @brief Drives past the start while frontiers remain: stops once the map is complete or no
+ *        unexplored path can lead to a shorter lap than the best known one.
+ *
+ * @return bool True if exploration should stop.
+ */
+static bool stop_when_lap_is_proven() {
+    return exploration_map_complete() || (map_changed && lap_bound_exploration_complete());
+}
+
+// ======================= POLICY TABLE ======================= //
+
+static const ExplorationPolicy forward_first = {
+    .name = "forward-first",
+    .description = "forward, then left, then right; closest unexplored MapPoint; stop back at the start",
+    .choose_move = forward_first_move,
+    .route_to_frontier = route_to_closest_frontier,
+    .is_complete = stop_at_start,
+};
+
+static const ExplorationPolicy left_hand_wall = {
+    .name = "left-hand-wall",
+    .description = "left, then forward, then right, unexplored paths first; closest unexplored MapPoint; stop back at the start",
+    .choose_move = left_hand_wall_move,
+    .route_to_frontier = route_to_closest_frontier,
+    .is_complete = stop_at_start,
+};
+
+static const ExplorationPolicy nearest_frontier = {
+    .name = "nearest-frontier",
+    .description = "forward, then left, then right, unexplored paths first; closest unexplored MapPoint; stop once the lap is proven",
+    .choose_move = nearest_frontier_move,
+    .route_to_frontier = route_to_closest_frontier,
+    .is_complete = stop_when_lap_is_proven,
+};
+
+static const ExplorationPolicy lap_frontier = {
+    .name = "lap-frontier",
+    .description = "forward, then left, then right, unexplored paths first; unexplored MapPoint closest to the "
+                   "car plus its way back to the start; stop once the lap is proven",
+    .choose_move = nearest_frontier_move,
+    .route_to_frontier = route_to_lap_frontier,
+    .is_complete = stop_when_lap_is_proven,
+};
+
+static const ExplorationPolicy lookahead = {
+    .name = "lookahead",
+    .description = "plays out every unexplored path here on a fork of the map, knowing the track; "
+                   "closest unexplored MapPoint; stop once the lap is proven",
+    .oracle = true,
+    .choose_move = lookahead_move,
+    .route_to_frontier = route_to_closest_frontier,
+    .is_complete = stop_when_lap_is_proven,
+};
+
+const ExplorationPolicy *const exploration_policies[NUM_EXPLORATION_POLICIES] = {
+    &forward_first, &left_hand_wall, &nearest_frontier, &lap_frontier, &lookahead
+};
+
+const ExplorationPolicy *exploration_policy = &forward_first;
+
+/**
+ * @brief Looks up a shipped policy by name.
+ *
+ * @param name Name of the policy.
+ * @return const ExplorationPolicy* The policy, or NULL if there is none by that name.
+ */
+const ExplorationPolicy *policy_find(const char *name) {
+    for (int i = 0; i < NUM_EXPLORATION_POLICIES; i++) {
+        if (strcmp(exploration_policies[i]->name, name) == 0) return exploration_policies[i];
+    }
+    return NULL;
+}
+
+/**
+ * @brief Prints the name and description of every shipped policy, marking the oracles.
+ *
+ * @param out Stream to write to.
+ */
+void policy_print_list(FILE *out) {
+    for (int i = 0; i < NUM_EXPLORATION_POLICIES; i++) {
+        fprintf(out, "  %-18s %s%s\n", exploration_policies[i]->name, exploration_policies[i]->oracle ? "[oracle] " : "",
+                exploration_policies[i]->description);
+    }
+}
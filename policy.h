@@ -0,0 +1,51 @@
+#ifndef POLICY_H
+#define POLICY_H
+
+#include <stdio.h>
+#include <stdbool.h>
+#include "globals.h"
+#include "exploration.h"
+#include "algorithm_structs_PUBLIC/Path.h"
+
+// ======================= EXPLORATION POLICIES ======================= //
+//
+// How the car explores a track: which way it turns after reading its sensors, where it
+// drives once every path at a MapPoint is explored, and when it stops. The exploration code
+// only calls the current policy; every Simulation carries its own (see simulation.h).
+
+/**
+ * @struct ExplorationPolicy
+ * @brief The decisions of an exploration strategy.
+ */
+typedef struct ExplorationPolicy {
+    const char *name;           /**< Without whitespace, used by --policy and in score totals */
+    const char *description;
+    bool oracle;                /**< Reads the track instead of exploring it; a reference, never ranked */
+
+    /**
+     * Chooses the next move from the sensor readings (0: forward, 1: left, 2: right) of a car
+     * facing orientation. at is the MapPoint the car stands on, or NULL between MapPoints.
+     */
+    Move (*choose_move)(const bool sensors[3], Direction orientation, const MapPoint *at);
+
+    /**
+     * Plans the route from a MapPoint whose paths are all explored to the next unexplored
+     * MapPoint (release with path_free()); NULL lets the car keep exploring with choose_move.
+     */
+    Path *(*route_to_frontier)(MapPoint *current);
+
+    /** Checks after every move whether the exploration is finished. */
+    bool (*is_complete)();
+} ExplorationPolicy;
+
+// Policy used by the exploration code, forward-first unless --policy selects another
+extern const ExplorationPolicy *exploration_policy;
+
+// Every shipped policy, the default first
+#define NUM_EXPLORATION_POLICIES 5
+extern const ExplorationPolicy *const exploration_policies[NUM_EXPLORATION_POLICIES];
+
+const ExplorationPolicy *policy_find(const char *name);
+void policy_print_list(FILE *out);
+
+#endif // POLICY_H
@@ -0,0 +1,184 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "pruning.h"
+#include "globals.h"
+#include "alloc_tracker.h"
+#include "static_pools.h"
+
+// ======================= DEAD-END PRUNING ======================= //
+//
+// The planner only needs the part of the map that can lie on a shortest route to an
+// unexplored MapPoint or on a lap. A fully explored MapPoint with at most one edge into
+// the rest of the active graph can never be on such a route (it would have to be entered
+// and left through the same edge), so it is peeled off. Peeling a MapPoint lowers the
+// degree of its neighbour, which may in turn become a leaf: what remains is the 2-core of
+// the explored graph plus the frontier and the start.
+//
+// Every peeled MapPoint remembers the edge that led back into the active graph at the
+// time it was peeled (prune_exit), so a car standing inside a pruned branch can still
+// find its way out.
+
+#ifdef STATIC_POOLS
+// Work stack of prune_dead_ends(), one entry per MapPoint a map can hold
+static MapPoint *stack[POOL_MAP_POINTS];
+#else
+// Work stack of prune_dead_ends(), kept between calls
+static MapPoint **stack = NULL;
+static int stack_capacity = 0;
+#endif
+
+/**
+ * @brief Grows the pruning stack to hold the given number of MapPoints.
+ *
+ * @param count Number of MapPoints.
+ */
+static void reserve_pruning_stack(int count) {
+#ifdef STATIC_POOLS
+    // A cascade pushes at most one MapPoint per MapPoint it prunes
+    (void) count;
+#else
+    if (count <= stack_capacity) return;
+
+    int capacity = stack_capacity > 0 ? stack_capacity : 8;
+    while (capacity < count) capacity *= 2;
+    MapPoint **temp = tracked_realloc(ALLOC_SEARCH, stack, capacity * sizeof(MapPoint *));
+    if (!temp) {
+        perror("Error: Failed to expand pruning stack");
+        exit(EXIT_FAILURE);
+    }
+    stack = temp;
+    stack_capacity = capacity;
+#endif
+}
+
+/**
+ * @brief Preallocates the pruning stack.
+ *
+ * @param map_points Number of MapPoints a single pruning cascade can reach.
+ */
+void pruning_reserve(int map_points) {
+    reserve_pruning_stack(map_points);
+}
+
+/**
+ * @brief Checks if a FundamentalPath leads to another MapPoint of the active graph.
+ *
+ * @param fp Pointer to the FundamentalPath.
+ * @return bool True if the path is explored, not a self-loop and ends at an active MapPoint.
+ */
+bool fp_is_active_edge(const FundamentalPath *fp) {
+    MapPoint *end = fp_end(fp);
+    return end != NULL && end != fp_start(fp) && end->active;
+}
+
+/**
+ * @brief Counts the ways out of a MapPoint that can still lead somewhere.
+ *
+ * Unexplored paths count as well, since they may connect to anything.
+ *
+ * @param mp Pointer to the MapPoint.
+ * @return int Number of unexplored paths plus edges into the active graph.
+ */
+static int active_degree(const MapPoint *mp) {
+    int degree = 0;
+    for (int i = 0; i < mp->numberOfPaths; i++) {
+        if (fp_end(&mp->paths[i]) == NULL || fp_is_active_edge(&mp->paths[i])) {
+            degree++;
+        }
+    }
+    return degree;
+}
+
+/**
+ * @brief Checks if a MapPoint is a dead-end leaf that can be removed from the active graph.
+ *
+ * @param mp Pointer to the MapPoint.
+ * @return bool True if the MapPoint can be peeled off.
+ */
+static bool is_dead_end_leaf(const MapPoint *mp) {
+    if (!mp->active) return false;
+
+    // Unexplored paths may still lead to new parts of the track
+    if (mp_has_unexplored_paths((MapPoint *) mp)) return false;
+
+    // The start has to stay, every lap runs through it
+    if (mp->location.x == start.x && mp->location.y == start.y) return false;
+
+    return active_degree(mp) <= 1;
+}
+
+/**
+ * @brief Peels dead-end leaves off the active graph, starting from the given MapPoint.
+ *
+ * Should be called whenever a FundamentalPath of the MapPoint was closed. Pruning
+ * cascades to neighbours that become leaves in turn.
+ *
+ * @param mp Pointer to the MapPoint whose edges changed.
+ */
+void prune_dead_ends(MapPoint *mp) {
+    if (!mp) return;
+
+    // A MapPoint is pushed at most once per neighbour edge, so the stack stays small
+    int count = 0;
+    reserve_pruning_stack(8);
+    stack[count++] = mp;
+
+    while (count > 0) {
+        MapPoint *current = stack[--count];
+        if (!is_dead_end_leaf(current)) continue;
+
+        // Remember the way back before the neighbour loses its edge to us
+        current->prune_exit = -1;
+        for (int i = 0; i < current->numberOfPaths; i++) {
+            if (fp_is_active_edge(&current->paths[i])) {
+                current->prune_exit = i;
+                break;
+            }
+        }
+        current->active = false;
+        mark_map_point_changed(current);
+
+        // The neighbour just lost an edge and may have become a leaf itself
+        if (current->prune_exit >= 0) {
+            reserve_pruning_stack(count + 1);
+            stack[count++] = fp_end(&current->paths[current->prune_exit]);
+        }
+    }
+}
+
+/**
+ * @brief Builds the route that leads from a pruned MapPoint back into the active graph.
+ *
+ * Follows the remembered exits until an active MapPoint is reached. Exits point to a
+ * MapPoint that was pruned later (or not at all), but a map misread by noisy sensors may
+ * relink a pruned edge afterwards, so a walk longer than the map is taken as a circle.
+ *
+ * @param mp Pointer to the pruned MapPoint.
+ * @return Path* Route into the active graph (release with path_free()), or NULL if mp is
+ *               active or its branch has no way out.
+ */
+Path *route_to_active_graph(MapPoint *mp) {
+    if (!mp || mp->active) return NULL;
+
+    // Count the steps first
+    int steps = 0;
+    MapPoint *step = mp;
+    while (!step->active) {
+        if (step->prune_exit < 0 || steps >= num_map_points_all) return NULL;
+        step = fp_end(&step->paths[step->prune_exit]);
+        steps++;
+    }
+
+    Path *path = path_create(mp, step, steps);
+    if (!path) return NULL;
+
+    step = mp;
+    for (int i = 0; i < steps; i++) {
+        FundamentalPath *exit_path = &step->paths[step->prune_exit];
+        path->route[path->routeLength++] = exit_path;
+        path->totalDistance += exit_path->distance;
+        step = fp_end(exit_path);
+    }
+
+    return path;
+}
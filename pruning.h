@@ -0,0 +1,20 @@
+#ifndef PRUNING_H
+#define PRUNING_H
+
+#include <stdbool.h>
+#include "algorithm_structs_PUBLIC/MapPoint.h"
+#include "algorithm_structs_PUBLIC/Path.h"
+
+// Peel dead-end leaves off the active graph, starting from the given MapPoint
+void prune_dead_ends(MapPoint *mp);
+
+// Preallocate the work stack of prune_dead_ends()
+void pruning_reserve(int map_points);
+
+// Check if a FundamentalPath leads to another MapPoint of the active graph
+bool fp_is_active_edge(const FundamentalPath *fp);
+
+// Build the route that leads from a pruned MapPoint back into the active graph
+Path *route_to_active_graph(MapPoint *mp);
+
+#endif // PRUNING_H
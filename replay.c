@@ -0,0 +1,406 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "replay.h"
+#include "checkpoint.h"
+#include "map_snapshot.h"
+#include "globals.h"
+#include "track_files_PRIVATE/track_navigation.h"
+
+// ======================= RECORDING FORMAT ======================= //
+//
+// A recording is the track followed by one record per tick and a keyframe every
+// keyframe_interval ticks. A keyframe is an in-memory checkpoint (checkpoint.h) of the state
+// before that tick, so a replay restores the closest keyframe and only re-executes the ticks
+// after it. A keyframe index at the end of the file makes finding it O(log n):
+//
+//   RecordingHeader | grid_size x grid_size cells | (TickRecord | KeyframeRecord + checkpoint)*
+//   | KeyframeEntry[keyframe_count] | RecordingTrailer
+//
+// A recording that was never closed has no index; the replay then scans the records.
+
+#define RECORD_TICK     1
+#define RECORD_KEYFRAME 2
+
+/**
+ * @struct RecordingHeader
+ * @brief Identifies the format and the recorded track.
+ */
+typedef struct RecordingHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t grid_hash;
+    uint32_t grid_size;
+    uint32_t keyframe_interval;
+} RecordingHeader;
+
+/**
+ * @struct TickRecord
+ * @brief Sensor inputs and decision of one tick, with the pose after it.
+ */
+typedef struct TickRecord {
+    uint8_t kind;           /**< RECORD_TICK */
+    uint8_t sensors;        /**< Bit 0: forward, bit 1: left, bit 2: right */
+    uint8_t move;           /**< Move executed, 0xFF if none */
+    uint8_t status;         /**< ExplorationStatus of the tick */
+    uint8_t orientation;
+    uint8_t reserved;
+    int16_t x, y;
+} TickRecord;
+
+/**
+ * @struct KeyframeRecord
+ * @brief Precedes the checkpoint of the state before tick + 1.
+ */
+typedef struct KeyframeRecord {
+    uint8_t kind;           /**< RECORD_KEYFRAME */
+    uint8_t reserved[3];
+    uint32_t size;          /**< Size of the checkpoint that follows */
+    uint64_t tick;
+} KeyframeRecord;
+
+/**
+ * @struct KeyframeEntry
+ * @brief Keyframe index entry.
+ */
+typedef struct KeyframeEntry {
+    uint64_t tick;
+    uint64_t offset;        /**< File offset of the KeyframeRecord */
+} KeyframeEntry;
+
+/**
+ * @struct RecordingTrailer
+ * @brief Locates the keyframe index of a closed recording.
+ */
+typedef struct RecordingTrailer {
+    uint64_t index_offset;
+    uint32_t keyframe_count;
+    uint32_t magic;
+} RecordingTrailer;
+
+// ======================= RECORDING ======================= //
+
+static FILE *recording_file = NULL;
+static unsigned long recording_interval = 0;
+static KeyframeEntry *keyframes = NULL;
+static uint32_t keyframe_count = 0, keyframe_capacity = 0;
+
+/**
+ * @brief Packs the ultrasonic sensor readings into bits.
+ *
+ * @return uint8_t Bit 0: forward, bit 1: left, bit 2: right.
+ */
+static uint8_t sensor_bits() {
+    return (uint8_t) (ultrasonic_sensors[0] | ultrasonic_sensors[1] << 1 | ultrasonic_sensors[2] << 2);
+}
+
+/**
+ * @brief Starts recording the exploration.
+ *
+ * @param filename Path of the recording.
+ * @param keyframe_interval Number of ticks between keyframes.
+ * @return bool True if recording, false if the file could not be created.
+ */
+bool recording_start(const char *filename, unsigned long keyframe_interval) {
+    if (recording_file || !filename || keyframe_interval == 0) return false;
+    if (track_width() != track_height() || track_width() > INT16_MAX) {
+        fprintf(stderr, "Only square tracks of up to %d cells per side can be recorded\n", INT16_MAX);
+        return false;
+    }
+
+    recording_file = fopen(filename, "wb");
+    if (!recording_file) {
+        perror("Error: Failed to create recording");
+        return false;
+    }
+
+    RecordingHeader header = {RECORDING_MAGIC, RECORDING_VERSION, track_grid_hash(), (uint32_t) track_width(),
+                              (uint32_t) keyframe_interval};
+    fwrite(&header, sizeof(header), 1, recording_file);
+    for (int i = 0; i < track_height(); i++) {
+        for (int j = 0; j < track_width(); j++) fputc(track_cell(j, i), recording_file);
+    }
+
+    recording_interval = keyframe_interval;
+    keyframe_count = 0;
+    return true;
+}
+
+/**
+ * @brief Writes a keyframe of the state before the next tick when one is due.
+ *
+ * @param state Pointer to the exploration state.
+ */
+void recording_before_tick(const ExplorationState *state) {
+    if (!recording_file || state->ticks % recording_interval != 0) return;
+
+    if (keyframe_count == keyframe_capacity) {
+        keyframe_capacity = keyframe_capacity ? keyframe_capacity * 2 : 64;
+        KeyframeEntry *temp = realloc(keyframes, keyframe_capacity * sizeof(KeyframeEntry));
+        if (!temp) {
+            perror("Error: Failed to grow keyframe index");
+            exit(EXIT_FAILURE);
+        }
+        keyframes = temp;
+    }
+
+    size_t size;
+    unsigned char *checkpoint = checkpoint_serialize(state, &size);
+    KeyframeRecord record = {RECORD_KEYFRAME, {0, 0, 0}, (uint32_t) size, state->ticks};
+
+    keyframes[keyframe_count++] = (KeyframeEntry) {state->ticks, (uint64_t) ftell(recording_file)};
+    fwrite(&record, sizeof(record), 1, recording_file);
+    fwrite(checkpoint, 1, size, recording_file);
+    free(checkpoint);
+}
+
+/**
+ * @brief Records the sensor inputs, decision and resulting pose of a tick.
+ *
+ * @param state Pointer to the exploration state after the tick.
+ * @param status Status of the tick.
+ */
+void recording_after_tick(const ExplorationState *state, ExplorationStatus status) {
+    if (!recording_file) return;
+
+    TickRecord record = {RECORD_TICK, sensor_bits(), state->last_move < 0 ? 0xFF : (uint8_t) state->last_move,
+                         (uint8_t) status, (uint8_t) current_car.current_orientation, 0,
+                         (int16_t) current_car.current_location.x, (int16_t) current_car.current_location.y};
+    fwrite(&record, sizeof(record), 1, recording_file);
+}
+
+/**
+ * @brief Writes the keyframe index and closes the recording.
+ */
+void recording_stop() {
+    if (!recording_file) return;
+
+    RecordingTrailer trailer = {(uint64_t) ftell(recording_file), keyframe_count, RECORDING_MAGIC};
+    fwrite(keyframes, sizeof(KeyframeEntry), keyframe_count, recording_file);
+    fwrite(&trailer, sizeof(trailer), 1, recording_file);
+    if (fclose(recording_file) != 0) perror("Error: Failed to write recording");
+
+    recording_file = NULL;
+    free(keyframes);
+    keyframes = NULL;
+    keyframe_count = keyframe_capacity = 0;
+}
+
+// ======================= REPLAY ======================= //
+
+/**
+ * @brief Finds the last keyframe at or before a tick using the index of a closed recording.
+ *
+ * @param data Start of the recording.
+ * @param size Size of the recording in bytes.
+ * @param tick The tick to seek to.
+ * @param offset Pointer to store the file offset of the keyframe in.
+ * @return int 1 if found, 0 if no keyframe precedes the tick, -1 if there is no valid index.
+ */
+static int find_keyframe_indexed(const unsigned char *data, size_t size, unsigned long tick, size_t *offset) {
+    if (size < sizeof(RecordingTrailer)) return -1;
+
+    RecordingTrailer trailer;
+    memcpy(&trailer, data + size - sizeof(trailer), sizeof(trailer));
+    if (trailer.magic != RECORDING_MAGIC || trailer.index_offset > size - sizeof(trailer) ||
+        (size - sizeof(trailer) - trailer.index_offset) != (uint64_t) trailer.keyframe_count * sizeof(KeyframeEntry)) {
+        return -1;
+    }
+
+    // Binary search for the last keyframe with keyframe.tick <= tick
+    const unsigned char *index = data + trailer.index_offset;
+    uint32_t low = 0, high = trailer.keyframe_count;
+    while (low < high) {
+        uint32_t middle = low + (high - low) / 2;
+        KeyframeEntry entry;
+        memcpy(&entry, index + middle * sizeof(KeyframeEntry), sizeof(entry));
+        if (entry.tick <= tick) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    if (low == 0) return 0;
+
+    KeyframeEntry entry;
+    memcpy(&entry, index + (low - 1) * sizeof(KeyframeEntry), sizeof(entry));
+    if (entry.offset >= size) return -1;
+    *offset = (size_t) entry.offset;
+    return 1;
+}
+
+/**
+ * @brief Finds the last keyframe at or before a tick by scanning the records.
+ *
+ * @param data Start of the recording.
+ * @param size Size of the recording in bytes.
+ * @param first Offset of the first record.
+ * @param tick The tick to seek to.
+ * @param offset Pointer to store the file offset of the keyframe in.
+ * @return bool True if found, false otherwise.
+ */
+static bool find_keyframe_scan(const unsigned char *data, size_t size, size_t first, unsigned long tick,
+                               size_t *offset) {
+    bool found = false;
+    size_t position = first;
+    while (position < size) {
+        if (data[position] == RECORD_TICK && size - position >= sizeof(TickRecord)) {
+            position += sizeof(TickRecord);
+        } else if (data[position] == RECORD_KEYFRAME && size - position >= sizeof(KeyframeRecord)) {
+            KeyframeRecord record;
+            memcpy(&record, data + position, sizeof(record));
+            if (record.tick > tick) break;
+            *offset = position;
+            found = true;
+            position += sizeof(record) + record.size;
+        } else {
+            break;
+        }
+    }
+    return found;
+}
+
+/**
+ * @brief Compares a re-executed tick with its record.
+ *
+ * @param record Pointer to the recorded tick.
+ * @param state Pointer to the exploration state after the re-executed tick.
+ * @param status Status of the re-executed tick.
+ * @return bool True if the tick matches the recording.
+ */
+static bool tick_matches(const TickRecord *record, const ExplorationState *state, ExplorationStatus status) {
+    return record->sensors == sensor_bits() &&
+           record->move == (state->last_move < 0 ? 0xFF : (uint8_t) state->last_move) &&
+           record->status == (uint8_t) status &&
+           record->orientation == (uint8_t) current_car.current_orientation &&
+           record->x == current_car.current_location.x && record->y == current_car.current_location.y;
+}
+
+/**
+ * @brief Seeks to a tick of a recording and re-executes the rest of the run.
+ *
+ * The closest keyframe at or before the tick is restored, so only the ticks after it are
+ * re-executed. The grid is drawn at the seek tick, and after every tick when rendering.
+ * Every re-executed tick is checked against the recording.
+ *
+ * @param filename Path of the recording.
+ * @param seek_tick Tick to start the replay from.
+ * @param render True to draw the grid after every replayed tick.
+ * @return bool True if the replay matched the recording, false otherwise.
+ */
+bool replay_run(const char *filename, unsigned long seek_tick, bool render) {
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0) {
+        perror("Error: Failed to open recording");
+        return false;
+    }
+    struct stat info;
+    size_t cells = (size_t) track_width() * track_height();
+    if (fstat(fd, &info) != 0 || info.st_size < (off_t) (sizeof(RecordingHeader) + cells)) {
+        close(fd);
+        fprintf(stderr, "Not a recording: %s\n", filename);
+        return false;
+    }
+    size_t size = (size_t) info.st_size;
+    const unsigned char *data = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        perror("Error: Failed to map recording");
+        return false;
+    }
+
+    RecordingHeader header;
+    memcpy(&header, data, sizeof(header));
+    if (header.magic != RECORDING_MAGIC || header.version != RECORDING_VERSION || header.grid_size != (uint32_t) track_width() || track_width() != track_height()) {
+        fprintf(stderr, "Not a version %u recording of a %dx%d track: %s\n", RECORDING_VERSION, track_width(),
+                track_height(), filename);
+        munmap((void *) data, size);
+        return false;
+    }
+
+    // Replay on the recorded track
+    for (size_t i = 0; i < cells; i++) {
+        track_set_cell((int) (i % (size_t) track_width()), (int) (i / (size_t) track_width()),
+                       (char) data[sizeof(header) + i]);
+    }
+    size_t first = sizeof(header) + cells;
+
+    size_t position;
+    int indexed = find_keyframe_indexed(data, size, seek_tick, &position);
+    bool found = indexed == 1 || (indexed == -1 && find_keyframe_scan(data, size, first, seek_tick, &position));
+    if (!found) {
+        fprintf(stderr, "No keyframe at or before tick %lu\n", seek_tick);
+        munmap((void *) data, size);
+        return false;
+    }
+
+    KeyframeRecord keyframe;
+    memcpy(&keyframe, data + position, sizeof(keyframe));
+    position += sizeof(keyframe);
+
+    ExplorationState state;
+    if (keyframe.size > size - position || !checkpoint_restore(data + position, keyframe.size, &state)) {
+        fprintf(stderr, "Corrupt keyframe at tick %llu\n", (unsigned long long) keyframe.tick);
+        munmap((void *) data, size);
+        return false;
+    }
+
+    // The restored state must serialize to the keyframe it came from, noise streams included
+    size_t round_trip_size;
+    unsigned char *round_trip = checkpoint_serialize(&state, &round_trip_size);
+    bool same = round_trip_size == keyframe.size && memcmp(round_trip, data + position, round_trip_size) == 0;
+    free(round_trip);
+    if (!same) {
+        fprintf(stderr, "Keyframe at tick %llu does not round-trip\n", (unsigned long long) keyframe.tick);
+        exploration_state_free(&state);
+        munmap((void *) data, size);
+        return false;
+    }
+    position += keyframe.size;
+    unsigned long first_tick = state.ticks;
+
+    if (state.ticks == seek_tick) print_grid();
+
+    bool matches = true;
+    bool done = false;
+    while (position < size && !done) {
+        if (data[position] == RECORD_KEYFRAME && size - position >= sizeof(KeyframeRecord)) {
+            KeyframeRecord skipped;
+            memcpy(&skipped, data + position, sizeof(skipped));
+            position += sizeof(skipped) + skipped.size;
+            continue;
+        }
+        if (data[position] != RECORD_TICK || size - position < sizeof(TickRecord)) break;
+
+        TickRecord record;
+        memcpy(&record, data + position, sizeof(record));
+        position += sizeof(record);
+
+        ExplorationStatus status = exploration_tick(&state);
+        if (!tick_matches(&record, &state, status)) {
+            fprintf(stderr, "Replay diverged from the recording at tick %lu\n", state.ticks);
+            matches = false;
+            break;
+        }
+        done = status == EXPLORATION_DONE;
+
+        if (state.ticks == seek_tick || (render && state.ticks > seek_tick)) print_grid();
+    }
+
+    if (matches && state.ticks < seek_tick) {
+        fprintf(stderr, "The recording ends at tick %lu, before tick %lu\n", state.ticks, seek_tick);
+        matches = false;
+    } else if (matches) {
+        printf("Replayed ticks %lu to %lu from the keyframe at tick %lu, matching the recording\n",
+               seek_tick < first_tick ? first_tick : seek_tick, state.ticks, first_tick);
+    }
+
+    exploration_state_free(&state);
+    munmap((void *) data, size);
+    return matches;
+}
@@ -0,0 +1,21 @@
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include <stdbool.h>
+#include "exploration.h"
+
+#define RECORDING_MAGIC   0x4C505254u   // "TRPL" in little-endian
+#define RECORDING_VERSION 4u
+
+// Record the sensor inputs and decisions of every tick, with a keyframe every interval ticks
+bool recording_start(const char *filename, unsigned long keyframe_interval);
+void recording_stop();
+
+// Hooks of the exploration loop
+void recording_before_tick(const ExplorationState *state);
+void recording_after_tick(const ExplorationState *state, ExplorationStatus status);
+
+// Seek to a tick of a recording and re-execute the rest of the run, checking every tick
+bool replay_run(const char *filename, unsigned long seek_tick, bool render);
+
+#endif // REPLAY_H
@@ -0,0 +1,325 @@
+#include <stdlib.h>
+#include <string.h>
+#include "scoreboard.h"
+#include "lap.h"
+#include "algorithm_structs_PUBLIC/MapPoint.h"
+#include "track_files_PRIVATE/track_generation.h"
+
+// ======================= DRIVEN CELLS ======================= //
+
+/**
+ * @brief Starts scoring an exploration of the current track from the car's position.
+ *
+ * @param scoreboard Pointer to the scoreboard, released with scoreboard_free().
+ */
+void scoreboard_init(Scoreboard *scoreboard) {
+    size_t cells = (size_t) track_width() * track_height();
+    scoreboard->visited = calloc((cells + 63) / 64, sizeof(uint64_t));
+    if (!scoreboard->visited) {
+        perror("Error: Failed to allocate scoreboard");
+        exit(EXIT_FAILURE);
+    }
+    scoreboard->width = track_width();
+    scoreboard->last = current_car.current_location;
+    scoreboard->cells_driven = 0;
+    scoreboard->new_cells = 0;
+    scoreboard->replans = 0;
+
+    size_t cell = (size_t) scoreboard->last.y * scoreboard->width + scoreboard->last.x;
+    scoreboard->visited[cell / 64] |= 1ULL << (cell % 64);
+}
+
+/**
+ * @brief Frees a scoreboard.
+ *
+ * @param scoreboard Pointer to the scoreboard.
+ */
+void scoreboard_free(Scoreboard *scoreboard) {
+    free(scoreboard->visited);
+    scoreboard->visited = NULL;
+}
+
+/**
+ * @brief Counts the cell the car drove into during the tick, if it moved.
+ *
+ * @param scoreboard Pointer to the scoreboard.
+ */
+void scoreboard_after_tick(Scoreboard *scoreboard) {
+    Location location = current_car.current_location;
+    if (location.x == scoreboard->last.x && location.y == scoreboard->last.y) return;
+
+    scoreboard->last = location;
+    scoreboard->cells_driven++;
+    size_t cell = (size_t) location.y * scoreboard->width + location.x;
+    uint64_t bit = 1ULL << (cell % 64);
+    if (!(scoreboard->visited[cell / 64] & bit)) {
+        scoreboard->visited[cell / 64] |= bit;
+        scoreboard->new_cells++;
+    }
+}
+
+// ======================= EVALUATION ======================= //
+
+/**
+ * @brief Compares the explored map in the globals with the reference graph of the track.
+ *
+ * A MapPoint is found if a node lies at its location, and a reference path is found if an
+ * explored FundamentalPath leaves its node in the same direction and ends at its other node.
+ *
+ * @param scoreboard Pointer to the scoreboard of the exploration.
+ * @param graph Pointer to the reference graph of the track.
+ * @param report Pointer to the report to fill.
+ */
+void scoreboard_evaluate(const Scoreboard *scoreboard, const GroundTruthGraph *graph, ScoreReport *report) {
+    memset(report, 0, sizeof(*report));
+    report->runs = 1;
+    report->nodes = graph->num_nodes;
+    report->paths = graph->num_edges;
+
+    bool *found_nodes = calloc((size_t) graph->num_nodes + 1, sizeof(bool));
+    bool *found_paths = calloc((size_t) graph->num_edges + 1, sizeof(bool));
+    if (!found_nodes || !found_paths) {
+        perror("Error: Failed to allocate score evaluation");
+        exit(EXIT_FAILURE);
+    }
+
+    for (int i = 0; i < num_map_points_all; i++) {
+        MapPoint *mp = map_points_all[i];
+        Location location = mp_location(mp);
+        int node = ground_truth_find_node(graph, location.x, location.y);
+        if (node < 0) {
+            report->extra_map_points++;
+            continue;
+        }
+        found_nodes[node] = true;
+
+        for (int j = 0; j < mp->numberOfPaths; j++) {
+            const FundamentalPath *path = &mp->paths[j];
+            MapPoint *end = fp_end(path);
+            int direction = (int) path->direction;
+            if (!end || direction < 0 || direction > 3) continue;
+
+            int edge = graph->nodes[node].edges[direction];
+            if (edge < 0) continue;
+            const GroundTruthEdge *reference = &graph->edges[edge];
+            const GroundTruthNode *other = &graph->nodes[reference->from == node ? reference->to : reference->from];
+            Location end_location = mp_location(end);
+            if (other->x == end_location.x && other->y == end_location.y) found_paths[edge] = true;
+        }
+    }
+    for (int i = 0; i < graph->num_nodes; i++) report->nodes_found += found_nodes[i];
+    for (int i = 0; i < graph->num_edges; i++) report->paths_found += found_paths[i];
+    free(found_paths);
+    free(found_nodes);
+
+    report->track_cells = graph->cells[CELL_CORRIDOR] + graph->cells[CELL_BEND] + graph->cells[CELL_JUNCTION] +
+                          graph->cells[CELL_DEAD_END];
+    report->cells_visited = (long) scoreboard->new_cells + 1;  // The start cell was never driven into
+    report->cells_driven = scoreboard->cells_driven;
+    report->redundant_cells = scoreboard->cells_driven - scoreboard->new_cells;
+    report->replans = scoreboard->replans;
+
+    Path *lap = find_shortest_lap();
+    long optimal = ground_truth_shortest_lap(graph, start.x, start.y);
+    if (lap && optimal > 0) {
+        report->lap = lap->totalDistance;
+        report->optimal_lap = optimal;
+    } else {
+        report->laps_missing = 1;
+    }
+    path_free(lap);
+}
+
+// ======================= REPORTS ======================= //
+
+/**
+ * @brief Adds the scores of runs to a total.
+ *
+ * @param total Pointer to the total.
+ * @param report Pointer to the scores to add.
+ */
+void score_report_add(ScoreReport *total, const ScoreReport *report) {
+    total->runs += report->runs;
+    total->nodes += report->nodes;
+    total->nodes_found += report->nodes_found;
+    total->extra_map_points += report->extra_map_points;
+    total->paths += report->paths;
+    total->paths_found += report->paths_found;
+    total->track_cells += report->track_cells;
+    total->cells_visited += report->cells_visited;
+    total->cells_driven += report->cells_driven;
+    total->redundant_cells += report->redundant_cells;
+    total->replans += report->replans;
+    total->lap += report->lap;
+    total->optimal_lap += report->optimal_lap;
+    total->laps_missing += report->laps_missing;
+}
+
+/**
+ * @brief Computes a percentage, 0 of nothing.
+ *
+ * @param part Part of the whole.
+ * @param whole The whole.
+ * @return double part / whole in percent.
+ */
+static double percent(double part, double whole) {
+    return whole > 0 ? 100.0 * part / whole : 0.0;
+}
+
+/**
+ * @brief Prints the scores of one or more runs.
+ *
+ * @param report Pointer to the scores.
+ * @param out Stream to write to.
+ */
+void score_report_print(const ScoreReport *report, FILE *out) {
+    fprintf(out, "Exploration score over %lu run%s:\n", report->runs, report->runs == 1 ? "" : "s");
+    fprintf(out, "  MapPoints found    %6.1f%% (%ld of %ld, %ld not in the reference graph)\n",
+            percent((double) report->nodes_found, (double) report->nodes), report->nodes_found, report->nodes,
+            report->extra_map_points);
+    fprintf(out, "  paths found        %6.1f%% (%ld of %ld)\n",
+            percent((double) report->paths_found, (double) report->paths), report->paths_found, report->paths);
+    fprintf(out, "  cells visited      %6.1f%% (%ld of %ld)\n",
+            percent((double) report->cells_visited, (double) report->track_cells), report->cells_visited,
+            report->track_cells);
+    fprintf(out, "  cells driven       %8lu (%lu redundant, %.1f%%)\n", report->cells_driven,
+            report->redundant_cells, percent((double) report->redundant_cells, (double) report->cells_driven));
+    fprintf(out, "  replans            %8lu\n", report->replans);
+    if (report->optimal_lap > 0) {
+        fprintf(out, "  lap / optimal lap  %8.3f (%ld / %ld cells)\n", (double) report->lap / report->optimal_lap,
+                report->lap, report->optimal_lap);
+    }
+    if (report->laps_missing > 0) fprintf(out, "  runs without a lap %8lu\n", report->laps_missing);
+}
+
+// ======================= BATCH TOTALS ======================= //
+
+#define SCORE_MAX_POLICIES 64
+
+/**
+ * @struct PolicyTotals
+ * @brief Summed scores of one policy in a totals file.
+ */
+typedef struct PolicyTotals {
+    char name[64];
+    ScoreReport report;
+} PolicyTotals;
+
+/**
+ * @brief Orders scores by runs without a lap, then lap ratio, then cells driven per track cell, best first.
+ *
+ * @param x Pointer to the first scores.
+ * @param y Pointer to the second scores.
+ * @return int Negative if x ranks before y.
+ */
+int score_report_compare(const ScoreReport *x, const ScoreReport *y) {
+    double missing_x = x->runs > 0 ? (double) x->laps_missing / x->runs : 1.0;
+    double missing_y = y->runs > 0 ? (double) y->laps_missing / y->runs : 1.0;
+    if (missing_x != missing_y) return missing_x < missing_y ? -1 : 1;
+    double lap_x = x->optimal_lap > 0 ? (double) x->lap / x->optimal_lap : 1e9;
+    double lap_y = y->optimal_lap > 0 ? (double) y->lap / y->optimal_lap : 1e9;
+    if (lap_x != lap_y) return lap_x < lap_y ? -1 : 1;
+    double drive_x = x->track_cells > 0 ? (double) x->cells_driven / x->track_cells : 1e9;
+    double drive_y = y->track_cells > 0 ? (double) y->cells_driven / y->track_cells : 1e9;
+    return (drive_x > drive_y) - (drive_x < drive_y);
+}
+
+/**
+ * @brief Orders policies with score_report_compare().
+ *
+ * @param a Pointer to a PolicyTotals.
+ * @param b Pointer to a PolicyTotals.
+ * @return int Negative if a ranks before b.
+ */
+static int compare_policies(const void *a, const void *b) {
+    return score_report_compare(&((const PolicyTotals *) a)->report, &((const PolicyTotals *) b)->report);
+}
+
+/**
+ * @brief Adds reports to the totals of their policies in a file and prints the ranking.
+ *
+ * The file keeps one line of summed scores per policy, so a batch of runs over a corpus
+ * of tracks can be ranked; it is created by the first run.
+ *
+ * @param filename Path of the totals file.
+ * @param names Names of the exploration policies, without whitespace.
+ * @param reports Scores of this run, one per policy.
+ * @param num_reports Number of policies.
+ * @return bool True if the totals were written.
+ */
+bool score_totals_merge(const char *filename, const char *const names[], const ScoreReport reports[], int num_reports) {
+    PolicyTotals policies[SCORE_MAX_POLICIES];
+    int count = 0;
+
+    FILE *in = fopen(filename, "r");
+    if (in) {
+        char line[512];
+        if (!fgets(line, sizeof(line), in) || strncmp(line, SCORE_TOTALS_HEADER, strlen(SCORE_TOTALS_HEADER)) != 0) {
+            fprintf(stderr, "Error: %s is not a score totals file\n", filename);
+            fclose(in);
+            return false;
+        }
+        while (fgets(line, sizeof(line), in) && count < SCORE_MAX_POLICIES) {
+            PolicyTotals *totals = &policies[count];
+            ScoreReport *r = &totals->report;
+            if (sscanf(line, "%63s %lu %ld %ld %ld %ld %ld %ld %ld %lu %lu %lu %ld %ld %lu", totals->name, &r->runs,
+                       &r->nodes, &r->nodes_found, &r->extra_map_points, &r->paths, &r->paths_found,
+                       &r->track_cells, &r->cells_visited, &r->cells_driven, &r->redundant_cells, &r->replans,
+                       &r->lap, &r->optimal_lap, &r->laps_missing) == 15) {
+                count++;
+            }
+        }
+        fclose(in);
+    }
+
+    for (int run = 0; run < num_reports; run++) {
+        int index = 0;
+        while (index < count && strcmp(policies[index].name, names[run]) != 0) index++;
+        if (index == count) {
+            if (count == SCORE_MAX_POLICIES) {
+                fprintf(stderr, "Error: %s holds too many policies\n", filename);
+                return false;
+            }
+            memset(&policies[count], 0, sizeof(PolicyTotals));
+            snprintf(policies[count].name, sizeof(policies[count].name), "%s", names[run]);
+            count++;
+        }
+        score_report_add(&policies[index].report, &reports[run]);
+    }
+
+    // Write a temporary file first so an interrupted run never loses the earlier totals
+    char temp_name[1024];
+    snprintf(temp_name, sizeof(temp_name), "%s.tmp", filename);
+    FILE *out = fopen(temp_name, "w");
+    if (!out) {
+        perror("Error: Failed to write score totals");
+        return false;
+    }
+    fprintf(out, "%s\n# policy runs nodes nodes_found extra_map_points paths paths_found track_cells cells_visited "
+                 "cells_driven redundant_cells replans lap optimal_lap laps_missing\n", SCORE_TOTALS_HEADER);
+    for (int i = 0; i < count; i++) {
+        const ScoreReport *r = &policies[i].report;
+        fprintf(out, "%s %lu %ld %ld %ld %ld %ld %ld %ld %lu %lu %lu %ld %ld %lu\n", policies[i].name, r->runs,
+                r->nodes, r->nodes_found, r->extra_map_points, r->paths, r->paths_found, r->track_cells,
+                r->cells_visited, r->cells_driven, r->redundant_cells, r->replans, r->lap, r->optimal_lap,
+                r->laps_missing);
+    }
+    if (fclose(out) != 0 || rename(temp_name, filename) != 0) {
+        perror("Error: Failed to write score totals");
+        remove(temp_name);
+        return false;
+    }
+
+    qsort(policies, (size_t) count, sizeof(PolicyTotals), compare_policies);
+    printf("Score totals in %s:\n", filename);
+    printf("  %-4s %-24s %8s %10s %12s %10s %8s\n", "rank", "policy", "runs", "lap ratio", "driven/cell", "redundant",
+           "replans");
+    for (int i = 0; i < count; i++) {
+        const ScoreReport *r = &policies[i].report;
+        printf("  %-4d %-24s %8lu %10.3f %12.2f %9.1f%% %8lu\n", i + 1, policies[i].name, r->runs,
+               r->optimal_lap > 0 ? (double) r->lap / r->optimal_lap : 0.0,
+               r->track_cells > 0 ? (double) r->cells_driven / r->track_cells : 0.0,
+               percent((double) r->redundant_cells, (double) r->cells_driven), r->replans);
+    }
+    return true;
+}
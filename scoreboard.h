@@ -0,0 +1,59 @@
+#ifndef SCOREBOARD_H
+#define SCOREBOARD_H
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include "globals.h"
+#include "ground_truth.h"
+
+// ======================= SCOREBOARD ======================= //
+//
+// Measures what an exploration cost against the ground-truth graph of its track
+// (ground_truth.h): how much of the graph it found, how many cells it drove more than once,
+// how often it planned a route, and how long its lap is compared with the optimal lap.
+
+#define SCORE_TOTALS_HEADER "# exploration score totals v1"
+
+/**
+ * @struct Scoreboard
+ * @brief Cells a car drove during one exploration.
+ */
+typedef struct Scoreboard {
+    uint64_t *visited;          /**< One bit per cell of the track */
+    int width;
+    Location last;              /**< Cell of the car after the previous tick */
+    unsigned long cells_driven; /**< Moves into a cell */
+    unsigned long new_cells;    /**< Moves into a cell never driven before */
+    unsigned long replans;      /**< Routes planned to an unexplored MapPoint */
+} Scoreboard;
+
+/**
+ * @struct ScoreReport
+ * @brief Scores of one or more runs; every field adds up over runs.
+ */
+typedef struct ScoreReport {
+    unsigned long runs;
+    long nodes, nodes_found, extra_map_points;
+    long paths, paths_found;
+    long track_cells, cells_visited;
+    unsigned long cells_driven, redundant_cells, replans;
+    long lap, optimal_lap;      /**< Summed over the runs where both are known */
+    unsigned long laps_missing;
+} ScoreReport;
+
+void scoreboard_init(Scoreboard *scoreboard);
+void scoreboard_free(Scoreboard *scoreboard);
+void scoreboard_after_tick(Scoreboard *scoreboard);
+
+// Compare the explored map in the globals with the reference graph of the track
+void scoreboard_evaluate(const Scoreboard *scoreboard, const GroundTruthGraph *graph, ScoreReport *report);
+
+void score_report_add(ScoreReport *total, const ScoreReport *report);
+void score_report_print(const ScoreReport *report, FILE *out);
+int score_report_compare(const ScoreReport *x, const ScoreReport *y);
+
+// Add reports to the totals of their policies in a file and print the ranking of all policies
+bool score_totals_merge(const char *filename, const char *const names[], const ScoreReport reports[], int num_reports);
+
+#endif // SCOREBOARD_H
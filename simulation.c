@@ -0,0 +1,278 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "simulation.h"
+#include "perf_counters.h"
+#include "alloc_tracker.h"
+
+// ======================= STATE SWAPPING ======================= //
+
+/**
+ * @brief Copies the global exploration state into a simulation.
+ *
+ * @param sim Pointer to the simulation to store the state in.
+ */
+static void store_simulation(Simulation *sim) {
+    sim->map_points_tbd = map_points_tbd;
+    sim->map_points_all = map_points_all;
+    sim->all_fundamental_paths = all_fundamental_paths;
+    sim->map_points_changed = map_points_changed;
+    sim->num_map_points_tbd = num_map_points_tbd;
+    sim->capacity_map_points_tbd = capacity_map_points_tbd;
+    sim->num_map_points_all = num_map_points_all;
+    sim->capacity_map_points_all = capacity_map_points_all;
+    sim->num_all_fundamental_paths = num_all_fundamental_paths;
+    sim->capacity_all_fundamental_paths = capacity_all_fundamental_paths;
+    sim->num_map_points_changed = num_map_points_changed;
+    sim->capacity_map_points_changed = capacity_map_points_changed;
+    sim->map_point_counter = map_point_counter;
+    sim->fundamental_path_counter = fundamental_path_counter;
+
+    sim->start = start;
+    sim->start_orientation = start_orientation;
+    sim->current_car = current_car;
+    memcpy(sim->ultrasonic_sensors, ultrasonic_sensors, sizeof(ultrasonic_sensors));
+    sim->track = current_track;
+    sim->map_version = live_map_version;
+    sim->sensor_noise = sensor_noise;
+    sim->motor_noise = motor_noise;
+    sim->occupancy = occupancy_grid;
+
+    sim->former_map_point = former_map_point;
+    sim->latest_map_point = latest_map_point;
+    sim->map_changed = map_changed;
+    sim->leaving_former = leaving_former;
+    sim->policy = exploration_policy;
+}
+
+/**
+ * @brief Makes a simulation the global exploration state.
+ *
+ * @param sim Pointer to the simulation to load.
+ */
+static void load_simulation(const Simulation *sim) {
+    map_points_tbd = sim->map_points_tbd;
+    map_points_all = sim->map_points_all;
+    all_fundamental_paths = sim->all_fundamental_paths;
+    map_points_changed = sim->map_points_changed;
+    num_map_points_tbd = sim->num_map_points_tbd;
+    capacity_map_points_tbd = sim->capacity_map_points_tbd;
+    num_map_points_all = sim->num_map_points_all;
+    capacity_map_points_all = sim->capacity_map_points_all;
+    num_all_fundamental_paths = sim->num_all_fundamental_paths;
+    capacity_all_fundamental_paths = sim->capacity_all_fundamental_paths;
+    num_map_points_changed = sim->num_map_points_changed;
+    capacity_map_points_changed = sim->capacity_map_points_changed;
+    map_point_counter = sim->map_point_counter;
+    fundamental_path_counter = sim->fundamental_path_counter;
+
+    start = sim->start;
+    start_orientation = sim->start_orientation;
+    current_car = sim->current_car;
+    memcpy(ultrasonic_sensors, sim->ultrasonic_sensors, sizeof(ultrasonic_sensors));
+    current_track = sim->track;
+    live_map_version = sim->map_version;
+    sensor_noise = sim->sensor_noise;
+    motor_noise = sim->motor_noise;
+    occupancy_grid = sim->occupancy;
+
+    former_map_point = sim->former_map_point;
+    latest_map_point = sim->latest_map_point;
+    map_changed = sim->map_changed;
+    leaving_former = sim->leaving_former;
+    exploration_policy = sim->policy;
+}
+
+// ======================= SIMULATION API ======================= //
+
+/**
+ * @brief Creates a simulation of a variant of the loop track with the car at its start position.
+ *
+ * The global state of the caller is left untouched; the simulation explores with the
+ * caller's policy and noise streams until its policy and noise fields are changed. With
+ * presize_explorations set, the simulation is presized for its track.
+ *
+ * @param sim Pointer to the simulation to initialize.
+ * @param track_variant Variant of the loop track, 0 for the loop track itself (see create_track_variant()).
+ */
+void simulation_init(Simulation *sim, int track_variant) {
+    Simulation caller;
+    store_simulation(&caller);
+
+    initialize_globals();
+    initialize_grid();
+    create_track_variant(track_variant);
+    start = current_car.current_location;
+    start_orientation = current_car.current_orientation;
+    former_map_point = NULL;
+    map_changed = false;
+    leaving_former = false;
+    if (presize_explorations) exploration_presize((int) track_cells_on_track(), 1);
+
+    store_simulation(sim);
+    exploration_state_init(&sim->exploration);
+
+    load_simulation(&caller);
+}
+
+/**
+ * @brief Frees the map, route and track owned by a simulation.
+ *
+ * @param sim Pointer to the simulation.
+ */
+void simulation_free(Simulation *sim) {
+    Simulation caller;
+    store_simulation(&caller);
+
+    load_simulation(sim);
+    free_globals();
+    exploration_state_free(&sim->exploration);
+    track_free(sim->track);
+
+    load_simulation(&caller);
+}
+
+/**
+ * @brief Advances a simulation by exactly one tick.
+ *
+ * Never sleeps or draws the grid, so thousands of simulations can be interleaved on one
+ * thread or driven by a scheduler.
+ *
+ * @param sim Pointer to the simulation.
+ * @return ExplorationStatus What the car did during the tick.
+ */
+ExplorationStatus exploration_step(Simulation *sim) {
+    if (sim->exploration.phase == PHASE_DONE) return EXPLORATION_DONE;
+
+    Simulation caller;
+    store_simulation(&caller);
+
+    load_simulation(sim);
+    PerfSample tick_sample;
+    perf_site_begin(&tick_sample);
+    alloc_tracker_begin_tick();
+    ExplorationStatus status = exploration_tick(&sim->exploration);
+    perf_site_end(PERF_SITE_SIMULATION_TICK, &tick_sample);
+    alloc_tracker_end_tick(sim->exploration.ticks);
+    store_simulation(sim);
+
+    load_simulation(&caller);
+    return status;
+}
+
+/**
+ * @brief Starts scoring the driving of a simulation.
+ *
+ * @param sim Pointer to the simulation.
+ * @param scoreboard Pointer to the scoreboard to initialize for it.
+ */
+void simulation_start_scoring(Simulation *sim, Scoreboard *scoreboard) {
+    Simulation caller;
+    store_simulation(&caller);
+
+    load_simulation(sim);
+    scoreboard_init(scoreboard);
+    sim->exploration.scoreboard = scoreboard;
+
+    load_simulation(&caller);
+}
+
+/**
+ * @brief Scores a finished simulation against the reference graph of its track.
+ *
+ * @param sim Pointer to the simulation.
+ * @param report Pointer to the report to fill.
+ */
+void simulation_score(Simulation *sim, ScoreReport *report) {
+    Simulation caller;
+    store_simulation(&caller);
+
+    load_simulation(sim);
+    exploration_record_final_map_point();
+    GroundTruthGraph graph;
+    ground_truth_extract_track(&graph);
+    scoreboard_evaluate(sim->exploration.scoreboard, &graph, report);
+    ground_truth_free(&graph);
+    store_simulation(sim);
+
+    load_simulation(&caller);
+}
+
+/**
+ * @brief Presizes a simulation that grows side by side with others (see exploration_presize()).
+ *
+ * @param sim Pointer to the simulation.
+ * @param side_by_side Number of simulations stepped together, sharing the free lists.
+ */
+static void presize_simulation(Simulation *sim, int side_by_side) {
+    Simulation caller;
+    store_simulation(&caller);
+
+    load_simulation(sim);
+    exploration_presize((int) sim->track->on_track, side_by_side);
+    store_simulation(sim);
+
+    load_simulation(&caller);
+}
+
+/**
+ * @brief Steps several simulations round-robin on the calling thread until all are done.
+ *
+ * @param count Number of simulations to run.
+ * @param score Pointer to add the scores of all simulations to, NULL to not score them.
+ */
+void run_interleaved_simulations(int count, ScoreReport *score) {
+    if (count <= 0) return;
+
+    Simulation *sims = malloc(count * sizeof(Simulation));
+    if (!sims) {
+        perror("Error: Failed to allocate simulations");
+        exit(EXIT_FAILURE);
+    }
+    for (int i = 0; i < count; i++) simulation_init(&sims[i], 0);
+    if (presize_explorations) {
+        for (int i = 0; i < count; i++) presize_simulation(&sims[i], count);
+    }
+    Scoreboard *scoreboards = NULL;
+    if (score) {
+        scoreboards = malloc(count * sizeof(Scoreboard));
+        if (!scoreboards) {
+            perror("Error: Failed to allocate scoreboards");
+            exit(EXIT_FAILURE);
+        }
+        for (int i = 0; i < count; i++) simulation_start_scoring(&sims[i], &scoreboards[i]);
+    }
+
+    struct timespec begin, end;
+    clock_gettime(CLOCK_MONOTONIC, &begin);
+
+    unsigned long ticks = 0;
+    int running = count;
+    while (running > 0) {
+        running = 0;
+        for (int i = 0; i < count; i++) {
+            if (sims[i].exploration.phase == PHASE_DONE) continue;
+            if (exploration_step(&sims[i]) != EXPLORATION_DONE) running++;
+            ticks++;
+        }
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double elapsed_ms = (end.tv_sec - begin.tv_sec) * 1e3 + (end.tv_nsec - begin.tv_nsec) / 1e6;
+    printf("Stepped %d simulations: %lu ticks in %.3f ms (%.0f ticks/s)\n",
+           count, ticks, elapsed_ms, elapsed_ms > 0 ? ticks / (elapsed_ms / 1e3) : 0.0);
+
+    if (score) {
+        for (int i = 0; i < count; i++) {
+            ScoreReport report;
+            simulation_score(&sims[i], &report);
+            score_report_add(score, &report);
+            scoreboard_free(&scoreboards[i]);
+        }
+        free(scoreboards);
+    }
+
+    for (int i = 0; i < count; i++) simulation_free(&sims[i]);
+    free(sims);
+}
@@ -0,0 +1,68 @@
+#ifndef SIMULATION_H
+#define SIMULATION_H
+
+#include "globals.h"
+#include "exploration.h"
+#include "scoreboard.h"
+#include "policy.h"
+#include "map_version.h"
+#include "noise.h"
+#include "occupancy.h"
+#include "track_files_PRIVATE/track_generation.h"
+
+/**
+ * @struct Simulation
+ * @brief Everything one exploration run owns, so many runs can be stepped side by side.
+ *
+ * The exploration code works on the globals of globals.h; exploration_step() loads a
+ * Simulation into them for the duration of one tick and stores it back afterwards.
+ * The asynchronous planner (planner.h) only serves the globals of the main run, so
+ * it must not be running while simulations are stepped.
+ */
+typedef struct Simulation {
+    // Map (see globals.h)
+    MapPoint **map_points_tbd;
+    MapPoint **map_points_all;
+    FundamentalPath **all_fundamental_paths;
+    MapPoint **map_points_changed;
+    int num_map_points_tbd, capacity_map_points_tbd;
+    int num_map_points_all, capacity_map_points_all;
+    int num_all_fundamental_paths, capacity_all_fundamental_paths;
+    int num_map_points_changed, capacity_map_points_changed;
+    int map_point_counter, fundamental_path_counter;
+
+    // Car and track
+    Location start;
+    Direction start_orientation;
+    Car current_car;
+    bool ultrasonic_sensors[3];
+    TrackGrid *track;
+    MapVersion map_version;     // Live map version of what-if searches (see map_version.h)
+    NoiseStream sensor_noise;   // Random streams of the noise model (see noise.h)
+    NoiseStream motor_noise;
+    OccupancyGrid occupancy;    // Sensor evidence per cell (see occupancy.h)
+
+    // Exploration (see exploration.h)
+    MapPoint *former_map_point;
+    MapPoint *latest_map_point;
+    bool map_changed;
+    bool leaving_former;
+    ExplorationState exploration;
+    const ExplorationPolicy *policy;    // How this simulation explores (see policy.h)
+} Simulation;
+
+// Create a simulation of a variant of the loop track with the car at its start position
+void simulation_init(Simulation *sim, int track_variant);
+void simulation_free(Simulation *sim);
+
+// Advance a simulation by exactly one tick without blocking
+ExplorationStatus exploration_step(Simulation *sim);
+
+// Score the driving of a simulation against the reference graph of its track
+void simulation_start_scoring(Simulation *sim, Scoreboard *scoreboard);
+void simulation_score(Simulation *sim, ScoreReport *report);
+
+// Step several simulations round-robin on the calling thread and report the tick rate
+void run_interleaved_simulations(int count, ScoreReport *score);
+
+#endif // SIMULATION_H
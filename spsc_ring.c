@@ -0,0 +1,104 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "spsc_ring.h"
+
+/**
+ * @brief Initializes an empty ring.
+ *
+ * @param ring Pointer to the ring.
+ * @param capacity Maximum number of queued messages, rounded up to a power of two.
+ * @param message_size Size of one message in bytes.
+ */
+void spsc_ring_init(SpscRing *ring, unsigned capacity, size_t message_size) {
+    unsigned rounded = 1;
+    while (rounded < capacity) rounded *= 2;
+
+    ring->slots = malloc(rounded * message_size);
+    if (!ring->slots) {
+        perror("Error: Failed to allocate ring buffer");
+        exit(EXIT_FAILURE);
+    }
+    ring->owns_slots = true;
+    ring->message_size = message_size;
+    ring->capacity = rounded;
+    atomic_init(&ring->head, 0);
+    atomic_init(&ring->tail, 0);
+}
+
+/**
+ * @brief Initializes an empty ring on storage owned by the caller.
+ *
+ * @param ring Pointer to the ring.
+ * @param slots Storage for capacity messages, e.g. a static array.
+ * @param capacity Maximum number of queued messages, must be a power of two.
+ * @param message_size Size of one message in bytes.
+ */
+void spsc_ring_init_static(SpscRing *ring, void *slots, unsigned capacity, size_t message_size) {
+    if (capacity == 0 || (capacity & (capacity - 1)) != 0) {
+        fprintf(stderr, "Error: Ring capacity %u is not a power of two\n", capacity);
+        exit(EXIT_FAILURE);
+    }
+
+    ring->slots = slots;
+    ring->owns_slots = false;
+    ring->message_size = message_size;
+    ring->capacity = capacity;
+    atomic_init(&ring->head, 0);
+    atomic_init(&ring->tail, 0);
+}
+
+/**
+ * @brief Releases the memory of a ring.
+ *
+ * @param ring Pointer to the ring.
+ */
+void spsc_ring_free(SpscRing *ring) {
+    if (ring->owns_slots) free(ring->slots);
+    ring->slots = NULL;
+}
+
+/**
+ * @brief Appends a message. Only the producer thread may call this.
+ *
+ * @param ring Pointer to the ring.
+ * @param message Pointer to the message to copy in.
+ * @return bool True if the message was queued, false if the ring is full.
+ */
+bool spsc_ring_push(SpscRing *ring, const void *message) {
+    unsigned head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    unsigned tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+    if (head - tail == ring->capacity) return false;
+
+    memcpy(ring->slots + (head & (ring->capacity - 1)) * ring->message_size, message, ring->message_size);
+    atomic_store_explicit(&ring->head, head + 1, memory_order_release);
+    return true;
+}
+
+/**
+ * @brief Removes the oldest message. Only the consumer thread may call this.
+ *
+ * @param ring Pointer to the ring.
+ * @param message Pointer to copy the message to.
+ * @return bool True if a message was removed, false if the ring is empty.
+ */
+bool spsc_ring_pop(SpscRing *ring, void *message) {
+    unsigned tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    unsigned head = atomic_load_explicit(&ring->head, memory_order_acquire);
+    if (tail == head) return false;
+
+    memcpy(message, ring->slots + (tail & (ring->capacity - 1)) * ring->message_size, ring->message_size);
+    atomic_store_explicit(&ring->tail, tail + 1, memory_order_release);
+    return true;
+}
+
+/**
+ * @brief Returns the number of queued messages.
+ *
+ * @param ring Pointer to the ring.
+ * @return unsigned Queue depth.
+ */
+unsigned spsc_ring_depth(SpscRing *ring) {
+    return atomic_load_explicit(&ring->head, memory_order_acquire) -
+           atomic_load_explicit(&ring->tail, memory_order_acquire);
+}
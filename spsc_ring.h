@@ -0,0 +1,32 @@
+#ifndef SPSC_RING_H
+#define SPSC_RING_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdatomic.h>
+
+// Bounded lock-free queue for exactly one producer thread and one consumer thread.
+// Messages are copied in and out by value.
+typedef struct SpscRing {
+    unsigned char *slots;
+    bool owns_slots;            // Slots were allocated by spsc_ring_init()
+    size_t message_size;
+    unsigned capacity;          // Power of two
+    atomic_uint head;           // Next slot to write, only advanced by the producer
+    atomic_uint tail;           // Next slot to read, only advanced by the consumer
+} SpscRing;
+
+void spsc_ring_init(SpscRing *ring, unsigned capacity, size_t message_size);
+void spsc_ring_init_static(SpscRing *ring, void *slots, unsigned capacity, size_t message_size);
+void spsc_ring_free(SpscRing *ring);
+
+// Producer side
+bool spsc_ring_push(SpscRing *ring, const void *message);
+
+// Consumer side
+bool spsc_ring_pop(SpscRing *ring, void *message);
+
+// Number of queued messages (exact on either side, approximate elsewhere)
+unsigned spsc_ring_depth(SpscRing *ring);
+
+#endif // SPSC_RING_H
@@ -0,0 +1,99 @@
+#include <stdatomic.h>
+#include "static_pools.h"
+
+// ======================= STATIC POOLS ======================= //
+//
+// A pool hands out blocks from its static array in order and recycles released blocks
+// through a free list, so its footprint is fixed at compile time. When a pool runs dry the
+// failure is recorded once and every exploration stops at its next tick; nothing exits.
+
+// Every defined pool, registered before main() runs
+static StaticPool *pools = NULL;
+
+// Set once any pool or fixed-size array ran out
+static atomic_bool exhausted = false;
+
+/**
+ * @brief Adds a pool to the report. Called by the constructor of STATIC_POOL_DEFINE().
+ *
+ * @param pool Pointer to the pool.
+ */
+void static_pool_register(StaticPool *pool) {
+    pool->next = pools;
+    pools = pool;
+}
+
+/**
+ * @brief Takes a block from a pool.
+ *
+ * @param pool Pointer to the pool.
+ * @return void* The block, or NULL if the pool is exhausted (see static_pools_fail()).
+ */
+void *static_pool_take(StaticPool *pool) {
+    pthread_mutex_lock(&pool->lock);
+    void *block = pool->free_blocks;
+    if (block) {
+        pool->free_blocks = *(void **) block;
+    } else if (pool->untouched < pool->capacity) {
+        block = pool->storage + (size_t) pool->untouched++ * pool->block_size;
+    }
+    if (block && ++pool->in_use > pool->peak) pool->peak = pool->in_use;
+    pthread_mutex_unlock(&pool->lock);
+
+    if (!block) static_pools_fail(pool->name);
+    return block;
+}
+
+/**
+ * @brief Returns a block to the pool it was taken from.
+ *
+ * @param pool Pointer to the pool.
+ * @param block Pointer to the block, may be NULL.
+ */
+void static_pool_give(StaticPool *pool, void *block) {
+    if (!block) return;
+
+    pthread_mutex_lock(&pool->lock);
+    *(void **) block = pool->free_blocks;
+    pool->free_blocks = block;
+    pool->in_use--;
+    pthread_mutex_unlock(&pool->lock);
+}
+
+/**
+ * @brief Records that a pool or fixed-size array is too small, so exploration stops.
+ *
+ * Only the first failure is reported.
+ *
+ * @param what Name of the pool and the macro that sizes it.
+ */
+void static_pools_fail(const char *what) {
+    if (!atomic_exchange(&exhausted, true)) {
+        fprintf(stderr, "Error: Static pool exhausted: %s\n", what);
+    }
+}
+
+/**
+ * @brief Checks if any pool ran out.
+ *
+ * @return bool True once static_pools_fail() was called.
+ */
+bool static_pools_exhausted() {
+    return atomic_load(&exhausted);
+}
+
+/**
+ * @brief Prints the size and peak use of every pool, and their total footprint.
+ *
+ * @param out Stream to write to.
+ */
+void static_pools_report(FILE *out) {
+    size_t total = 0;
+    fprintf(out, "%-44s %8s %8s %10s\n", "Static pools", "blocks", "peak", "bytes");
+    for (StaticPool *pool = pools; pool; pool = pool->next) {
+        size_t bytes = (size_t) pool->capacity * pool->block_size;
+        fprintf(out, "%-44s %8d %8d %10zu\n", pool->name, pool->capacity, pool->peak, bytes);
+        total += bytes;
+    }
+    fprintf(out, "%-44s %8s %8s %10zu\n", "total", "", "", total);
+}
@@ -0,0 +1,87 @@
+#ifndef STATIC_POOLS_H
+#define STATIC_POOLS_H
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <pthread.h>
+
+// ======================= STATIC POOL SIZES ======================= //
+//
+// With STATIC_POOLS defined, MapPoints, FundamentalPaths, the global map arrays, routes,
+// search scratch space and the planner's storage come from fixed-size static arrays
+// instead of the heap. Every size can be overridden on the compiler command line, e.g.
+// -DPOOL_MAP_POINTS=128. Running out of a pool stops the exploration instead of crashing.
+
+#ifndef POOL_MAP_POINTS
+#define POOL_MAP_POINTS 256             // MapPoints of all maps together, and of a single map
+#endif
+
+#ifndef POOL_PATHS_PER_MAP_POINT
+#define POOL_PATHS_PER_MAP_POINT 4      // A grid cell has at most four neighbours
+#endif
+
+#ifndef POOL_MAP_SETS
+#define POOL_MAP_SETS 4                 // Maps alive at the same time (main plus simulations)
+#endif
+
+#ifndef POOL_QUEUE_NODES
+#define POOL_QUEUE_NODES (POOL_MAP_POINTS * POOL_PATHS_PER_MAP_POINT)  // One per relaxation
+#endif
+
+#ifndef POOL_ROUTES
+#define POOL_ROUTES 8                   // Paths alive at the same time
+#endif
+
+#ifndef POOL_ROUTE_LENGTH
+#define POOL_ROUTE_LENGTH (2 * POOL_MAP_POINTS)  // A lap may pass a MapPoint twice
+#endif
+
+#ifndef POOL_MAP_NODES
+#define POOL_MAP_NODES (4 * POOL_MAP_POINTS)  // The live map version plus the nodes copied by what-if forks
+#endif
+
+#ifndef POOL_MAP_TRIES
+#define POOL_MAP_TRIES 64               // Trie levels of all map versions together
+#endif
+
+#ifndef POOL_PLANNER_TABLES
+#define POOL_PLANNER_TABLES 3           // Being computed, in the mailbox, in use by the control loop
+#endif
+
+// ======================= STATIC POOL ======================= //
+
+/**
+ * @struct StaticPool
+ * @brief Fixed number of equally sized blocks in static storage.
+ */
+typedef struct StaticPool {
+    const char *name;           /**< Pool and the macro that sizes it, for messages */
+    unsigned char *storage;
+    size_t block_size;
+    int capacity;
+    int untouched;              /**< Blocks from this index on were never handed out */
+    void *free_blocks;          /**< Released blocks, linked through their first bytes */
+    int in_use;
+    int peak;
+    struct StaticPool *next;    /**< Next pool in the report */
+    pthread_mutex_t lock;       /**< Blocks may be released by another thread */
+} StaticPool;
+
+// Defines a pool of 'count' blocks of 'type' with internal linkage, listed by static_pools_report()
+#define STATIC_POOL_DEFINE(pool, label, type, count)                                              \
+    _Static_assert(sizeof(type) >= sizeof(void *), "Pool blocks must hold a pointer");           \
+    static type pool##_blocks[count];                                                              \
+    static StaticPool pool = {label, (unsigned char *) pool##_blocks, sizeof(type), count,         \
+                              0, NULL, 0, 0, NULL, PTHREAD_MUTEX_INITIALIZER};                     \
+    __attribute__((constructor)) static void pool##_register() { static_pool_register(&pool); }
+
+void static_pool_register(StaticPool *pool);
+void *static_pool_take(StaticPool *pool);
+void static_pool_give(StaticPool *pool, void *block);
+
+void static_pools_fail(const char *what);
+bool static_pools_exhausted();
+void static_pools_report(FILE *out);
+
+#endif // STATIC_POOLS_H
@@ -0,0 +1,367 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include "telemetry.h"
+#include "spsc_ring.h"
+
+// ======================= TELEMETRY ======================= //
+//
+// Every thread records into its own lock-free ring, so recording never waits on a lock or on
+// I/O: a full ring drops the event and counts it. The flusher thread drains the rings a few
+// hundred times per second and appends the events to the log.
+//
+// Log format: a header of magic and version, then one record per event:
+//
+//   type (1 byte) | thread (1 byte) | orientation | sensors | decision
+//   | zigzag varint deltas of timestamp, tick, x, y, value, value2
+//
+// Deltas are taken against the previous event of the same thread, so a tick typically
+// encodes in about a dozen bytes.
+
+#define TELEMETRY_FLUSH_INTERVAL_NS 5000000   // 5 ms
+
+/**
+ * @struct TelemetryThread
+ * @brief Ring of one recording thread.
+ */
+typedef struct TelemetryThread {
+    SpscRing ring;
+    atomic_uint dropped;
+} TelemetryThread;
+
+bool telemetry_enabled = false;
+
+static TelemetryThread threads[TELEMETRY_MAX_THREADS];
+static atomic_uint thread_count = 0;
+static pthread_mutex_t register_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static _Thread_local TelemetryThread *local_thread = NULL;
+static _Thread_local uint8_t local_index = 0;
+static _Thread_local uint32_t local_tick = 0;
+
+static pthread_t flusher_thread;
+static atomic_bool flusher_running = false;
+static FILE *log_file = NULL;
+static TelemetryEvent previous[TELEMETRY_MAX_THREADS];
+static unsigned long events_written = 0;
+
+/**
+ * @brief Reads the clock used for event timestamps.
+ *
+ * The coarse clock is read from the vDSO without a system call, which keeps a recorded
+ * event in the low nanoseconds; its resolution of a few ms is plenty to place events.
+ *
+ * @return uint64_t Monotonic time in nanoseconds.
+ */
+static uint64_t timestamp_now() {
+    struct timespec ts;
+#ifdef CLOCK_MONOTONIC_COARSE
+    clock_gettime(CLOCK_MONOTONIC_COARSE, &ts);
+#else
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+#endif
+    return (uint64_t) ts.tv_sec * 1000000000ULL + (uint64_t) ts.tv_nsec;
+}
+
+/**
+ * @brief Reads the precise monotonic clock, for measuring durations stored in events.
+ *
+ * @return uint64_t Monotonic time in nanoseconds.
+ */
+uint64_t telemetry_now() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000ULL + (uint64_t) ts.tv_nsec;
+}
+
+// ======================= RECORDING ======================= //
+
+/**
+ * @brief Gives the calling thread its own ring on first use.
+ *
+ * @return TelemetryThread* The ring of the thread, or NULL if all rings are taken.
+ */
+static TelemetryThread *register_thread() {
+    pthread_mutex_lock(&register_lock);
+    unsigned index = atomic_load(&thread_count);
+    if (index < TELEMETRY_MAX_THREADS) {
+        spsc_ring_init(&threads[index].ring, TELEMETRY_RING_SIZE, sizeof(TelemetryEvent));
+        atomic_store(&threads[index].dropped, 0);
+        local_thread = &threads[index];
+        local_index = (uint8_t) index;
+
+        // Publish the ring only once it is initialized
+        atomic_store(&thread_count, index + 1);
+    }
+    pthread_mutex_unlock(&register_lock);
+    return local_thread;
+}
+
+/**
+ * @brief Sets the tick stamped on the events of the calling thread.
+ *
+ * @param tick The current tick.
+ */
+void telemetry_set_tick(uint32_t tick) {
+    local_tick = tick;
+}
+
+/**
+ * @brief Records an event in the ring of the calling thread.
+ *
+ * Never blocks: if the ring is full the event is dropped and counted.
+ *
+ * @param event The event, timestamp, tick and thread are filled in here.
+ */
+void telemetry_record(TelemetryEvent event) {
+    if (!telemetry_enabled) return;
+
+    TelemetryThread *thread = local_thread ? local_thread : register_thread();
+    if (!thread) return;
+
+    event.timestamp = timestamp_now();
+    event.tick = local_tick;
+    event.thread = local_index;
+    if (!spsc_ring_push(&thread->ring, &event)) {
+        atomic_fetch_add_explicit(&thread->dropped, 1, memory_order_relaxed);
+    }
+}
+
+// ======================= ENCODING ======================= //
+
+/**
+ * @brief Appends an unsigned LEB128 varint to a buffer.
+ *
+ * @param out Pointer to the write position, advanced past the varint.
+ * @param value The value.
+ */
+static void put_varint(unsigned char **out, uint64_t value) {
+    while (value >= 0x80) {
+        *(*out)++ = (unsigned char) (value | 0x80);
+        value >>= 7;
+    }
+    *(*out)++ = (unsigned char) value;
+}
+
+/**
+ * @brief Appends a signed delta as a zigzag varint.
+ *
+ * @param out Pointer to the write position.
+ * @param delta The signed difference to the previous value.
+ */
+static void put_delta(unsigned char **out, int64_t delta) {
+    put_varint(out, ((uint64_t) delta << 1) ^ (uint64_t) (delta >> 63));
+}
+
+/**
+ * @brief Encodes an event against the previous event of its thread and writes it to the log.
+ *
+ * @param event Pointer to the event.
+ */
+static void write_event(const TelemetryEvent *event) {
+    unsigned char record[64];
+    unsigned char *out = record;
+    TelemetryEvent *last = &previous[event->thread];
+
+    *out++ = event->type;
+    *out++ = event->thread;
+    *out++ = event->orientation;
+    *out++ = event->sensors;
+    *out++ = event->decision;
+    put_delta(&out, (int64_t) (event->timestamp - last->timestamp));
+    put_delta(&out, (int64_t) event->tick - (int64_t) last->tick);
+    put_delta(&out, (int64_t) event->x - last->x);
+    put_delta(&out, (int64_t) event->y - last->y);
+    put_delta(&out, (int64_t) event->value - last->value);
+    put_delta(&out, (int64_t) event->value2 - last->value2);
+
+    fwrite(record, 1, (size_t) (out - record), log_file);
+    *last = *event;
+    events_written++;
+}
+
+/**
+ * @brief Writes every queued event of every thread to the log.
+ */
+static void flush_rings() {
+    unsigned count = atomic_load(&thread_count);
+    for (unsigned i = 0; i < count; i++) {
+        TelemetryEvent event;
+        while (spsc_ring_pop(&threads[i].ring, &event)) {
+            write_event(&event);
+        }
+    }
+}
+
+/**
+ * @brief Main loop of the flusher thread.
+ *
+ * @param arg Unused.
+ * @return void* Always NULL.
+ */
+static void *flusher_main(void *arg) {
+    (void) arg;
+    struct timespec pause = {0, TELEMETRY_FLUSH_INTERVAL_NS};
+
+    while (atomic_load(&flusher_running)) {
+        flush_rings();
+        nanosleep(&pause, NULL);
+    }
+    return NULL;
+}
+
+/**
+ * @brief Opens a telemetry log and starts the flusher thread.
+ *
+ * @param filename Path of the log file.
+ * @return bool True if telemetry is recording, false otherwise.
+ */
+bool telemetry_start(const char *filename) {
+    if (telemetry_enabled || !filename) return false;
+
+    log_file = fopen(filename, "wb");
+    if (!log_file) {
+        perror("Error: Failed to open telemetry log");
+        return false;
+    }
+
+    uint32_t header[2] = {TELEMETRY_MAGIC, TELEMETRY_VERSION};
+    fwrite(header, sizeof(header), 1, log_file);
+    memset(previous, 0, sizeof(previous));
+    events_written = 0;
+
+    atomic_store(&flusher_running, true);
+    if (pthread_create(&flusher_thread, NULL, flusher_main, NULL) != 0) {
+        perror("Error: Failed to start telemetry flusher");
+        exit(EXIT_FAILURE);
+    }
+    telemetry_enabled = true;
+    return true;
+}
+
+/**
+ * @brief Stops recording, writes the remaining events and closes the log.
+ *
+ * Must be called once the recording threads are done.
+ */
+void telemetry_stop() {
+    if (!telemetry_enabled) return;
+    telemetry_enabled = false;
+
+    atomic_store(&flusher_running, false);
+    pthread_join(flusher_thread, NULL);
+    flush_rings();
+
+    // Report lost events in the log itself
+    unsigned count = atomic_load(&thread_count);
+    unsigned long dropped = 0;
+    for (unsigned i = 0; i < count; i++) {
+        unsigned lost = atomic_load(&threads[i].dropped);
+        if (lost > 0) {
+            TelemetryEvent event = {.timestamp = timestamp_now(), .type = TELEMETRY_DROPPED,
+                                    .thread = (uint8_t) i, .decision = TELEMETRY_NO_DECISION,
+                                    .value = (int32_t) lost};
+            write_event(&event);
+            dropped += lost;
+        }
+        spsc_ring_free(&threads[i].ring);
+    }
+    atomic_store(&thread_count, 0);
+
+    fclose(log_file);
+    log_file = NULL;
+    printf("Telemetry: %lu events written, %lu dropped\n", events_written, dropped);
+}
+
+// ======================= DECODING ======================= //
+
+/**
+ * @brief Returns the name of an event type.
+ *
+ * @param type The TelemetryType.
+ * @return const char* Its name, "unknown" if it is not a valid type.
+ */
+const char *telemetry_type_name(uint8_t type) {
+    static const char *names[TELEMETRY_TYPE_COUNT] = {
+        "tick", "map_point_created", "map_point_updated", "planner_query", "planner_table", "dropped"
+    };
+    return type < TELEMETRY_TYPE_COUNT ? names[type] : "unknown";
+}
+
+/**
+ * @brief Reads an unsigned LEB128 varint.
+ *
+ * @param data Pointer to the read position, advanced past the varint.
+ * @param end End of the data.
+ * @param value Pointer to store the value in.
+ * @return bool True if a complete varint was read, false otherwise.
+ */
+static bool get_varint(const unsigned char **data, const unsigned char *end, uint64_t *value) {
+    *value = 0;
+    for (int shift = 0; *data < end && shift < 64; shift += 7) {
+        unsigned char byte = *(*data)++;
+        *value |= (uint64_t) (byte & 0x7F) << shift;
+        if (!(byte & 0x80)) return true;
+    }
+    return false;
+}
+
+/**
+ * @brief Reads a zigzag varint delta.
+ *
+ * @param data Pointer to the read position.
+ * @param end End of the data.
+ * @param delta Pointer to store the signed delta in.
+ * @return bool True if a complete delta was read, false otherwise.
+ */
+static bool get_delta(const unsigned char **data, const unsigned char *end, int64_t *delta) {
+    uint64_t value;
+    if (!get_varint(data, end, &value)) return false;
+    *delta = (int64_t) (value >> 1) ^ -(int64_t) (value & 1);
+    return true;
+}
+
+/**
+ * @brief Decodes the next event of a telemetry log.
+ *
+ * @param data Pointer to the read position, just after the log header for the first event.
+ * @param end End of the log.
+ * @param last Last decoded event of every thread, zeroed before the first event.
+ * @param event Pointer to store the decoded event in.
+ * @return bool True if an event was decoded, false at the end of the log or on corrupt data.
+ */
+bool telemetry_decode_event(const unsigned char **data, const unsigned char *end,
+                            TelemetryEvent last[TELEMETRY_MAX_THREADS], TelemetryEvent *event) {
+    if (end - *data < 5) return false;
+
+    const unsigned char *in = *data;
+    uint8_t type = *in++;
+    uint8_t thread = *in++;
+    if (thread >= TELEMETRY_MAX_THREADS) return false;
+
+    TelemetryEvent decoded = last[thread];
+    decoded.type = type;
+    decoded.thread = thread;
+    decoded.orientation = *in++;
+    decoded.sensors = *in++;
+    decoded.decision = *in++;
+
+    int64_t deltas[6];
+    for (int i = 0; i < 6; i++) {
+        if (!get_delta(&in, end, &deltas[i])) return false;
+    }
+    decoded.timestamp += (uint64_t) deltas[0];
+    decoded.tick = (uint32_t) ((int64_t) decoded.tick + deltas[1]);
+    decoded.x = (int32_t) (decoded.x + deltas[2]);
+    decoded.y = (int32_t) (decoded.y + deltas[3]);
+    decoded.value = (int32_t) (decoded.value + deltas[4]);
+    decoded.value2 = (int32_t) (decoded.value2 + deltas[5]);
+
+    last[thread] = decoded;
+    *event = decoded;
+    *data = in;
+    return true;
+}
@@ -0,0 +1,59 @@
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+
+#define TELEMETRY_MAGIC       0x4D4C5454u   // "TTLM" in little-endian
+#define TELEMETRY_VERSION     1u
+#define TELEMETRY_MAX_THREADS 16            // Threads that can record events
+#define TELEMETRY_RING_SIZE   4096          // Events buffered per thread
+
+// Kinds of telemetry events
+typedef enum {
+    TELEMETRY_TICK,                 // value: ExplorationStatus of the tick
+    TELEMETRY_MAP_POINT_CREATED,    // value: MapPoint id, x/y: its location
+    TELEMETRY_MAP_POINT_UPDATED,    // value: MapPoint id, x/y: its location
+    TELEMETRY_PLANNER_QUERY,        // value: route cost (-1 if none), value2: time in ns
+    TELEMETRY_PLANNER_TABLE,        // value: MapPoints in the table, value2: time in ns
+    TELEMETRY_DROPPED,              // value: events lost because a ring was full
+    TELEMETRY_TYPE_COUNT
+} TelemetryType;
+
+// Value of decision when the tick did not choose a move
+#define TELEMETRY_NO_DECISION 0xFF
+
+/**
+ * @struct TelemetryEvent
+ * @brief One recorded event. Timestamp, tick and thread are filled in by telemetry_record().
+ */
+typedef struct TelemetryEvent {
+    uint64_t timestamp;     /**< Monotonic time in ns */
+    uint32_t tick;
+    uint8_t type;           /**< TelemetryType */
+    uint8_t thread;         /**< Index of the recording thread */
+    uint8_t orientation;
+    uint8_t sensors;        /**< Bit 0: forward, bit 1: left, bit 2: right */
+    uint8_t decision;       /**< Move chosen in the tick, TELEMETRY_NO_DECISION if none */
+    int32_t x, y;
+    int32_t value;
+    int32_t value2;
+} TelemetryEvent;
+
+// True while a telemetry log is being written
+extern bool telemetry_enabled;
+
+// Recording side
+bool telemetry_start(const char *filename);
+void telemetry_stop();
+void telemetry_set_tick(uint32_t tick);
+void telemetry_record(TelemetryEvent event);
+uint64_t telemetry_now();
+
+// Log decoding
+const char *telemetry_type_name(uint8_t type);
+bool telemetry_decode_event(const unsigned char **data, const unsigned char *end,
+                            TelemetryEvent last[TELEMETRY_MAX_THREADS], TelemetryEvent *event);
+
+#endif // TELEMETRY_H
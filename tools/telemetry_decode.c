@@ -0,0 +1,84 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../telemetry.h"
+
+// ======================= TELEMETRY DECODER ======================= //
+//
+// Turns a binary telemetry log (see telemetry.h) into CSV:
+//
+//   telemetry_decode run.tlm > run.csv
+
+/**
+ * @brief Reads a whole file into memory.
+ *
+ * @param filename Path of the file.
+ * @param size Pointer to store the size in bytes in.
+ * @return unsigned char* The contents (caller must free memory), or NULL if unreadable.
+ */
+static unsigned char *read_file(const char *filename, size_t *size) {
+    FILE *file = fopen(filename, "rb");
+    if (!file) return NULL;
+
+    fseek(file, 0, SEEK_END);
+    long length = ftell(file);
+    fseek(file, 0, SEEK_SET);
+
+    unsigned char *data = length > 0 ? malloc((size_t) length) : NULL;
+    if (!data || fread(data, 1, (size_t) length, file) != (size_t) length) {
+        free(data);
+        fclose(file);
+        return NULL;
+    }
+    fclose(file);
+    *size = (size_t) length;
+    return data;
+}
+
+int main(int argc, char *argv[]) {
+    if (argc != 2) {
+        fprintf(stderr, "Usage: %s <telemetry log>\n", argv[0]);
+        return 1;
+    }
+
+    size_t size = 0;
+    unsigned char *data = read_file(argv[1], &size);
+    uint32_t header[2];
+    if (!data || size < sizeof(header)) {
+        fprintf(stderr, "Cannot read telemetry log: %s\n", argv[1]);
+        free(data);
+        return 1;
+    }
+
+    memcpy(header, data, sizeof(header));
+    if (header[0] != TELEMETRY_MAGIC || header[1] != TELEMETRY_VERSION) {
+        fprintf(stderr, "Not a version %u telemetry log: %s\n", TELEMETRY_VERSION, argv[1]);
+        free(data);
+        return 1;
+    }
+
+    printf("timestamp_ns,thread,tick,type,x,y,orientation,sensors,decision,value,value2\n");
+
+    TelemetryEvent last[TELEMETRY_MAX_THREADS] = {0};
+    TelemetryEvent event;
+    const unsigned char *in = data + sizeof(header);
+    const unsigned char *end = data + size;
+    while (telemetry_decode_event(&in, end, last, &event)) {
+        printf("%llu,%u,%u,%s,%d,%d,%u,%u,", (unsigned long long) event.timestamp, event.thread, event.tick,
+               telemetry_type_name(event.type), event.x, event.y, event.orientation, event.sensors);
+        if (event.decision == TELEMETRY_NO_DECISION) {
+            printf(",");
+        } else {
+            printf("%u,", event.decision);
+        }
+        printf("%d,%d\n", event.value, event.value2);
+    }
+
+    int status = 0;
+    if (in != end) {
+        fprintf(stderr, "Telemetry log is truncated or corrupt at byte %ld\n", (long) (in - data));
+        status = 1;
+    }
+    free(data);
+    return status;
+}
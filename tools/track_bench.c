@@ -0,0 +1,110 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "../track_files_PRIVATE/track_generation.h"
+#include "../ground_truth.h"
+
+// ======================= TRACK LAYOUT BENCHMARK ======================= //
+//
+// Sweeps a car over every cell of a large lattice track and probes the cell and its four
+// neighbours the way update_ultrasonic_sensors() does: along the rows, along the columns
+// and at random cells, then times the extraction of its reference graph (ground_truth.h).
+// Built twice, for the blocked layout and for TRACK_ROW_MAJOR:
+//
+//   track_bench 8192 && track_bench_row_major 8192
+
+#define LATTICE_SPACING 4  // Every fourth row and column is track
+
+/**
+ * @brief Gets the monotonic time.
+ *
+ * @return double Seconds.
+ */
+static double now_seconds() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double) ts.tv_sec + (double) ts.tv_nsec * 1e-9;
+}
+
+/**
+ * @brief Probes a cell and its four neighbours.
+ *
+ * @param x Column of the cell.
+ * @param y Row of the cell.
+ * @return int Number of the five cells the car can drive on.
+ */
+static int probe(int x, int y) {
+    return (track_cell(x, y) != EMPTY) + (track_cell(x, y - 1) != EMPTY) + (track_cell(x, y + 1) != EMPTY) +
+           (track_cell(x - 1, y) != EMPTY) + (track_cell(x + 1, y) != EMPTY);
+}
+
+/**
+ * @brief Probes every cell of the current track once, in one order, and prints the time per cell.
+ *
+ * @param label Name of the order.
+ * @param order 0 to walk along each row, 1 to walk down each column, 2 for random cells.
+ */
+static void sweep(const char *label, int order) {
+    int size = track_width();
+    uint64_t random = 88172645463325252ULL;
+    long hits = 0;
+    double begin = now_seconds();
+    for (int outer = 0; outer < size; outer++) {
+        for (int inner = 0; inner < size; inner++) {
+            if (order == 0) {
+                hits += probe(inner, outer);
+            } else if (order == 1) {
+                hits += probe(outer, inner);
+            } else {
+                // xorshift64, so the car lands on a cold part of the track every time
+                random ^= random << 13;
+                random ^= random >> 7;
+                random ^= random << 17;
+                hits += probe((int) (random % (uint64_t) size), (int) ((random >> 32) % (uint64_t) size));
+            }
+        }
+    }
+    double seconds = now_seconds() - begin;
+    printf("  %-16s %8.2f ns per cell (%ld drivable probes)\n", label, seconds * 1e9 / ((double) size * size), hits);
+}
+
+int main(int argc, char *argv[]) {
+    int size = argc > 1 ? atoi(argv[1]) : 4096;
+    if (argc > 2 || size < LATTICE_SPACING) {
+        fprintf(stderr, "Usage: %s [cells per side, default 4096]\n", argv[0]);
+        return 1;
+    }
+
+    current_track = track_create(size, size);
+    for (int y = 0; y < size; y++) {
+        for (int x = 0; x < size; x++) {
+            if (x % LATTICE_SPACING == 0 || y % LATTICE_SPACING == 0) track_set_cell(x, y, TRACK);
+        }
+    }
+
+#if defined(SPARSE_TRACK)
+    const char *layout = "sparse tiles";
+#elif defined(TRACK_ROW_MAJOR)
+    const char *layout = "row-major";
+#else
+    const char *layout = "8x8 blocks";
+#endif
+    printf("%dx%d track, %s, %zu bytes\n", size, size, layout, track_memory_bytes());
+    sweep("along rows", 0);
+    sweep("along columns", 1);
+    sweep("random cells", 2);
+
+    TrackBitmap bitmap;
+    track_bitmap_create(&bitmap);
+    GroundTruthGraph graph;
+    double begin = now_seconds();
+    ground_truth_extract(&bitmap, &graph);
+    double seconds = now_seconds() - begin;
+    printf("  ground truth     %8.2f ms for %d MapPoints and %d paths (%.0f M cells/s)\n", seconds * 1e3,
+           graph.num_nodes, graph.num_edges, (double) size * size / seconds * 1e-6);
+    ground_truth_free(&graph);
+    track_bitmap_free(&bitmap);
+
+    track_free(current_track);
+    return 0;
+}
@@ -0,0 +1,212 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include "tournament.h"
+#include "simulation.h"
+#include "policy.h"
+#include "scoreboard.h"
+#include "static_pools.h"
+
+// The exploration code works on the globals of globals.h, so the policies cannot share a
+// process: every policy is played in a forked child, which explores the tracks as
+// simulations (simulation.h) and sends its scores back through a pipe.
+
+#define TOURNAMENT_TICKS_PER_CELL 16  // A run still exploring after this many ticks per track cell is stopped
+
+/**
+ * @struct TournamentEntry
+ * @brief Result of one policy over the whole track set.
+ */
+typedef struct TournamentEntry {
+    const ExplorationPolicy *policy;
+    ScoreReport report;
+    unsigned long ticks;
+    int stopped;            /**< Runs stopped by the tick limit */
+    bool pools_exhausted;   /**< A static pool ran out (see static_pools.h), the scores are incomplete */
+    double elapsed_ms;
+} TournamentEntry;
+
+/**
+ * @brief Explores every track of the set with one policy and scores the runs.
+ *
+ * The tracks are explored one after another, so a static-pool build needs room for a
+ * single simulation only. Once a pool runs out the remaining tracks are skipped.
+ *
+ * @param entry Pointer to the entry to fill, its policy set.
+ * @param tracks Number of track variants to explore.
+ */
+static void play_policy(TournamentEntry *entry, int tracks) {
+    for (int track = 0; track < tracks; track++) {
+        Simulation sim;
+        Scoreboard scoreboard;
+        simulation_init(&sim, track);
+        sim.policy = entry->policy;
+        simulation_start_scoring(&sim, &scoreboard);
+
+        struct timespec begin, end;
+        clock_gettime(CLOCK_MONOTONIC, &begin);
+        unsigned long tick_limit = (unsigned long) (sim.track->on_track * TOURNAMENT_TICKS_PER_CELL);
+        while (exploration_step(&sim) != EXPLORATION_DONE) {
+            if (sim.exploration.ticks >= tick_limit) {
+                entry->stopped++;
+                break;
+            }
+        }
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        entry->elapsed_ms += (end.tv_sec - begin.tv_sec) * 1e3 + (end.tv_nsec - begin.tv_nsec) / 1e6;
+
+        ScoreReport report;
+        simulation_score(&sim, &report);
+        score_report_add(&entry->report, &report);
+        entry->ticks += sim.exploration.ticks;
+        scoreboard_free(&scoreboard);
+        simulation_free(&sim);
+        if (static_pools_exhausted()) {
+            entry->pools_exhausted = true;
+            return;
+        }
+    }
+}
+
+/**
+ * @brief Reads a whole entry from a pipe.
+ *
+ * @param fd Read end of the pipe.
+ * @param entry Pointer to the entry to fill.
+ * @return bool True if the whole entry arrived.
+ */
+static bool read_entry(int fd, TournamentEntry *entry) {
+    size_t received = 0;
+    while (received < sizeof(TournamentEntry)) {
+        ssize_t n = read(fd, (char *) entry + received, sizeof(TournamentEntry) - received);
+        if (n <= 0) return false;
+        received += (size_t) n;
+    }
+    return true;
+}
+
+/**
+ * @brief Ranks tournament entries with score_report_compare(), oracles after the explorers.
+ *
+ * @param a Pointer to a TournamentEntry.
+ * @param b Pointer to a TournamentEntry.
+ * @return int Negative if a ranks before b.
+ */
+static int compare_entries(const void *a, const void *b) {
+    bool oracle_a = ((const TournamentEntry *) a)->policy->oracle, oracle_b = ((const TournamentEntry *) b)->policy->oracle;
+    if (oracle_a != oracle_b) return oracle_a - oracle_b;
+    return score_report_compare(&((const TournamentEntry *) a)->report, &((const TournamentEntry *) b)->report);
+}
+
+/**
+ * @brief Plays every shipped policy on the same tracks in parallel and prints the ranking.
+ *
+ * Oracles, which read the track instead of exploring it, are listed below the ranking as a
+ * reference and left out of the score totals.
+ *
+ * @param tracks Number of variants of the loop track to explore, at most NUM_TRACK_VARIANTS.
+ * @param score_totals_file Path of a totals file to add the scores to, NULL for none.
+ * @return bool True if every policy finished without running out of a static pool and the
+ *              totals were written.
+ */
+bool run_tournament(int tracks, const char *score_totals_file) {
+    if (tracks < 1 || tracks > NUM_TRACK_VARIANTS) {
+        fprintf(stderr, "Error: a tournament needs 1 to %d tracks\n", NUM_TRACK_VARIANTS);
+        return false;
+    }
+
+    TournamentEntry entries[NUM_EXPLORATION_POLICIES];
+    pid_t children[NUM_EXPLORATION_POLICIES];
+    int pipes[NUM_EXPLORATION_POLICIES];
+    int started = 0;
+
+    // Nothing buffered may be printed twice by the children
+    fflush(stdout);
+    fflush(stderr);
+    for (int p = 0; p < NUM_EXPLORATION_POLICIES; p++) {
+        int fds[2];
+        if (pipe(fds) != 0) {
+            perror("Error: Failed to create a tournament pipe");
+            break;
+        }
+        pid_t child = fork();
+        if (child < 0) {
+            perror("Error: Failed to start a tournament player");
+            close(fds[0]);
+            close(fds[1]);
+            break;
+        }
+        if (child == 0) {
+            close(fds[0]);
+            TournamentEntry entry = {.policy = exploration_policies[p]};
+            play_policy(&entry, tracks);
+            bool sent = write(fds[1], &entry, sizeof(entry)) == (ssize_t) sizeof(entry);
+            _exit(sent ? EXIT_SUCCESS : EXIT_FAILURE);
+        }
+        close(fds[1]);
+        children[started] = child;
+        pipes[started] = fds[0];
+        started++;
+    }
+
+    // The policy pointers stay valid in the parent, the children are forks of it
+    bool complete = started == NUM_EXPLORATION_POLICIES;
+    int finished = 0;
+    for (int p = 0; p < started; p++) {
+        int status;
+        if (read_entry(pipes[p], &entries[finished])) finished++;
+        close(pipes[p]);
+        if (waitpid(children[p], &status, 0) < 0 || !WIFEXITED(status) || WEXITSTATUS(status) != EXIT_SUCCESS) {
+            complete = false;
+        }
+    }
+    if (finished < started) complete = false;
+
+    // A policy that ran out of a static pool did not explore every track, so it is not ranked
+    int kept = 0;
+    for (int i = 0; i < finished; i++) {
+        if (entries[i].pools_exhausted) {
+            fprintf(stderr, "Error: %s ran out of a static pool and is left out of the ranking\n",
+                    entries[i].policy->name);
+            complete = false;
+            continue;
+        }
+        entries[kept++] = entries[i];
+    }
+
+    qsort(entries, (size_t) kept, sizeof(TournamentEntry), compare_entries);
+    int ranked = 0;
+    while (ranked < kept && !entries[ranked].policy->oracle) ranked++;
+    printf("Tournament of %d policies on %d tracks:\n", ranked, tracks);
+    printf("  %-4s %-18s %10s %12s %10s %8s %8s %8s %10s\n", "rank", "policy", "lap ratio", "driven/cell", "MapPoints",
+           "no lap", "stopped", "ticks", "ms");
+    for (int i = 0; i < kept; i++) {
+        const ScoreReport *r = &entries[i].report;
+        if (i == ranked) printf("  Oracles, reading the track instead of exploring it (not ranked):\n");
+        char rank[8] = "-";
+        if (i < ranked) snprintf(rank, sizeof(rank), "%d", i + 1);
+        printf("  %-4s %-18s %10.3f %12.2f %9.1f%% %8lu %8d %8lu %10.3f\n", rank, entries[i].policy->name,
+               r->optimal_lap > 0 ? (double) r->lap / r->optimal_lap : 0.0,
+               r->track_cells > 0 ? (double) r->cells_driven / r->track_cells : 0.0,
+               r->nodes > 0 ? 100.0 * r->nodes_found / r->nodes : 0.0, r->laps_missing, entries[i].stopped,
+               entries[i].ticks, entries[i].elapsed_ms);
+    }
+    if (ranked > 0) printf("Fastest policy: %s\n", entries[0].policy->name);
+    if (finished < NUM_EXPLORATION_POLICIES) {
+        fprintf(stderr, "Error: %d of %d policies did not finish\n", NUM_EXPLORATION_POLICIES - finished,
+                NUM_EXPLORATION_POLICIES);
+    }
+
+    if (score_totals_file && ranked > 0) {
+        const char *names[NUM_EXPLORATION_POLICIES];
+        ScoreReport reports[NUM_EXPLORATION_POLICIES];
+        for (int i = 0; i < ranked; i++) {
+            names[i] = entries[i].policy->name;
+            reports[i] = entries[i].report;
+        }
+        if (!score_totals_merge(score_totals_file, names, reports, ranked)) return false;
+    }
+    return complete;
+}
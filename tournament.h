@@ -0,0 +1,15 @@
+#ifndef TOURNAMENT_H
+#define TOURNAMENT_H
+
+#include <stdbool.h>
+
+// ======================= TOURNAMENT ======================= //
+//
+// Every shipped exploration policy (policy.h) explores the same set of tracks, the variants
+// of the loop track, and the policies are ranked by their scores (scoreboard.h).
+
+// Play all policies against each other in parallel and print the ranking, adding the scores
+// to a totals file if given
+bool run_tournament(int tracks, const char *score_totals_file);
+
+#endif // TOURNAMENT_H
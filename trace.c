@@ -0,0 +1,188 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include "trace.h"
+#include "telemetry.h"
+
+// ======================= TRACE ======================= //
+//
+// Writes spans as Chrome trace-event JSON ("X" events), which chrome://tracing and Perfetto
+// open directly. Every thread gets its own track and its own span buffer; a span is only
+// copied into the buffer, the JSON is formatted once the buffer is full or the trace stops.
+
+#define TRACE_FILE_BUFFER (1 << 20)     // stdio buffer of the trace file
+
+/**
+ * @struct TraceSpan
+ * @brief One buffered span. Names are string literals and are not copied.
+ */
+typedef struct TraceSpan {
+    const char *name;
+    const char *arg_name;   /**< NULL if the span has no argument */
+    uint64_t start, end;    /**< Monotonic time in ns */
+    int64_t arg;
+} TraceSpan;
+
+/**
+ * @struct TraceThread
+ * @brief Track and span buffer of one recording thread.
+ */
+typedef struct TraceThread {
+    const char *name;       /**< NULL until the thread names itself */
+    TraceSpan *spans;
+    int count;
+} TraceThread;
+
+bool trace_enabled = false;
+
+static TraceThread threads[TRACE_MAX_THREADS];
+static atomic_uint thread_count = 0;
+static pthread_mutex_t trace_lock = PTHREAD_MUTEX_INITIALIZER;  // Guards registration and the file
+
+static _Thread_local TraceThread *local_thread = NULL;
+static _Thread_local unsigned local_index = 0;
+
+static FILE *trace_file = NULL;
+static char *file_buffer = NULL;
+static uint64_t trace_origin = 0;
+static bool first_event = true;
+static unsigned long spans_written = 0;
+
+/**
+ * @brief Gives the calling thread its own track on first use.
+ *
+ * @return TraceThread* The track of the thread, or NULL if all tracks are taken.
+ */
+static TraceThread *register_thread() {
+    pthread_mutex_lock(&trace_lock);
+    unsigned index = atomic_load(&thread_count);
+    if (index < TRACE_MAX_THREADS) {
+        threads[index].name = NULL;
+        threads[index].count = 0;
+        threads[index].spans = malloc(TRACE_BUFFER_SPANS * sizeof(TraceSpan));
+        if (!threads[index].spans) {
+            perror("Error: Failed to allocate trace buffer");
+            exit(EXIT_FAILURE);
+        }
+        local_thread = &threads[index];
+        local_index = index;
+        atomic_store(&thread_count, index + 1);
+    }
+    pthread_mutex_unlock(&trace_lock);
+    return local_thread;
+}
+
+/**
+ * @brief Writes the buffered spans of a thread to the trace file. The caller holds trace_lock.
+ *
+ * @param thread Pointer to the thread.
+ * @param tid Track of the thread.
+ */
+static void write_spans(TraceThread *thread, unsigned tid) {
+    for (int i = 0; i < thread->count; i++) {
+        const TraceSpan *span = &thread->spans[i];
+        fprintf(trace_file, "%s\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f",
+                first_event ? "" : ",", span->name, tid,
+                (double) (span->start - trace_origin) / 1000.0, (double) (span->end - span->start) / 1000.0);
+        if (span->arg_name) {
+            fprintf(trace_file, ",\"args\":{\"%s\":%lld}", span->arg_name, (long long) span->arg);
+        }
+        fputc('}', trace_file);
+        first_event = false;
+    }
+    spans_written += (unsigned long) thread->count;
+    thread->count = 0;
+}
+
+/**
+ * @brief Names the track of the calling thread.
+ *
+ * @param name Name shown for the track, a string literal.
+ */
+void trace_name_thread(const char *name) {
+    if (!trace_enabled) return;
+
+    TraceThread *thread = local_thread ? local_thread : register_thread();
+    if (thread) thread->name = name;
+}
+
+/**
+ * @brief Records a finished span on the track of the calling thread.
+ *
+ * @param name Name of the span, a string literal.
+ * @param start_ns Start in ns of the telemetry_now() clock.
+ * @param end_ns End in ns of the same clock.
+ * @param arg_name Name of the argument shown with the span, NULL for none.
+ * @param arg Value of the argument.
+ */
+void trace_span(const char *name, uint64_t start_ns, uint64_t end_ns, const char *arg_name, int64_t arg) {
+    if (!trace_enabled) return;
+
+    TraceThread *thread = local_thread ? local_thread : register_thread();
+    if (!thread) return;
+
+    if (thread->count == TRACE_BUFFER_SPANS) {
+        pthread_mutex_lock(&trace_lock);
+        write_spans(thread, local_index);
+        pthread_mutex_unlock(&trace_lock);
+    }
+    thread->spans[thread->count++] = (TraceSpan) {name, arg_name, start_ns, end_ns, arg};
+}
+
+/**
+ * @brief Opens a trace file. The calling thread becomes the "control loop" track.
+ *
+ * @param filename Path of the trace file.
+ * @return bool True if the trace is recording, false otherwise.
+ */
+bool trace_start(const char *filename) {
+    if (trace_enabled || !filename) return false;
+
+    trace_file = fopen(filename, "w");
+    if (!trace_file) {
+        perror("Error: Failed to open trace file");
+        return false;
+    }
+    file_buffer = malloc(TRACE_FILE_BUFFER);
+    if (file_buffer) setvbuf(trace_file, file_buffer, _IOFBF, TRACE_FILE_BUFFER);
+
+    fputs("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[", trace_file);
+    first_event = true;
+    spans_written = 0;
+    trace_origin = telemetry_now();
+    trace_enabled = true;
+    trace_name_thread("control loop");
+    return true;
+}
+
+/**
+ * @brief Writes the remaining spans and the track names, then closes the trace.
+ *
+ * Must be called once the recording threads are done.
+ */
+void trace_stop() {
+    if (!trace_enabled) return;
+    trace_enabled = false;
+
+    pthread_mutex_lock(&trace_lock);
+    unsigned count = atomic_load(&thread_count);
+    for (unsigned i = 0; i < count; i++) {
+        write_spans(&threads[i], i);
+        fprintf(trace_file, "%s\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,"
+                            "\"args\":{\"name\":\"%s\"}}",
+                first_event ? "" : ",", i, threads[i].name ? threads[i].name : "thread");
+        first_event = false;
+        free(threads[i].spans);
+        threads[i].spans = NULL;
+    }
+    atomic_store(&thread_count, 0);
+    pthread_mutex_unlock(&trace_lock);
+
+    fputs("\n]}\n", trace_file);
+    fclose(trace_file);
+    free(file_buffer);
+    trace_file = NULL;
+    file_buffer = NULL;
+    printf("Trace: %lu spans written\n", spans_written);
+}
@@ -0,0 +1,18 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define TRACE_MAX_THREADS   16      // Threads that can record spans
+#define TRACE_BUFFER_SPANS  1024    // Spans buffered per thread before they are written
+
+// True while a trace is being written
+extern bool trace_enabled;
+
+bool trace_start(const char *filename);
+void trace_stop();
+void trace_name_thread(const char *name);
+void trace_span(const char *name, uint64_t start_ns, uint64_t end_ns, const char *arg_name, int64_t arg);
+
+#endif // TRACE_H
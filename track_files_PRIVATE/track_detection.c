@@ -4,14 +4,30 @@
 
 #include "../direction.h"
 #include "track_navigation.h"
+#include "../instrumentation.h"
+#include "../noise.h"
+#include "../occupancy.h"
+
+/**
+ * @brief Checks if the car can drive on a cell.
+ *
+ * @param x Column of the cell.
+ * @param y Row of the cell.
+ * @return bool True for TRACK and START_FINISH cells.
+ */
+static bool is_track(int x, int y) {
+    char cell = track_cell(x, y);
+    return cell == TRACK || cell == START_FINISH;
+}
 
 /**
  * @brief Updates the ultrasonic sensor readings based on the car's current location and orientation.
  *
- * This function checks the grid surrounding the car and updates the `ultrasonic_sensors` array
+ * This function checks the track cells surrounding the car and updates the `ultrasonic_sensors` array
  * to indicate whether movement is possible in the forward, left, and right directions.
  */
 void update_ultrasonic_sensors() {
+    INSTRUMENT_FUNCTION(COUNTER_UPDATE_ULTRASONIC_SENSORS);
     int x = current_car.current_location.x;
     int y = current_car.current_location.y;
 
@@ -23,38 +39,38 @@ void update_ultrasonic_sensors() {
     // Determine sensor positions based on the car's current orientation
     switch (current_car.current_orientation) {
         case NORTH:
-            if (y > 0 && (grid[y - 1][x] != TRACK && grid[y - 1][x] != START_FINISH))
+            if (y > 0 && !is_track(x, y - 1))
                 ultrasonic_sensors[0] = false;  // Forward
-            if (x > 0 && (grid[y][x - 1] != TRACK && grid[y][x - 1] != START_FINISH))
+            if (x > 0 && !is_track(x - 1, y))
                 ultrasonic_sensors[1] = false;  // Left
-            if (x < GRID_SIZE - 1 && (grid[y][x + 1] != TRACK && grid[y][x + 1] != START_FINISH))
+            if (x < track_width() - 1 && !is_track(x + 1, y))
                 ultrasonic_sensors[2] = false;  // Right
             break;
 
         case SOUTH:
-            if (y < GRID_SIZE - 1 && (grid[y + 1][x] != TRACK && grid[y + 1][x] != START_FINISH))
+            if (y < track_height() - 1 && !is_track(x, y + 1))
                 ultrasonic_sensors[0] = false;
-            if (x < GRID_SIZE - 1 && (grid[y][x + 1] != TRACK && grid[y][x + 1] != START_FINISH))
+            if (x < track_width() - 1 && !is_track(x + 1, y))
                 ultrasonic_sensors[1] = false;
-            if (x > 0 && (grid[y][x - 1] != TRACK && grid[y][x - 1] != START_FINISH))
+            if (x > 0 && !is_track(x - 1, y))
                 ultrasonic_sensors[2] = false;
             break;
 
         case WEST:
-            if (x > 0 && (grid[y][x - 1] != TRACK && grid[y][x - 1] != START_FINISH))
+            if (x > 0 && !is_track(x - 1, y))
                 ultrasonic_sensors[0] = false;
-            if (y < GRID_SIZE - 1 && (grid[y + 1][x] != TRACK && grid[y + 1][x] != START_FINISH))
+            if (y < track_height() - 1 && !is_track(x, y + 1))
                 ultrasonic_sensors[1] = false;
-            if (y > 0 && (grid[y - 1][x] != TRACK && grid[y - 1][x] != START_FINISH))
+            if (y > 0 && !is_track(x, y - 1))
                 ultrasonic_sensors[2] = false;
             break;
 
         case EAST:
-            if (x < GRID_SIZE - 1 && (grid[y][x + 1] != TRACK && grid[y][x + 1] != START_FINISH))
+            if (x < track_width() - 1 && !is_track(x + 1, y))
                 ultrasonic_sensors[0] = false;
-            if (y > 0 && (grid[y - 1][x] != TRACK && grid[y - 1][x] != START_FINISH))
+            if (y > 0 && !is_track(x, y - 1))
                 ultrasonic_sensors[1] = false;
-            if (y < GRID_SIZE - 1 && (grid[y + 1][x] != TRACK && grid[y + 1][x] != START_FINISH))
+            if (y < track_height() - 1 && !is_track(x, y + 1))
                 ultrasonic_sensors[2] = false;
             break;
 
@@ -64,6 +80,55 @@ void update_ultrasonic_sensors() {
             ultrasonic_sensors[0] = false;
             ultrasonic_sensors[1] = false;
             ultrasonic_sensors[2] = false;
-            break;
+            return;
     }
+
+    // Real sensors measure a noisy range (see noise.h), which the occupancy grid can fuse (see occupancy.h)
+    if (noise_enabled || occupancy_mode != OCCUPANCY_OFF) {
+        int ranges[3];
+        measure_ultrasonic_ranges(ranges);
+        if (noise_enabled) noise_apply_ranges(ranges);
+        for (int i = 0; i < 3; i++) ultrasonic_sensors[i] = ranges[i] > 0;
+        if (occupancy_mode != OCCUPANCY_OFF) {
+            occupancy_sense(ultrasonic_sensors, x, y, current_car.current_orientation, ranges);
+        }
+    }
+}
+
+/**
+ * @brief Counts the free cells in one direction, as far as a sensor measures.
+ *
+ * Beyond the edge of the grid counts as free, as for the sensor readings.
+ *
+ * @param x Column of the car.
+ * @param y Row of the car.
+ * @param direction Direction the sensor points to.
+ * @return int Free cells, at most ULTRASONIC_RANGE_CELLS.
+ */
+static int free_range(int x, int y, Direction direction) {
+    static const int dx[4] = {0, 1, 0, -1};
+    static const int dy[4] = {-1, 0, 1, 0};
+    for (int range = 0; range < ULTRASONIC_RANGE_CELLS; range++) {
+        x += dx[direction];
+        y += dy[direction];
+        if (x < 0 || y < 0 || x >= track_width() || y >= track_height()) return ULTRASONIC_RANGE_CELLS;
+        if (!is_track(x, y)) return range;
+    }
+    return ULTRASONIC_RANGE_CELLS;
+}
+
+/**
+ * @brief Measures the free cells in front of the sensors; a sensor reads a free path if its
+ *        range is not 0.
+ *
+ * @param ranges Free cells in front of the {forward, left, right} sensors.
+ */
+void measure_ultrasonic_ranges(int ranges[3]) {
+    int x = current_car.current_location.x;
+    int y = current_car.current_location.y;
+    Direction forward = (Direction) current_car.current_orientation;
+
+    ranges[0] = free_range(x, y, forward);
+    ranges[1] = free_range(x, y, turn_left(forward));
+    ranges[2] = free_range(x, y, turn_right(forward));
 }
@@ -3,7 +3,12 @@
 
 #include "../globals.h"
 
+#define ULTRASONIC_RANGE_CELLS 8    // Farthest free cells a sensor measures
+
 // Function to update ultrasonic sensor readings
 void update_ultrasonic_sensors();
 
+// Free cells in front of the forward, left and right sensors
+void measure_ultrasonic_ranges(int ranges[3]);
+
 #endif // TRACK_DETECTION_H
@@ -1,61 +1,105 @@
 #include "track_generation.h"
 
 /**
- * @brief Global 2D grid representing the track layout.
+ * @brief Initializes the grid by making a new GRID_SIZE x GRID_SIZE track of EMPTY cells current.
+ *
+ * This function is typically called before generating a track
+ * to ensure a clean starting state. The previous track stays with
+ * its owner, e.g. a Simulation.
  *
  * Each cell stores a character representing track elements:
  * - '#' = Track
  * - 'S' = Start/Finish line
  * - '.' = Empty space
  */
-char grid[GRID_SIZE][GRID_SIZE];
-
-/**
- * @brief Initializes the grid by setting all cells to EMPTY.
- *
- * This function is typically called before generating a track
- * to ensure a clean starting state.
- */
 void initialize_grid() {
-    for (int i = 0; i < GRID_SIZE; i++) {
-        for (int j = 0; j < GRID_SIZE; j++) {
-            grid[i][j] = EMPTY; // Default to empty space
-        }
-    }
+    current_track = track_create(GRID_SIZE, GRID_SIZE);
 }
 
+// Predefined track layout (loop track)
+static const char loop_track[GRID_SIZE][GRID_SIZE] = {
+    {'.', '.', '.', '.', '.', '.', '.', '.', '.', '.', '.', '.', '.'},
+    {'.', '.', 'S', '#', '#', '#', '#', '#', '#', '.', '.', '.', '.'},
+    {'.', '.', '#', '.', '.', '#', '.', '.', '#', '.', '.', '.', '.'},
+    {'.', '.', '#', '.', '.', '#', '#', '#', '#', '.', '.', '.', '.'},
+    {'.', '.', '#', '.', '.', '.', '.', '.', '#', '.', '.', '.', '.'},
+    {'.', '.', '#', '#', '#', '#', '.', '.', '#', '#', '#', '#', '.'},
+    {'.', '.', '#', '.', '.', '#', '.', '.', '.', '#', '.', '#', '.'},
+    {'.', '.', '#', '#', '#', '#', '#', '#', '#', '#', '.', '#', '.'},
+    {'.', '.', '.', '.', '.', '#', '.', '.', '.', '#', '.', '#', '.'},
+    {'.', '.', '.', '.', '#', '#', '#', '#', '#', '#', '#', '#', '.'},
+    {'.', '.', '.', '.', '#', '.', '.', '.', '.', '.', '#', '.', '.'},
+    {'.', '.', '.', '.', '#', '#', '#', '#', '#', '#', '#', '.', '.'},
+    {'.', '.', '.', '.', '.', '.', '.', '.', '.', '.', '.', '.', '.'},
+};
+
 /**
  * @brief Generates a predefined closed-loop track.
  *
  * This function creates a **one-block-wide** closed-loop track
- * by copying a predefined layout into the global grid.
+ * by copying a predefined layout into the current track.
  *
  * - 'S' marks the **start/finish** line.
  * - '#' represents **track paths**.
  * - '.' represents **empty space**.
  */
 void create_loop_track() {
-    // Predefined track layout (loop track)
-    char complex_grid[GRID_SIZE][GRID_SIZE] = {
-        {'.', '.', '.', '.', '.', '.', '.', '.', '.', '.', '.', '.', '.'},
-        {'.', '.', 'S', '#', '#', '#', '#', '#', '#', '.', '.', '.', '.'},
-        {'.', '.', '#', '.', '.', '#', '.', '.', '#', '.', '.', '.', '.'},
-        {'.', '.', '#', '.', '.', '#', '#', '#', '#', '.', '.', '.', '.'},
-        {'.', '.', '#', '.', '.', '.', '.', '.', '#', '.', '.', '.', '.'},
-        {'.', '.', '#', '#', '#', '#', '.', '.', '#', '#', '#', '#', '.'},
-        {'.', '.', '#', '.', '.', '#', '.', '.', '.', '#', '.', '#', '.'},
-        {'.', '.', '#', '#', '#', '#', '#', '#', '#', '#', '.', '#', '.'},
-        {'.', '.', '.', '.', '.', '#', '.', '.', '.', '#', '.', '#', '.'},
-        {'.', '.', '.', '.', '#', '#', '#', '#', '#', '#', '#', '#', '.'},
-        {'.', '.', '.', '.', '#', '.', '.', '.', '.', '.', '#', '.', '.'},
-        {'.', '.', '.', '.', '#', '#', '#', '#', '#', '#', '#', '.', '.'},
-        {'.', '.', '.', '.', '.', '.', '.', '.', '.', '.', '.', '.', '.'},
-    };
+    create_track_variant(0);
+}
 
-    // Copy predefined track layout into the global grid
+/**
+ * @brief Maps a cell of the loop track to its place in a variant.
+ *
+ * @param variant Variant number: bit 2 transposes, bit 0 mirrors the columns, bit 1 the rows.
+ * @param location Cell in the loop track.
+ * @return Location Cell in the variant.
+ */
+static Location variant_location(int variant, Location location) {
+    if (variant & 4) location = (Location) {location.y, location.x};
+    if (variant & 1) location.x = GRID_SIZE - 1 - location.x;
+    if (variant & 2) location.y = GRID_SIZE - 1 - location.y;
+    return location;
+}
+
+/**
+ * @brief Maps a direction in the loop track to the same direction in a variant.
+ *
+ * @param variant Variant number (see variant_location()).
+ * @param direction Direction in the loop track.
+ * @return Direction Direction in the variant.
+ */
+static Direction variant_direction(int variant, Direction direction) {
+    int dx = direction == EAST ? 1 : direction == WEST ? -1 : 0;
+    int dy = direction == SOUTH ? 1 : direction == NORTH ? -1 : 0;
+    if (variant & 4) {
+        int swap = dx;
+        dx = dy;
+        dy = swap;
+    }
+    if (variant & 1) dx = -dx;
+    if (variant & 2) dy = -dy;
+    if (dx != 0) return dx > 0 ? EAST : WEST;
+    return dy > 0 ? SOUTH : NORTH;
+}
+
+/**
+ * @brief Generates one of the mirrored and rotated copies of the loop track.
+ *
+ * The NUM_TRACK_VARIANTS symmetries of the square give a small set of tracks that share
+ * one reference graph shape but turn the other way at every junction, so move choices
+ * that favour one side are measured fairly. The car is moved to the start of the variant
+ * from the start position of the loop track; variant 0 is the loop track itself.
+ *
+ * @param variant Variant number, 0 to NUM_TRACK_VARIANTS - 1.
+ */
+void create_track_variant(int variant) {
     for (int i = 0; i < GRID_SIZE; i++) {
         for (int j = 0; j < GRID_SIZE; j++) {
-            grid[i][j] = complex_grid[i][j];
+            Location cell = variant_location(variant, (Location) {j, i});
+            track_set_cell(cell.x, cell.y, loop_track[i][j]);
         }
     }
+
+    current_car.current_location = variant_location(variant, current_car.current_location);
+    current_car.current_orientation = (char) variant_direction(variant, (Direction) current_car.current_orientation);
 }
@@ -2,6 +2,7 @@
 #define TRACK_GENERATION_H
 
 #include "../globals.h"
+#include "track_grid.h"
 
 #define GRID_SIZE  13 // 13x13 grid
 
@@ -10,12 +11,13 @@
 #define TRACK '#'
 #define START_FINISH 'S'
 
+// Mirrored and rotated copies of the loop track (see create_track_variant())
+#define NUM_TRACK_VARIANTS 8
 
-// Global grid, accessible by all files
-extern char grid[GRID_SIZE][GRID_SIZE];
 
 // Function declarations
 void initialize_grid();
 void create_loop_track();
+void create_track_variant(int variant);
 
 #endif // TRACK_GENERATION_H
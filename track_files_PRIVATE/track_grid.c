@@ -0,0 +1,393 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "track_grid.h"
+#include "track_generation.h"
+#ifdef STATIC_POOLS
+#include "../static_pools.h"
+#endif
+#ifdef COMPACT_MAP
+#include "../algorithm_structs_PUBLIC/MapPoint.h"
+#endif
+
+/**
+ * @brief Track the car drives on.
+ *
+ * Simulations keep their own track and swap it in while they are stepped.
+ */
+TrackGrid *current_track = NULL;
+
+#ifdef STATIC_POOLS
+/**
+ * @struct TrackBlock
+ * @brief A track of at most GRID_SIZE x GRID_SIZE cells in one static block.
+ */
+typedef struct TrackBlock {
+    TrackGrid track;
+    char cells[(GRID_SIZE + TRACK_BLOCK_SIZE) * (GRID_SIZE + TRACK_BLOCK_SIZE)];  // Partial blocks are padded
+} TrackBlock;
+
+STATIC_POOL_DEFINE(track_pool, "tracks (POOL_MAP_SETS)", TrackBlock, POOL_MAP_SETS)
+
+// Handed out once the pool ran dry, so the caller can finish initializing before exploration stops
+static TrackBlock overflow_block;
+#endif
+
+// ======================= CELL LAYOUT ======================= //
+
+/**
+ * @brief Computes where a cell is stored: its 8 x 8 block, then row-major inside the block.
+ *
+ * A block of a dense track is one 64-byte cache line, so the neighbours a sensor probes
+ * share the line of the car's cell unless the car is on the edge of the block.
+ *
+ * @param x Column of the cell.
+ * @param y Row of the cell.
+ * @param blocks_per_row Number of blocks in a row of blocks.
+ * @return size_t Index of the cell.
+ */
+static inline size_t blocked_index(size_t x, size_t y, size_t blocks_per_row) {
+    size_t block = (y >> TRACK_BLOCK_SHIFT) * blocks_per_row + (x >> TRACK_BLOCK_SHIFT);
+    return (block << (2 * TRACK_BLOCK_SHIFT)) | ((y & (TRACK_BLOCK_SIZE - 1)) << TRACK_BLOCK_SHIFT) |
+           (x & (TRACK_BLOCK_SIZE - 1));
+}
+
+/**
+ * @brief Computes the number of blocks needed to cover a number of cells.
+ *
+ * @param cells Number of cells along one axis.
+ * @return size_t Number of 8-cell blocks, the last one possibly partial.
+ */
+static inline size_t blocks_covering(int cells) {
+    return ((size_t) cells + TRACK_BLOCK_SIZE - 1) >> TRACK_BLOCK_SHIFT;
+}
+
+#ifndef SPARSE_TRACK
+/**
+ * @brief Computes the number of cells a dense track stores, padding of partial blocks included.
+ *
+ * @param width Number of columns.
+ * @param height Number of rows.
+ * @return size_t Number of cells to allocate.
+ */
+static size_t dense_cell_count(int width, int height) {
+#ifdef TRACK_ROW_MAJOR
+    return (size_t) width * height;
+#else
+    return blocks_covering(width) * blocks_covering(height) * TRACK_BLOCK_SIZE * TRACK_BLOCK_SIZE;
+#endif
+}
+
+/**
+ * @brief Computes where a cell of a dense track is stored.
+ *
+ * @param track Pointer to the track.
+ * @param x Column of the cell.
+ * @param y Row of the cell.
+ * @return size_t Index into the cells of the track.
+ */
+static inline size_t dense_index(const TrackGrid *track, int x, int y) {
+#ifdef TRACK_ROW_MAJOR
+    return (size_t) y * track->width + x;
+#else
+    return blocked_index((size_t) x, (size_t) y, blocks_covering(track->width));
+#endif
+}
+#endif
+
+// ======================= SPARSE TILES ======================= //
+
+#ifdef SPARSE_TRACK
+// Two-bit codes of the symbols in a tile; any other symbol is stored as EMPTY
+enum { CODE_EMPTY, CODE_TRACK, CODE_START_FINISH };
+
+/**
+ * @brief Computes the table slot a tile is searched from.
+ *
+ * @param tile_x Column of the tile.
+ * @param tile_y Row of the tile.
+ * @param capacity Capacity of the table, a power of two.
+ * @return size_t Index of the first slot to probe.
+ */
+static size_t tile_slot(uint32_t tile_x, uint32_t tile_y, size_t capacity) {
+    uint64_t key = ((uint64_t) tile_y << 32) | tile_x;
+    return (size_t) ((key * 0x9E3779B97F4A7C15ULL) >> 32) & (capacity - 1);
+}
+
+/**
+ * @brief Finds the tile holding a cell.
+ *
+ * @param track Pointer to the track.
+ * @param x Column of the cell.
+ * @param y Row of the cell.
+ * @return TrackTile* The tile, or NULL if no cell of it was ever set to a track symbol.
+ */
+static TrackTile *find_tile(const TrackGrid *track, int x, int y) {
+    uint32_t tile_x = (uint32_t) x >> TRACK_TILE_SHIFT;
+    uint32_t tile_y = (uint32_t) y >> TRACK_TILE_SHIFT;
+    for (size_t i = tile_slot(tile_x, tile_y, track->tile_capacity);; i = (i + 1) & (track->tile_capacity - 1)) {
+        TrackTile *tile = track->tiles[i];
+        if (!tile || (tile->tile_x == tile_x && tile->tile_y == tile_y)) return tile;
+    }
+}
+
+/**
+ * @brief Doubles the tile table and rehashes its tiles.
+ *
+ * @param track Pointer to the track.
+ */
+static void grow_tiles(TrackGrid *track) {
+    size_t capacity = track->tile_capacity * 2;
+    TrackTile **tiles = calloc(capacity, sizeof(TrackTile *));
+    if (!tiles) {
+        perror("Error: Failed to allocate track tiles");
+        exit(EXIT_FAILURE);
+    }
+    for (size_t i = 0; i < track->tile_capacity; i++) {
+        TrackTile *tile = track->tiles[i];
+        if (!tile) continue;
+        size_t slot = tile_slot(tile->tile_x, tile->tile_y, capacity);
+        while (tiles[slot]) slot = (slot + 1) & (capacity - 1);
+        tiles[slot] = tile;
+    }
+    free(track->tiles);
+    track->tiles = tiles;
+    track->tile_capacity = capacity;
+}
+
+/**
+ * @brief Finds the tile holding a cell and creates it if it does not exist yet.
+ *
+ * @param track Pointer to the track.
+ * @param x Column of the cell.
+ * @param y Row of the cell.
+ * @return TrackTile* The tile, all cells EMPTY if it is new.
+ */
+static TrackTile *insert_tile(TrackGrid *track, int x, int y) {
+    TrackTile *tile = find_tile(track, x, y);
+    if (tile) return tile;
+
+    // Keep the table at most half full so probes stay short
+    if ((track->tile_count + 1) * 2 > track->tile_capacity) grow_tiles(track);
+
+    tile = calloc(1, sizeof(TrackTile));
+    if (!tile) {
+        perror("Error: Failed to allocate track tile");
+        exit(EXIT_FAILURE);
+    }
+    tile->tile_x = (uint32_t) x >> TRACK_TILE_SHIFT;
+    tile->tile_y = (uint32_t) y >> TRACK_TILE_SHIFT;
+
+    size_t slot = tile_slot(tile->tile_x, tile->tile_y, track->tile_capacity);
+    while (track->tiles[slot]) slot = (slot + 1) & (track->tile_capacity - 1);
+    track->tiles[slot] = tile;
+    track->tile_count++;
+    return tile;
+}
+#endif
+
+// ======================= TRACK API ======================= //
+
+/**
+ * @brief Creates a track with every cell EMPTY.
+ *
+ * @param width Number of columns.
+ * @param height Number of rows.
+ * @return TrackGrid* The track, released with track_free(). With STATIC_POOLS, a shared
+ *         overflow track once the pool is exhausted (see static_pools_fail()).
+ */
+TrackGrid *track_create(int width, int height) {
+#ifdef COMPACT_MAP
+    if (width > MP_MAX_GRID_SIDE || height > MP_MAX_GRID_SIDE) {
+        fprintf(stderr, "Error: A %dx%d track has more than %d cells per side, the most COMPACT_MAP can address\n",
+                width, height, MP_MAX_GRID_SIDE);
+        exit(EXIT_FAILURE);
+    }
+#endif
+#ifdef STATIC_POOLS
+    if (dense_cell_count(width, height) > sizeof(((TrackBlock *) NULL)->cells)) {
+        fprintf(stderr, "Error: A %dx%d track does not fit a static track block\n", width, height);
+        exit(EXIT_FAILURE);
+    }
+    TrackBlock *block = static_pool_take(&track_pool);
+    if (!block) block = &overflow_block;
+    TrackGrid *track = &block->track;
+    track->cells = block->cells;
+#else
+    TrackGrid *track = malloc(sizeof(TrackGrid));
+    if (!track) {
+        perror("Error: Failed to allocate track");
+        exit(EXIT_FAILURE);
+    }
+#ifdef SPARSE_TRACK
+    track->tile_capacity = 16;
+    track->tile_count = 0;
+    track->tiles = calloc(track->tile_capacity, sizeof(TrackTile *));
+    if (!track->tiles) {
+        perror("Error: Failed to allocate track tiles");
+        exit(EXIT_FAILURE);
+    }
+#else
+    track->cells = malloc(dense_cell_count(width, height));
+    if (!track->cells) {
+        perror("Error: Failed to allocate track cells");
+        exit(EXIT_FAILURE);
+    }
+#endif
+#endif
+
+#ifndef SPARSE_TRACK
+    memset(track->cells, EMPTY, dense_cell_count(width, height));
+#endif
+    track->width = width;
+    track->height = height;
+    track->on_track = 0;
+    track->hash_valid = false;
+    return track;
+}
+
+/**
+ * @brief Frees a track.
+ *
+ * @param track Pointer to the track, may be NULL.
+ */
+void track_free(TrackGrid *track) {
+    if (!track) return;
+
+#ifdef STATIC_POOLS
+    if (track != &overflow_block.track) static_pool_give(&track_pool, track);
+#else
+#ifdef SPARSE_TRACK
+    for (size_t i = 0; i < track->tile_capacity; i++) free(track->tiles[i]);
+    free(track->tiles);
+#else
+    free(track->cells);
+#endif
+    free(track);
+#endif
+}
+
+/**
+ * @brief Reads a cell of the current track.
+ *
+ * @param x Column of the cell.
+ * @param y Row of the cell.
+ * @return char EMPTY, TRACK or START_FINISH; EMPTY outside of the track.
+ */
+char track_cell(int x, int y) {
+    const TrackGrid *track = current_track;
+    if (x < 0 || y < 0 || x >= track->width || y >= track->height) return EMPTY;
+
+#ifdef SPARSE_TRACK
+    const TrackTile *tile = find_tile(track, x, y);
+    if (!tile) return EMPTY;
+    size_t index = blocked_index(x & (TRACK_TILE_SIZE - 1), y & (TRACK_TILE_SIZE - 1), TRACK_TILE_SIZE / TRACK_BLOCK_SIZE);
+    switch ((tile->cells[index >> 2] >> ((index & 3) * 2)) & 3) {
+        case CODE_TRACK:
+            return TRACK;
+        case CODE_START_FINISH:
+            return START_FINISH;
+        default:
+            return EMPTY;
+    }
+#else
+    return track->cells[dense_index(track, x, y)];
+#endif
+}
+
+/**
+ * @brief Writes a cell of the current track. Cells outside of the track are ignored.
+ *
+ * @param x Column of the cell.
+ * @param y Row of the cell.
+ * @param symbol EMPTY, TRACK or START_FINISH.
+ */
+void track_set_cell(int x, int y, char symbol) {
+    TrackGrid *track = current_track;
+    if (x < 0 || y < 0 || x >= track->width || y >= track->height) return;
+
+    char previous = track_cell(x, y);
+    if (previous == symbol) return;
+
+#ifdef SPARSE_TRACK
+    // Clearing a cell of a tile that was never stored changes nothing
+    TrackTile *tile = symbol == EMPTY ? find_tile(track, x, y) : insert_tile(track, x, y);
+    if (!tile) return;
+    int code = symbol == TRACK ? CODE_TRACK : symbol == START_FINISH ? CODE_START_FINISH : CODE_EMPTY;
+    size_t index = blocked_index(x & (TRACK_TILE_SIZE - 1), y & (TRACK_TILE_SIZE - 1), TRACK_TILE_SIZE / TRACK_BLOCK_SIZE);
+    int shift = (index & 3) * 2;
+    tile->cells[index >> 2] = (uint8_t) ((tile->cells[index >> 2] & ~(3 << shift)) | (code << shift));
+    symbol = track_cell(x, y);
+#else
+    track->cells[dense_index(track, x, y)] = symbol;
+#endif
+
+    track->on_track += (symbol != EMPTY) - (previous != EMPTY);
+    track->hash_valid = false;
+}
+
+/**
+ * @brief Gets the number of columns of the current track.
+ *
+ * @return int Width in cells.
+ */
+int track_width() {
+    return current_track->width;
+}
+
+/**
+ * @brief Gets the number of rows of the current track.
+ *
+ * @return int Height in cells.
+ */
+int track_height() {
+    return current_track->height;
+}
+
+/**
+ * @brief Counts the cells of the current track that are not EMPTY.
+ *
+ * Every MapPoint lies on such a cell, so this bounds the size of the map.
+ *
+ * @return long Number of TRACK and START_FINISH cells.
+ */
+long track_cells_on_track() {
+    return current_track->on_track;
+}
+
+/**
+ * @brief Computes the memory held by the current track.
+ *
+ * @return size_t Bytes of the track, its cells and, for a sparse track, its tile table.
+ */
+size_t track_memory_bytes() {
+    const TrackGrid *track = current_track;
+#ifdef SPARSE_TRACK
+    return sizeof(TrackGrid) + track->tile_capacity * sizeof(TrackTile *) + track->tile_count * sizeof(TrackTile);
+#else
+    return sizeof(TrackGrid) + dense_cell_count(track->width, track->height);
+#endif
+}
+
+/**
+ * @brief Computes the FNV-1a hash of the current track, row by row.
+ *
+ * The hash is cached until a cell changes, so checkpoints of large tracks stay cheap.
+ *
+ * @return uint64_t Hash identifying the track layout.
+ */
+uint64_t track_grid_hash() {
+    TrackGrid *track = current_track;
+    if (track->hash_valid) return track->hash;
+
+    uint64_t hash = 14695981039346656037ULL;
+    for (int i = 0; i < track->height; i++) {
+        for (int j = 0; j < track->width; j++) {
+            hash ^= (unsigned char) track_cell(j, i);
+            hash *= 1099511628211ULL;
+        }
+    }
+    track->hash = hash;
+    track->hash_valid = true;
+    return hash;
+}
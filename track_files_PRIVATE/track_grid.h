@@ -0,0 +1,75 @@
+#ifndef TRACK_GRID_H
+#define TRACK_GRID_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// ======================= TRACK STORAGE ======================= //
+//
+// Sensors, movement, rendering, hashing and recordings read the track only through
+// track_cell(). By default a track is a dense array of one symbol per cell. With
+// SPARSE_TRACK defined, it is a hash map of 64 x 64 tiles holding two bits per cell, and
+// tiles without any track cell are never stored: a 1 KB tile is only paid for where the
+// track passes, so a 65536 x 65536 track costs memory in proportion to its length.
+//
+// Both store cells in 8 x 8 blocks, one after the other along the rows of blocks. A dense
+// block is one 64-byte cache line, so the four neighbours a sensor probes usually share the
+// line of the car's cell, whichever way the car drives on a wide track. TRACK_ROW_MAJOR
+// restores the plain row-major dense array for comparison (tools/track_bench.c).
+
+#if defined(SPARSE_TRACK) && defined(STATIC_POOLS)
+#error "SPARSE_TRACK allocates tiles on the heap and cannot be combined with STATIC_POOLS"
+#endif
+
+#define TRACK_TILE_SHIFT 6                              // 64 x 64 cells per tile
+#define TRACK_TILE_SIZE  (1 << TRACK_TILE_SHIFT)
+#define TRACK_BLOCK_SHIFT 3                             // 8 x 8 cells per block
+#define TRACK_BLOCK_SIZE  (1 << TRACK_BLOCK_SHIFT)
+
+/**
+ * @struct TrackTile
+ * @brief 64 x 64 cells of a sparse track, two bits per cell.
+ */
+typedef struct TrackTile {
+    uint32_t tile_x, tile_y;
+    uint8_t cells[TRACK_TILE_SIZE * TRACK_TILE_SIZE / 4];
+} TrackTile;
+
+/**
+ * @struct TrackGrid
+ * @brief Width x height cells of a track, each EMPTY, TRACK or START_FINISH.
+ */
+typedef struct TrackGrid {
+    int width, height;
+    long on_track;              /**< Cells that are not EMPTY */
+#ifdef SPARSE_TRACK
+    TrackTile **tiles;          /**< Open-addressing table, NULL slots are free */
+    size_t tile_capacity;       /**< Power of two */
+    size_t tile_count;
+#else
+    char *cells;                /**< Rows of 8 x 8 blocks, or row-major with TRACK_ROW_MAJOR */
+#endif
+    uint64_t hash;              /**< Cached track_grid_hash(), valid if hash_valid */
+    bool hash_valid;
+} TrackGrid;
+
+// Track the car drives on; simulations swap in their own
+extern TrackGrid *current_track;
+
+TrackGrid *track_create(int width, int height);
+void track_free(TrackGrid *track);
+
+// Symbol of a cell of the current track, EMPTY outside of it
+char track_cell(int x, int y);
+void track_set_cell(int x, int y, char symbol);
+
+int track_width();
+int track_height();
+long track_cells_on_track();
+size_t track_memory_bytes();
+
+// Hash identifying the track layout a map belongs to
+uint64_t track_grid_hash();
+
+#endif // TRACK_GRID_H
@@ -3,14 +3,33 @@
 #include <unistd.h> // For usleep (smooth screen updates)
 #include "track_navigation.h"
 #include "../direction.h"
+#include "../instrumentation.h"
+#include "../noise.h"
+
+#define RENDER_VIEW_SIZE 40  // Larger tracks are drawn as a window of this many cells around the car
+
+/**
+ * @brief Computes the first cell of a rendered window along one axis.
+ *
+ * @param car Coordinate of the car.
+ * @param size Number of cells of the track along the axis.
+ * @return int First cell, so the window is centered on the car but stays on the track.
+ */
+static int view_origin(int car, int size) {
+    int origin = car - RENDER_VIEW_SIZE / 2;
+    if (origin > size - RENDER_VIEW_SIZE) origin = size - RENDER_VIEW_SIZE;
+    return origin < 0 ? 0 : origin;
+}
 
 /**
  * @brief Prints the grid with the car's current position and orientation.
  *
  * This function clears the screen and redraws the grid with the car's location,
- * showing its current direction.
+ * showing its current direction. Tracks larger than RENDER_VIEW_SIZE are drawn
+ * around the car only.
  */
 void print_grid() {
+    INSTRUMENT_PHASE(TIMER_RENDERING);
     // Clear screen properly
 #ifdef _WIN32
     system("cls");
@@ -18,12 +37,17 @@ void print_grid() {
     printf("\033[H\033[J"); // ANSI escape code for clearing screen (Linux/macOS)
 #endif
 
-    for (int i = 0; i < GRID_SIZE; i++) {
-        for (int j = 0; j < GRID_SIZE; j++) {
+    int top = view_origin(current_car.current_location.y, track_height());
+    int left = view_origin(current_car.current_location.x, track_width());
+    int bottom = top + RENDER_VIEW_SIZE < track_height() ? top + RENDER_VIEW_SIZE : track_height();
+    int right = left + RENDER_VIEW_SIZE < track_width() ? left + RENDER_VIEW_SIZE : track_width();
+
+    for (int i = top; i < bottom; i++) {
+        for (int j = left; j < right; j++) {
             if (i == current_car.current_location.y && j == current_car.current_location.x) {
                 printf("%c ", direction_to_symbol(current_car.current_orientation));  // Show car's direction
             } else {
-                printf("%c ", grid[i][j]);
+                printf("%c ", track_cell(j, i));
             }
         }
         printf("\n");
@@ -37,6 +61,7 @@ void print_grid() {
  * @brief Rotates the car 90 degrees counterclockwise.
  */
 void rotate_left() {
+    if (noise_enabled && noise_missed_move()) return;  // The motor under-rotated (see noise.h)
     current_car.current_orientation = turn_left(current_car.current_orientation);
 }
 
@@ -44,6 +69,7 @@ void rotate_left() {
  * @brief Rotates the car 90 degrees clockwise.
  */
 void rotate_right() {
+    if (noise_enabled && noise_missed_move()) return;  // The motor under-rotated (see noise.h)
     current_car.current_orientation = turn_right(current_car.current_orientation);
 }
 
@@ -54,6 +80,8 @@ void rotate_right() {
  * and moves it only if the next position is a valid track or the start/finish line.
  */
 void move_forward() {
+    if (noise_enabled && noise_missed_move()) return;  // The wheels slipped (see noise.h)
+
     int new_x = current_car.current_location.x;
     int new_y = current_car.current_location.y;
 
@@ -63,13 +91,13 @@ void move_forward() {
             if (new_y > 0) new_y -= 1;
             break;
         case SOUTH:
-            if (new_y < GRID_SIZE - 1) new_y += 1;
+            if (new_y < track_height() - 1) new_y += 1;
             break;
         case WEST:
             if (new_x > 0) new_x -= 1;
             break;
         case EAST:
-            if (new_x < GRID_SIZE - 1) new_x += 1;
+            if (new_x < track_width() - 1) new_x += 1;
             break;
         default:
             fprintf(stderr, "Warning: Invalid car orientation detected. Unable to move forward.\n");
@@ -77,7 +105,8 @@ void move_forward() {
     }
 
     // Only move if the next position is part of the track
-    if (grid[new_y][new_x] == TRACK || grid[new_y][new_x] == START_FINISH) {
+    char cell = track_cell(new_x, new_y);
+    if (cell == TRACK || cell == START_FINISH) {
         current_car.current_location.x = new_x;
         current_car.current_location.y = new_y;
     }